@@ -0,0 +1,203 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/**
+ * Scaling benchmark of the gateway event handling. One thread posts member updates of many guilds to the event dispatcher, like the socket thread does,
+ * and the workers apply them to the member map of their guild and look up the user in the shared user registry.
+ * 
+ * The run is repeated with 1 to 32 workers, the speedup is relative to one worker.
+ * 
+ * Usage: DispatchScalingBench [guilds] [members per guild] [events] [max workers]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <models/snapshot_map.hpp>
+#include <models/weak_registry.hpp>
+#include <helpers/Helper.hpp>
+#include <controller/EventDispatcher.hpp>
+
+using namespace DiscordBot;
+
+namespace
+{
+    struct SMember
+    {
+        uint64_t UserID;
+        std::string Nick;
+    };
+
+    using Member = std::shared_ptr<const SMember>;
+    using Members = snapshot_map<snowflake, Member>;
+
+    class CGuilds
+    {
+        public:
+            CGuilds(size_t Guilds, size_t MembersPerGuild) : m_Guilds(Guilds)
+            {
+                for (size_t i = 0; i < Guilds; i++)
+                {
+                    m_Guilds[i].update([i, MembersPerGuild, this](persistent_map<snowflake, Member> &Map)
+                    {
+                        for (size_t j = 0; j < MembersPerGuild; j++)
+                        {
+                            auto Tmp = std::make_shared<SMember>();
+                            Tmp->UserID = UserID(i, j);
+                            Map[snowflake(Tmp->UserID)] = Tmp;
+
+                            auto User = std::make_shared<const uint64_t>(Tmp->UserID);
+                            m_Users.insert(snowflake(Tmp->UserID), User);
+                            m_Owners.push_back(User);
+                        }
+                    });
+                }
+            }
+
+            static inline uint64_t GuildID(size_t Guild)
+            {
+                //Discord ids start with a timestamp, so they are spread over the whole 64 bits.
+                return ((uint64_t)(Guild + 1) << 22) * 104729ULL;
+            }
+
+            static inline size_t GuildIndex(snowflake ID)
+            {
+                return (size_t)(ID.value() / GuildID(0)) - 1;
+            }
+
+            static inline uint64_t UserID(size_t Guild, size_t Member)
+            {
+                return ((uint64_t)(Guild * 100003 + Member + 1) << 22) * 7919ULL;
+            }
+
+            /**
+             * @brief Handler of the workers. Scans the payload like the client scans the dispatch key and replaces the member.
+             */
+            void Handle(const SPayload &Pay)
+            {
+                snowflake GuildID(FindTopLevelString(Pay.D, "guild_id"));
+                snowflake UserID(FindTopLevelString(Pay.D, "user_id"));
+                std::string Nick = FindTopLevelString(Pay.D, "nick");
+
+                Members &Guild = m_Guilds[GuildIndex(GuildID)];
+                if(!m_Users.get(UserID))
+                    return;
+
+                Guild.update([&UserID, &Nick](persistent_map<snowflake, Member> &Map)
+                {
+                    auto IT = Map.find(UserID);
+                    if(IT == Map.end())
+                        return;
+
+                    auto Copy = std::make_shared<SMember>(*IT->second);
+                    Copy->Nick = std::move(Nick);
+                    IT->second = Copy;
+                });
+            }
+
+        private:
+            std::vector<Members> m_Guilds;
+            weak_registry<snowflake, const uint64_t> m_Users;
+            std::vector<std::shared_ptr<const uint64_t>> m_Owners;
+    };
+
+    std::vector<SPayload> MakeEvents(size_t Guilds, size_t MembersPerGuild, size_t Count)
+    {
+        std::mt19937_64 Rng(1);
+        std::vector<SPayload> Ret(Count);
+        for (auto &&e : Ret)
+        {
+            size_t Guild = Rng() % Guilds;
+            size_t Member = Rng() % MembersPerGuild;
+
+            e.OP = 0;
+            e.S = 0;
+            e.T = "GUILD_MEMBER_UPDATE";
+            e.D = "{\"roles\":[\"" + std::to_string(CGuilds::GuildID(Guild)) + "\"],\"user\":{\"id\":\"" + std::to_string(CGuilds::UserID(Guild, Member)) + "\",\"username\":\"user\"},"
+                  "\"user_id\":\"" + std::to_string(CGuilds::UserID(Guild, Member)) + "\",\"nick\":\"nick " + std::to_string(Rng() % 1000) + "\",\"guild_id\":\"" + std::to_string(CGuilds::GuildID(Guild)) + "\"}";
+        }
+
+        return Ret;
+    }
+
+    /**
+     * @return Returns the handled events per second.
+     */
+    double Run(size_t Guilds, size_t MembersPerGuild, const std::vector<SPayload> &Events, size_t Workers)
+    {
+        CGuilds Cache(Guilds, MembersPerGuild);
+        CEventDispatcher Dispatcher;
+        Dispatcher.Start(Workers, [&Cache](const SPayload &Pay)
+        {
+            Cache.Handle(Pay);
+        });
+
+        auto Start = std::chrono::steady_clock::now();
+        for (auto &&e : Events)
+            Dispatcher.Post(snowflake(FindTopLevelString(e.D, "guild_id")), e);
+
+        Dispatcher.Wait();
+        double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        Dispatcher.Stop();
+
+        return Events.size() / Seconds;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t Guilds = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 256;
+    size_t MembersPerGuild = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : 1000;
+    size_t Count = argc > 3 ? (size_t)strtoull(argv[3], nullptr, 10) : 500000;
+    size_t MaxWorkers = argc > 4 ? (size_t)strtoull(argv[4], nullptr, 10) : 32;
+
+    if(Guilds == 0)
+        Guilds = 1;
+
+    if(MembersPerGuild == 0)
+        MembersPerGuild = 1;
+
+    auto Events = MakeEvents(Guilds, MembersPerGuild, Count);
+    printf("%zu guilds, %zu members per guild, %zu events, %u hardware threads\n\n", Guilds, MembersPerGuild, Count, std::thread::hardware_concurrency());
+    printf("%8s %16s %10s\n", "workers", "events/s", "speedup");
+
+    double Base = 0;
+    for (size_t Workers = 1; Workers <= MaxWorkers; Workers *= 2)
+    {
+        double Rate = Run(Guilds, MembersPerGuild, Events, Workers);
+        if(Workers == 1)
+            Base = Rate;
+
+        printf("%8zu %16.0f %9.2fx\n", Workers, Rate, Rate / Base);
+    }
+
+    return 0;
+}
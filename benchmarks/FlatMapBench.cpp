@@ -0,0 +1,204 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * Benchmark of the cache tables. Compares flat_map with the node based std::map of the old caches, std::unordered_map and persistent_map.
+ * Measures inserts, lookups of existing and missing ids and the bytes per entry. The values are shared pointers like the cached entities.
+ * 
+ * Usage: FlatMapBench [entries...]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <models/flat_map.hpp>
+#include <models/persistent_map.hpp>
+#include <models/snowflake.hpp>
+
+using namespace DiscordBot;
+
+namespace
+{
+    using Value = std::shared_ptr<const int>;
+
+    size_t g_Allocated = 0;     //!< Bytes currently allocated by CCountingAllocator.
+
+    /**
+     * @brief Counts the heap usage of the node based maps.
+     */
+    template<class T>
+    class CCountingAllocator
+    {
+        public:
+            using value_type = T;
+
+            CCountingAllocator() {}
+
+            template<class U>
+            CCountingAllocator(const CCountingAllocator<U> &) {}
+
+            T *allocate(size_t n)
+            {
+                g_Allocated += n * sizeof(T);
+                return std::allocator<T>().allocate(n);
+            }
+
+            void deallocate(T *p, size_t n)
+            {
+                g_Allocated -= n * sizeof(T);
+                std::allocator<T>().deallocate(p, n);
+            }
+
+            template<class U>
+            bool operator==(const CCountingAllocator<U> &) const
+            {
+                return true;
+            }
+
+            template<class U>
+            bool operator!=(const CCountingAllocator<U> &) const
+            {
+                return false;
+            }
+    };
+
+    using StdMap = std::map<snowflake, Value, std::less<snowflake>, CCountingAllocator<std::pair<const snowflake, Value>>>;
+    using UnorderedMap = std::unordered_map<snowflake, Value, std::hash<snowflake>, std::equal_to<snowflake>, CCountingAllocator<std::pair<const snowflake, Value>>>;
+
+    template<class Map>
+    size_t MemoryUsage(const Map &)
+    {
+        return g_Allocated;
+    }
+
+    size_t MemoryUsage(const flat_map<snowflake, Value> &Map)
+    {
+        return Map.memory_usage();
+    }
+
+    size_t MemoryUsage(const persistent_map<snowflake, Value> &Map)
+    {
+        return Map.memory_usage();
+    }
+
+    /**
+     * @return Returns ids like Discord creates them, a timestamp in the upper bits and a counter in the lower bits.
+     */
+    /**
+     * @param Time: Timestamp of the first id. Ids of different bases don't collide, as long as the bases are more than Count * 1000 apart.
+     */
+    std::vector<snowflake> MakeIDs(size_t Count, uint64_t Time, uint64_t Seed)
+    {
+        std::mt19937_64 Rng(Seed);
+        std::vector<snowflake> Ret;
+        Ret.reserve(Count);
+
+        for (size_t i = 0; i < Count; i++)
+        {
+            Time += Rng() % 1000;
+            Ret.push_back(snowflake((Time << 22) | (Rng() & 0xFFF)));
+        }
+
+        std::shuffle(Ret.begin(), Ret.end(), Rng);
+        return Ret;
+    }
+
+    template<class F>
+    double NanosecondsPerOp(size_t Ops, F f)
+    {
+        auto Start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Ops;
+    }
+
+    template<class Map>
+    void Run(const char *Name, const std::vector<snowflake> &IDs, const std::vector<snowflake> &Missing)
+    {
+        Value Val = std::make_shared<const int>(0);
+        size_t Found = 0;
+
+        {
+            g_Allocated = 0;
+            Map map;
+
+            double Insert = NanosecondsPerOp(IDs.size(), [&]()
+            {
+                for (auto &&e : IDs)
+                    map.insert({e, Val});
+            });
+
+            size_t Bytes = MemoryUsage(map);
+
+            double Hit = NanosecondsPerOp(IDs.size(), [&]()
+            {
+                for (auto &&e : IDs)
+                    Found += map.find(e) != map.end() ? 1 : 0;
+            });
+
+            double Miss = NanosecondsPerOp(Missing.size(), [&]()
+            {
+                for (auto &&e : Missing)
+                    Found += map.find(e) != map.end() ? 1 : 0;
+            });
+
+            printf("%-16s %10zu %12.1f %12.1f %12.1f %14.1f\n", Name, IDs.size(), Insert, Hit, Miss, (double)Bytes / IDs.size());
+        }
+
+        if(Found != IDs.size())
+            printf("  unexpected number of found ids: %zu\n", Found);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> Sizes;
+    for (int i = 1; i < argc; i++)
+        Sizes.push_back((size_t)strtoull(argv[i], nullptr, 10));
+
+    if(Sizes.empty())
+        Sizes = {1000, 100000, 1000000};
+
+    printf("%-16s %10s %12s %12s %12s %14s\n", "map", "entries", "insert ns", "hit ns", "miss ns", "bytes/entry");
+    for (auto &&Size : Sizes)
+    {
+        //The missing ids are newer than all existing ids.
+        auto IDs = MakeIDs(Size, 1ULL << 40, 1);
+        auto Missing = MakeIDs(Size, 1ULL << 41, 2);
+
+        Run<StdMap>("std::map", IDs, Missing);
+        Run<UnorderedMap>("unordered_map", IDs, Missing);
+        Run<flat_map<snowflake, Value>>("flat_map", IDs, Missing);
+        Run<persistent_map<snowflake, Value>>("persistent_map", IDs, Missing);
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * Memory benchmark of the compact entity layout. Builds the same members once with the old layout, where every field was a std::string,
+ * and once with the cached classes, which intern locales, store timestamps as integers, avatar hashes as 16 bytes and flags as bit fields.
+ * 
+ * Also shows why user chosen names aren't interned: the pool keeps every distinct name until the end of the process.
+ * 
+ * Usage: MemberMemoryBench [members]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <models/User.hpp>
+#include <models/Role.hpp>
+#include <models/GuildMember.hpp>
+#include <models/interned_string.hpp>
+
+using namespace DiscordBot;
+
+namespace
+{
+    const size_t HEADER_SIZE = 16;  //!< Keeps the alignment of the allocations.
+    size_t g_Allocated = 0;         //!< Bytes currently allocated with operator new.
+
+    //Old layout of the entities, every field as it was sent by Discord.
+    struct SLegacyUser
+    {
+        std::string ID;
+        std::string Username;
+        std::string Discriminator;
+        std::string Avatar;
+        std::string Locale;
+        std::string Email;
+        int Flags;
+        int PublicFlags;
+        bool Bot;
+        bool System;
+        bool MFAEnabled;
+        bool Verified;
+        int PremiumType;
+    };
+
+    struct SLegacyMember
+    {
+        std::string GuildID;
+        std::shared_ptr<SLegacyUser> UserRef;
+        std::string Nick;
+        std::vector<std::string> Roles;
+        std::string JoinedAt;
+        std::string PremiumSince;
+        bool Deaf;
+        bool Mute;
+        std::shared_ptr<void> State;
+    };
+
+    /**
+     * @brief Raw fields of a member, like they are received from Discord.
+     */
+    struct SMemberData
+    {
+        std::string ID;
+        std::string Username;
+        std::string Discriminator;
+        std::string Avatar;
+        std::string Locale;
+        std::string Nick;
+        std::vector<std::string> Roles;
+        std::string JoinedAt;
+        std::string PremiumSince;
+    };
+
+    std::string RandomString(std::mt19937_64 &Rng, const char *Chars, size_t Len)
+    {
+        size_t Count = strlen(Chars);
+        std::string Ret(Len, ' ');
+        for (auto &&c : Ret)
+            c = Chars[Rng() % Count];
+
+        return Ret;
+    }
+
+    std::vector<SMemberData> MakeMembers(size_t Count)
+    {
+        static const char *LOCALES[] = {"en-US", "en-GB", "de", "fr", "pt-BR", "es-ES", "ru", "pl", "tr", "ja"};
+        static const char *DIGITS = "0123456789";
+        static const char *HEX = "0123456789abcdef";
+        static const char *LETTERS = "abcdefghijklmnopqrstuvwxyz_0123456789";
+
+        std::mt19937_64 Rng(1);
+        std::vector<std::string> RoleIDs;
+        for (size_t i = 0; i < 20; i++)
+            RoleIDs.push_back(RandomString(Rng, DIGITS, 18));
+
+        std::vector<SMemberData> Ret(Count);
+        for (auto &&e : Ret)
+        {
+            e.ID = RandomString(Rng, DIGITS, 18);
+            e.Username = RandomString(Rng, LETTERS, 6 + Rng() % 11);
+            e.Discriminator = RandomString(Rng, DIGITS, 4);
+            e.Avatar = Rng() % 4 == 0 ? "" : RandomString(Rng, HEX, 32);
+            e.Locale = LOCALES[Rng() % 10];
+            e.Nick = Rng() % 3 == 0 ? RandomString(Rng, LETTERS, 6 + Rng() % 20) : "";
+
+            size_t Roles = Rng() % 5;
+            for (size_t i = 0; i < Roles; i++)
+                e.Roles.push_back(RoleIDs[Rng() % RoleIDs.size()]);
+
+            e.JoinedAt = "2021-0" + RandomString(Rng, "123456789", 1) + "-1" + RandomString(Rng, DIGITS, 1) + "T12:34:56.789000+00:00";
+            e.PremiumSince = Rng() % 20 == 0 ? "2021-05-01T10:00:00.000000+00:00" : "";
+        }
+
+        return Ret;
+    }
+
+    /**
+     * @return Parses the date part of an ISO 8601 timestamp. Good enough to fill the benchmark entities.
+     */
+    int64_t ToMillis(const std::string &Str)
+    {
+        if(Str.size() < 10)
+            return 0;
+
+        int64_t Days = atoi(Str.substr(0, 4).c_str()) * 365 + atoi(Str.substr(5, 2).c_str()) * 31 + atoi(Str.substr(8, 2).c_str());
+        return Days * 86400000;
+    }
+
+    size_t MeasureLegacy(const std::vector<SMemberData> &Data)
+    {
+        std::vector<std::shared_ptr<SLegacyMember>> Members;
+        Members.reserve(Data.size());
+        size_t Reserved = g_Allocated;
+
+        for (auto &&e : Data)
+        {
+            auto Usr = std::make_shared<SLegacyUser>();
+            Usr->ID = e.ID;
+            Usr->Username = e.Username;
+            Usr->Discriminator = e.Discriminator;
+            Usr->Avatar = e.Avatar;
+            Usr->Locale = e.Locale;
+
+            auto Member = std::make_shared<SLegacyMember>();
+            Member->GuildID = "81384788765712384";
+            Member->UserRef = Usr;
+            Member->Nick = e.Nick;
+            Member->Roles = e.Roles;
+            Member->JoinedAt = e.JoinedAt;
+            Member->PremiumSince = e.PremiumSince;
+            Members.push_back(Member);
+        }
+
+        return g_Allocated - Reserved;
+    }
+
+    size_t MeasureCompact(const std::vector<SMemberData> &Data)
+    {
+        std::vector<GuildMember> Members;
+        Members.reserve(Data.size());
+        size_t Reserved = g_Allocated;
+
+        for (auto &&e : Data)
+        {
+            auto Usr = std::make_shared<CUser>();
+            Usr->ID = snowflake(e.ID);
+            Usr->Username = e.Username;
+            Usr->Discriminator = e.Discriminator;
+            Usr->Avatar = e.Avatar;
+            Usr->Locale = e.Locale;
+
+            auto Member = std::make_shared<CGuildMember>();
+            Member->GuildID = snowflake(81384788765712384ULL);
+            Member->UserRef = Usr;
+            Member->Nick = e.Nick;
+            Member->Roles.reserve(e.Roles.size());
+            for (auto &&r : e.Roles)
+                Member->Roles.push_back(snowflake(r));
+
+            Member->JoinedAt = ToMillis(e.JoinedAt);
+            Member->PremiumSince = ToMillis(e.PremiumSince);
+            Members.push_back(Member);
+        }
+
+        return g_Allocated - Reserved;
+    }
+
+    /**
+     * @return Returns the bytes, which the string pool keeps after roles with distinct names were created and released.
+     */
+    size_t MeasureInternedNames(size_t Count)
+    {
+        std::mt19937_64 Rng(2);
+        size_t Before = string_pool::instance().memory_usage();
+        {
+            std::vector<interned_string> Names;
+            for (size_t i = 0; i < Count; i++)
+                Names.push_back(RandomString(Rng, "abcdefghijklmnopqrstuvwxyz ", 8 + Rng() % 24));
+        }
+
+        return string_pool::instance().memory_usage() - Before;
+    }
+} // namespace
+
+void *operator new(size_t Size)
+{
+    void *Ptr = malloc(Size + HEADER_SIZE);
+    if(!Ptr)
+        throw std::bad_alloc();
+
+    *(size_t*)Ptr = Size;
+    g_Allocated += Size;
+    return (char*)Ptr + HEADER_SIZE;
+}
+
+void operator delete(void *Ptr) noexcept
+{
+    if(!Ptr)
+        return;
+
+    char *Block = (char*)Ptr - HEADER_SIZE;
+    g_Allocated -= *(size_t*)Block;
+    free(Block);
+}
+
+void operator delete(void *Ptr, size_t) noexcept
+{
+    operator delete(Ptr);
+}
+
+int main(int argc, char **argv)
+{
+    size_t Count = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 100000;
+    if(Count == 0)
+        Count = 1;
+
+    auto Data = MakeMembers(Count);
+
+    //Warms up the pool, the locales are shared by all members.
+    MeasureCompact(Data);
+
+    double Legacy = (double)MeasureLegacy(Data) / Count;
+    double Compact = (double)MeasureCompact(Data) / Count;
+
+    printf("%zu members with their users\n\n", Count);
+    printf("%-24s %14s\n", "layout", "bytes/member");
+    printf("%-24s %14.1f\n", "strings", Legacy);
+    printf("%-24s %14.1f\n", "compact", Compact);
+    printf("\nsaved %.1f bytes per member (%.1f%%), %.1f MiB for all members\n", Legacy - Compact, (Legacy - Compact) * 100.0 / Legacy, (Legacy - Compact) * Count / (1024.0 * 1024.0));
+
+    printf("\nstring pool after %zu released roles with distinct names: %zu bytes, which are never freed\n", Count, MeasureInternedNames(Count));
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * Contention benchmark of the entity caches. Compares the old cache, a std::map behind the recursive mutex of DiscordBot::atomic,
+ * with snapshot_map on a flat_map, which copies the whole map per write, and snapshot_map on a persistent_map, which copies the path to the key.
+ * 
+ * Reader threads look up random keys, while one writer thread replaces random values, like the gateway thread does.
+ * 
+ * Usage: SnapshotMapBench [entries] [max readers] [milliseconds per run]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <models/atomic.hpp>
+#include <models/flat_map.hpp>
+#include <models/snapshot_map.hpp>
+
+using namespace DiscordBot;
+
+namespace
+{
+    using Value = std::shared_ptr<const uint64_t>;
+
+    struct SResult
+    {
+        double Reads;       //!< Reads per second over all readers.
+        double Writes;      //!< Writes per second.
+    };
+
+    class CLockedMap
+    {
+        public:
+            void Fill(size_t Entries)
+            {
+                for (size_t i = 0; i < Entries; i++)
+                    m_Map->insert({i, std::make_shared<const uint64_t>(i)});
+            }
+
+            Value Get(uint64_t Key)
+            {
+                //Same access pattern as the old caches: find and copy under the recursive lock.
+                auto IT = m_Map->find(Key);
+                return IT == m_Map->end() ? Value() : IT->second;
+            }
+
+            void Set(uint64_t Key, const Value &Val)
+            {
+                m_Map->operator[](Key) = Val;
+            }
+
+        private:
+            DiscordBot::atomic<std::map<uint64_t, Value>> m_Map;
+    };
+
+    template<class Map>
+    class CSnapshotMap
+    {
+        public:
+            void Fill(size_t Entries)
+            {
+                m_Map.update([Entries](Map &Values)
+                {
+                    for (size_t i = 0; i < Entries; i++)
+                        Values[i] = std::make_shared<const uint64_t>(i);
+                });
+            }
+
+            Value Get(uint64_t Key)
+            {
+                return m_Map.get(Key);
+            }
+
+            void Set(uint64_t Key, const Value &Val)
+            {
+                m_Map.set(Key, Val);
+            }
+
+        private:
+            snapshot_map<uint64_t, Value, Map> m_Map;
+    };
+
+    template<class Cache>
+    SResult Run(size_t Entries, size_t Readers, int Milliseconds)
+    {
+        Cache cache;
+        cache.Fill(Entries);
+
+        std::atomic<bool> Stop(false);
+        std::atomic<uint64_t> Reads(0);
+        uint64_t Writes = 0;
+
+        std::vector<std::thread> Threads;
+        for (size_t i = 0; i < Readers; i++)
+        {
+            Threads.emplace_back([&cache, &Stop, &Reads, Entries, i]()
+            {
+                std::mt19937_64 Rng(i + 1);
+                uint64_t Count = 0, Sum = 0;
+                while (!Stop)
+                {
+                    Value Val = cache.Get(Rng() % Entries);
+                    Sum += Val ? *Val : 0;
+                    Count++;
+                }
+
+                Reads += Count + (Sum == 1 ? 1 : 0);
+            });
+        }
+
+        std::thread Writer([&cache, &Stop, &Writes, Entries]()
+        {
+            std::mt19937_64 Rng(0);
+            while (!Stop)
+            {
+                uint64_t Key = Rng() % Entries;
+                cache.Set(Key, std::make_shared<const uint64_t>(Key));
+                Writes++;
+            }
+        });
+
+        auto Start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(Milliseconds));
+        Stop = true;
+
+        for (auto &&t : Threads)
+            t.join();
+
+        Writer.join();
+        double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+        return {Reads / Seconds, Writes / Seconds};
+    }
+
+    void Print(const char *Name, size_t Readers, const SResult &Res)
+    {
+        printf("%-28s %8zu %16.0f %14.0f\n", Name, Readers, Res.Reads, Res.Writes);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t Entries = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 100000;
+    size_t MaxReaders = argc > 2 ? (size_t)strtoull(argv[2], nullptr, 10) : 8;
+    int Milliseconds = argc > 3 ? atoi(argv[3]) : 1000;
+
+    if(Entries == 0)
+        Entries = 1;
+
+    printf("%zu entries, 1 writer, %d ms per run\n\n", Entries, Milliseconds);
+    printf("%-28s %8s %16s %14s\n", "map", "readers", "reads/s", "writes/s");
+
+    for (size_t Readers = 1; Readers <= MaxReaders; Readers *= 2)
+    {
+        Print("atomic<std::map>", Readers, Run<CLockedMap>(Entries, Readers, Milliseconds));
+        Print("snapshot_map<flat_map>", Readers, Run<CSnapshotMap<flat_map<uint64_t, Value>>>(Entries, Readers, Milliseconds));
+        Print("snapshot_map<persistent_map>", Readers, Run<CSnapshotMap<persistent_map<uint64_t, Value>>>(Entries, Readers, Milliseconds));
+    }
+
+    return 0;
+}
@@ -26,6 +26,9 @@
 #define IDISCORDCLIENT_HPP
 
 #include <memory>
+#include <functional>
+#include <models/persistent_map.hpp>
+#include <models/weak_registry.hpp>
 #include <controller/IController.hpp>
 #include <controller/IAudioSource.hpp>
 #include <models/Embed.hpp>
@@ -34,13 +37,26 @@
 #include <config.h>
 #include <models/OnlineState.hpp>
 #include <controller/IGuildAdmin.hpp>
+#include <models/RetryPolicy.hpp>
+#include <models/RequestPriority.hpp>
+#include <models/RESTStatistics.hpp>
+#include <models/Webhook.hpp>
+#include <models/CachePolicy.hpp>
+#include <models/Presence.hpp>
+#include <models/CacheStatistics.hpp>
+#include <controller/IRESTProxy.hpp>
 
 namespace DiscordBot
 {
     class IDiscordClient;
     using DiscordClient = std::shared_ptr<IDiscordClient>;
-    using Users = std::map<std::string, User>;
-    using Guilds = std::map<std::string, Guild>;
+    using Users = persistent_map<snowflake, User>;
+    using Guilds = persistent_map<snowflake, Guild>;
+    using UsersSnapshot = std::shared_ptr<const weak_registry<snowflake, const CUser>::snapshot>;
+    using GuildsSnapshot = std::shared_ptr<const Guilds>;
+    using GuildVisitor = std::function<bool(const Guild&)>;
+    using MemberVisitor = std::function<bool(const GuildMember&)>;
+    using UserVisitor = std::function<bool(const User&)>;
 
     //Discord Gateway intents https://discordapp.com/developers/docs/topics/gateway#gateway-intents
     enum class Intent
@@ -274,6 +290,36 @@ namespace DiscordBot
              */
             virtual void SendMessage(User user, const std::string Text, Embed embed = nullptr, bool TTS = false) = 0;
 
+            /**
+             * @brief Sends files with an optional message to a given channel. Discord allows up to 10 files with 8 MiB in total per message.
+             * 
+             * @param channel: Text channel which will receive the files.
+             * @param Files: Paths of the files to upload.
+             * @param Text: Text to send.
+             */
+            virtual void SendFiles(Channel channel, const std::vector<std::string> &Files, const std::string Text = "", Embed embed = nullptr) = 0;
+
+            /**
+             * @brief Gets the webhook of the bot for a text channel. The webhook is created, if the channel has none with the given name. Needs the "MANAGE_WEBHOOKS" permission.
+             * 
+             * @param channel: Guild text or news channel.
+             * @param Name: Name of the webhook.
+             * 
+             * @return Returns the webhook or null on error.
+             */
+            virtual Webhook GetWebhook(Channel channel, const std::string &Name = "libDiscordBot") = 0;
+
+            /**
+             * @brief Sends a message through a webhook without waiting for the created message. Webhooks have their own rate limits and connections, so use them for logs and announcements.
+             * 
+             * @param webhook: Webhook to execute. @see GetWebhook
+             * @param Text: Text to send.
+             * @param Username: Overrides the name of the webhook for this message.
+             * @param AvatarURL: Overrides the avatar of the webhook for this message.
+             * @param TTS: True to enable tts.
+             */
+            virtual void ExecuteWebhook(Webhook webhook, const std::string &Text, Embed embed = nullptr, const std::string &Username = "", const std::string &AvatarURL = "", bool TTS = false) = 0;
+
             /**
              * @return Returns the audio source for the given guild. Null if there is no audio source available.
              */
@@ -315,14 +361,50 @@ namespace DiscordBot
             virtual GuildMember GetBotMember(Guild guild) = 0;
 
             /**
-             * @return Gets the list of all connected servers.
+             * @return Gets a member from the cache or requests it from discord, if the member isn't cached. Null if the user isn't a member of the guild.
+             */
+            virtual GuildMember GetMember(Guild guild, snowflake UserID) = 0;
+
+            /**
+             * @return Gets the online state and the activities of a user. The presence is offline, if it isn't known or not cached. @see CacheEntity::PRESENCES
+             * 
+             * @note The GUILD_PRESENCES intent needs to be set to receive presences.
+             */
+            virtual SPresence GetPresence(snowflake UserID) = 0;
+
+            /**
+             * @return Gets the list of all connected servers. The list shares its nodes with the cache, so the copy is cheap.
              */
             virtual Guilds GetGuilds() = 0;
 
+            /**
+             * @return Gets an immutable snapshot of all connected servers. Doesn't copy the list and doesn't block the cache updates.
+             */
+            virtual GuildsSnapshot GetGuildsSnapshot() = 0;
+
+            /**
+             * @brief Calls the visitor for every connected server. The walk uses a snapshot, so the cache can be updated in the meantime.
+             * 
+             * @param Visitor: Return false to stop the walk.
+             */
+            virtual void ForEachGuild(const GuildVisitor &Visitor) = 0;
+
+            /**
+             * @brief Calls the visitor for every cached member of a guild. The walk uses a snapshot, so the cache can be updated in the meantime.
+             * 
+             * @param Visitor: Return false to stop the walk.
+             */
+            virtual void ForEachMember(Guild guild, const MemberVisitor &Visitor) = 0;
+
+            /**
+             * @return Gets the number of cached members of a guild.
+             */
+            virtual size_t CountMembers(Guild guild) = 0;
+
             /**
              * @return Gets a guild object by its id or null.
              */
-            virtual Guild GetGuild(const std::string &GID) = 0;
+            virtual Guild GetGuild(snowflake GID) = 0;
 
             /**
              * @return Gets the administrator interface for a given guild. Or null if g is null.
@@ -330,10 +412,138 @@ namespace DiscordBot
             virtual GuildAdmin GetAdminInterface(Guild g) = 0;
 
             /**
-             * @return Gets a list of all users.
+             * @return Gets a list of all users, which are referenced by a member, the application or the user cache.
+             * 
+             * @note Copies the whole list. Use ForEachUser for frequent calls.
              */
             virtual Users GetUsers() = 0;
 
+            /**
+             * @return Gets an immutable snapshot of all users. The snapshot shares the shards of the user cache, so no user is copied. Users which are released meanwhile are skipped.
+             */
+            virtual UsersSnapshot GetUsersSnapshot() = 0;
+
+            /**
+             * @brief Calls the visitor for every cached user. The walk uses snapshots, so the cache can be updated in the meantime.
+             * 
+             * @param Visitor: Return false to stop the walk.
+             */
+            virtual void ForEachUser(const UserVisitor &Visitor) = 0;
+
+            /**
+             * @brief Sets the retry policy for all REST requests. Failed requests are retried with a jittered exponential backoff and idempotent GETs can be hedged. @see SRetryPolicy
+             */
+            virtual void SetRetryPolicy(const SRetryPolicy &Policy) = 0;
+
+            /**
+             * @brief Changes the url of the discord REST api. Use this to send all requests through a shared IRESTProxy. Webhooks are always executed directly.
+             * Requests to the new url are sent once without rate limiting, retries or hedging, because the proxy handles these.
+             * 
+             * @param URL: New base url. E.g. "http://127.0.0.1:8090"
+             */
+            virtual void SetBaseURL(const std::string &URL) = 0;
+
+            /**
+             * @brief Sets how long GET responses of a route are cached. Cached routes are also invalidated by the matching gateway events and by writes of the bot.
+             * 
+             * @param Route: Route with the major parameter replaced by ":major". E.g. "GET /guilds/:major/roles"
+             * @param TTL: Time to live in milliseconds. 0 disables the cache for the route.
+             */
+            virtual void SetRESTCacheTTL(const std::string &Route, uint32_t TTL) = 0;
+
+            /**
+             * @return Gets the latency statistics of the REST requests per priority class. Messages are sent as RequestPriority::INTERACTIVE, all other requests as RequestPriority::NORMAL. Use CRequestPriorityScope to change the class.
+             */
+            virtual SRESTStatistics GetRESTStatistics() = 0;
+
+            /**
+             * @brief Sets how long an entity is cached. By default everything except CacheEntity::USERS is cached until discord removes it. @see SCachePolicy
+             * 
+             * Switching to CacheMode::NONE removes the cached entries immediately.
+             */
+            virtual void SetCachePolicy(CacheEntity Entity, const SCachePolicy &Policy) = 0;
+
+            /**
+             * @return Gets the cache policy of an entity.
+             */
+            virtual SCachePolicy GetCachePolicy(CacheEntity Entity) = 0;
+
+            /**
+             * @return Gets the number of entries and the approximated memory usage of all caches. The values are calculated on each call by walking the caches, so call it from a timer or a command and not per event.
+             */
+            virtual SCacheStatistics GetCacheStatistics() = 0;
+
+            /**
+             * @brief Writes the cache statistics to the log.
+             * 
+             * @param TopGuilds: Number of guilds to list, the biggest first. The remaining guilds are summed up in one line.
+             */
+            virtual void DumpCacheStatistics(size_t TopGuilds = 10) = 0;
+
+            /**
+             * @brief Sets the file of the cache snapshot. Run() loads the guilds, roles, channels, members and users from this file before it connects, Quit() writes the caches back.
+             * 
+             * The loaded data is available immediately and is replaced by the GUILD_CREATE events. Guilds which the bot left while it was offline are removed after the READY event.
+             * Presences and voice states aren't stored.
+             */
+            virtual void SetCacheSnapshotFile(const std::string &Path) = 0;
+
+            /**
+             * @brief Writes the caches to a snapshot file. @see SetCacheSnapshotFile
+             * 
+             * @return Returns false if the file couldn't be written.
+             */
+            virtual bool SaveCacheSnapshot(const std::string &Path) = 0;
+
+            /**
+             * @brief Handles the gateway events on a pool of worker threads. Must be called before Run(). By default all events are handled on the websocket thread.
+             * 
+             * The events of one guild always run on the same worker in the order discord sent them, events of different guilds run in parallel.
+             * Events without a guild, e.g. direct messages, share one worker. READY and RESUMED wait until all workers are idle.
+             * 
+             * @attention The controller callbacks are called from multiple threads at the same time, so the controller must be thread safe.
+             * 
+             * @param Count: Number of worker threads. 0 handles the events on the websocket thread.
+             */
+            virtual void SetEventWorkers(size_t Count) = 0;
+
+            /**
+             * @return Gets the effective permissions of a member. Includes the @everyone role, the guild owner and ADMINISTRATOR. If a channel is given, the permission overwrites of the channel are applied.
+             * 
+             * The result is cached until a role of the guild, the channel or the member changes.
+             */
+            virtual Permission GetPermissions(Guild guild, GuildMember member, Channel channel = nullptr) = 0;
+
+            /**
+             * @return Returns true if the member has all given permissions. @see GetPermissions
+             */
+            virtual bool HasPermission(Guild guild, GuildMember member, Permission perm, Channel channel = nullptr) = 0;
+
+            /**
+             * @brief Keeps the recent messages of each channel. With the cache, IController::OnMessageEdited receives the cached message with the edit applied and IController::OnMessageDeleted the cached original. Disabled by default.
+             * 
+             * @param Depth: Messages per channel. 0 disables the cache. Changing the depth clears the cache.
+             * @param MaxBytes: Approximated heap budget of all messages. The oldest messages of the least active channels are dropped first. 0 for no budget.
+             */
+            virtual void SetMessageCache(size_t Depth, size_t MaxBytes = 0) = 0;
+
+            /**
+             * @return Gets a cached message or null. @see SetMessageCache
+             */
+            virtual Message GetCachedMessage(snowflake ChannelID, snowflake MessageID) = 0;
+
+            /**
+             * @return Gets the cached messages of a channel, the newest first. @see SetMessageCache
+             */
+            virtual std::vector<Message> GetCachedMessages(snowflake ChannelID) = 0;
+
+            /**
+             * @return Gets up to Limit cached members, whose username or nickname starts with the prefix, ordered by the matched name. The case is ignored.
+             * 
+             * The names are kept in a sorted index per guild, so a query doesn't walk the member list. Members which aren't cached can't be found. @see SetCachePolicy
+             */
+            virtual std::vector<GuildMember> FindMembers(Guild guild, const std::string &Prefix, size_t Limit = 10) = 0;
+
             /**
              * @param Token: Your Discord bot token. Which you have created <a href="https://discordapp.com/developers/applications">here</a>.
              * 
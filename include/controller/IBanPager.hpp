@@ -0,0 +1,60 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef IBANPAGER_HPP
+#define IBANPAGER_HPP
+
+#include <memory>
+#include <vector>
+#include <models/Ban.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Iterates page by page over the ban list of a guild. Each call of Next() requests one page from discord.
+     */
+    class IBanPager
+    {
+        public:
+            IBanPager() = default;
+
+            /**
+             * @return Returns true if there is a next page.
+             */
+            virtual bool HasNext() = 0;
+
+            /**
+             * @return Requests the next page of the ban list. Returns an empty list if there is no next page.
+             * 
+             * @throw CDiscordClientException on error.
+             */
+            virtual std::vector<SBan> Next() = 0;
+
+            virtual ~IBanPager() = default;
+    };
+
+    using BanPager = std::shared_ptr<IBanPager>;
+} // namespace DiscordBot
+
+#endif //IBANPAGER_HPP
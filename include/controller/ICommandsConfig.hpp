@@ -75,6 +75,11 @@ namespace DiscordBot
              */
             virtual std::string GetPrefix(const std::string &Guild, const std::string &Default) = 0;
 
+            /**
+             * @return Returns the approximated heap usage of the config in bytes. Used for the cache statistics.
+             */
+            virtual size_t MemoryUsage() { return 0; }
+
             virtual ~ICommandsConfig() {}
     };
 
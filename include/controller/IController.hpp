@@ -117,11 +117,13 @@ namespace DiscordBot
             virtual void OnMemberRemove(Guild guild, GuildMember Member) {}
 
             /**
-             * @brief Called if a user changes his activity state or online state.
+             * @brief Called if a user changes his activity state or online state. Use IDiscordClient::GetPresence to get the new presence.
              * 
              * @param guild: Guild which had contains the member
              * @param Member: Member which updates
              * 
+             * @note Discord sends the presence for every guild the user shares with the bot. This is only called for the first one, repeated presences are dropped.
+             * 
              * @note The GUILD_PRESENCES intent needs to be set to receive this event. Please visit <a href="https://discord.com/developers/docs/topics/gateway#privileged-intents">this</a> website to use this intent.
              */
             virtual void OnPresenceUpdate(Guild guild, GuildMember Member) {}
@@ -140,7 +142,7 @@ namespace DiscordBot
             /**
              * @brief Called if a message is updated.
              * 
-             * @param msg: Message object which contains the update data.
+             * @param msg: Cached message with the edit applied, if the message cache contains the message. Otherwise the message object contains only the update data. @see IDiscordClient::SetMessageCache
              * 
              * @note The GUILD_MESSAGES intent needs to be set to receive this event. This intent is set by default. @see Intent
              */
@@ -149,7 +151,7 @@ namespace DiscordBot
             /**
              * @brief Called if a message is deleted.
              * 
-             * @param msg: Partial message object which contains the message id, guild and channel.
+             * @param msg: Cached original, if the message cache contains the message. Otherwise a partial message object which contains the message id, guild and channel. @see IDiscordClient::SetMessageCache
              * 
              * @note The GUILD_MESSAGES intent needs to be set to receive this event. This intent is set by default. @see Intent
              */
@@ -33,6 +33,7 @@
 #include <models/ModifyMember.hpp>
 #include <models/ModifyChannel.hpp>
 #include <models/Action.hpp>
+#include <controller/IBanPager.hpp>
 
 namespace DiscordBot
 {
@@ -55,6 +56,30 @@ namespace DiscordBot
              */
             virtual void ModifyMember(const CModifyMember &mod) = 0;
 
+            /**
+             * @brief Adds a role to a member. The other roles of the member are kept, so this doesn't race with concurrent role changes.
+             * 
+             * @param member: Member which gets the role.
+             * @param role: Role to add.
+             * 
+             * @attention The bot needs following permission `MANAGE_ROLES` and a role which is higher than the given one.
+             * 
+             * @throw CDiscordClientException on error.
+             */
+            virtual void AddMemberRole(User member, Role role) = 0;
+
+            /**
+             * @brief Removes a role from a member. The other roles of the member are kept.
+             * 
+             * @param member: Member which loses the role.
+             * @param role: Role to remove.
+             * 
+             * @attention The bot needs following permission `MANAGE_ROLES` and a role which is higher than the given one.
+             * 
+             * @throw CDiscordClientException on error.
+             */
+            virtual void RemoveMemberRole(User member, Role role) = 0;
+
             /**
              * @brief Bans a member from the guild.
              * 
@@ -87,6 +112,20 @@ namespace DiscordBot
              */
             virtual std::vector<std::pair<std::string, User>> GetGuildBans() = 0;
 
+            /**
+             * @brief Creates a pager which requests the ban list page by page. Use this for guilds with large ban lists.
+             * 
+             * @param Limit: Number of bans per page. (1 - 1000 are valid values.)
+             * @param After: Starts the list after this user id. The pager moves forward.
+             * @param Before: Starts the list before this user id. The pager moves backward. Ignored if After is set.
+             * @param CacheUsers: True to add the banned users to the user cache and fill SBan::UserRef.
+             * 
+             * @attention The bot needs following permission `BAN_MEMBERS`
+             * 
+             * @throw CDiscordClientException on error.
+             */
+            virtual BanPager GetGuildBans(size_t Limit, snowflake After = snowflake(), snowflake Before = snowflake(), bool CacheUsers = false) = 0;
+
             /**
              * @brief Kicks a member from the guild.
              * 
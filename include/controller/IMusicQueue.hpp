@@ -33,10 +33,11 @@
 #include <atomic>
 #include <functional>
 #include <config.h>
+#include <models/snowflake.hpp>
 
 namespace DiscordBot
 {
-    using OnWaitFinish = std::function<void(const std::string&, AudioSource)>;
+    using OnWaitFinish = std::function<void(snowflake, AudioSource)>;
 
     /**
      * @brief Thread safe music queue interface.
@@ -82,6 +83,11 @@ namespace DiscordBot
              */
             bool HasNext();
 
+            /**
+             * @return Returns the approximated heap usage of the queued songs in bytes. Used for the cache statistics.
+             */
+            virtual size_t MemoryUsage();
+
             /**
              * @brief Returns true if a song is not ready.
              */
@@ -90,7 +96,7 @@ namespace DiscordBot
                 return m_NeedWait;
             }
 
-            inline void SetGuildID(const std::string &ID)
+            inline void SetGuildID(snowflake ID)
             {
                 m_GuildID = ID;
             }
@@ -177,7 +183,7 @@ namespace DiscordBot
 
             OnWaitFinish m_WaitFinishCallback;
             std::atomic<bool> m_NeedWait;
-            std::string m_GuildID;
+            snowflake m_GuildID;
             std::atomic<size_t> m_QueueIndex; 
             std::atomic<size_t> m_QueueSize;    //!< Used to prevent dead locks.
             SongInfo m_WaitSong;
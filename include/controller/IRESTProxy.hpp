@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef IRESTPROXY_HPP
+#define IRESTPROXY_HPP
+
+#include <memory>
+#include <string>
+#include <config.h>
+#include <models/RESTStatistics.hpp>
+
+namespace DiscordBot
+{
+    class IRESTProxy;
+    using RESTProxy = std::shared_ptr<IRESTProxy>;
+
+    /**
+     * @brief Local http proxy for the discord REST api. The proxy owns the rate limits and connections, so multiple bot processes with the same token share one view of the limits.
+     * 
+     * Point the bots to the proxy with IDiscordClient::SetBaseURL("http://127.0.0.1:8090").
+     * "GET /stats" returns the statistics of the proxy as json.
+     */
+    class DISCORDBOT_EXPORT IRESTProxy
+    {
+        public:
+            IRESTProxy() = default;
+
+            /**
+             * @brief Starts listening for requests.
+             * 
+             * @return Returns false if the port can't be opened.
+             */
+            virtual bool Start() = 0;
+
+            /**
+             * @brief Stops the proxy.
+             */
+            virtual void Stop() = 0;
+
+            /**
+             * @return Gets the rate limit and latency statistics of all forwarded requests.
+             */
+            virtual SRESTStatistics GetStatistics() = 0;
+
+            /**
+             * @return Gets the throughput of the proxy.
+             */
+            virtual SProxyStatistics GetProxyStatistics() = 0;
+
+            /**
+             * @param Token: Discord bot token, which is used for all forwarded requests.
+             * @param Port: Port to listen on.
+             * @param Host: Interface to listen on. Only use local interfaces, since the proxy authorizes every request with the bot token.
+             * 
+             * @return Returns a new proxy instance.
+             */
+            static RESTProxy Create(const std::string &Token, int Port = 8090, const std::string &Host = "127.0.0.1");
+
+            virtual ~IRESTProxy() = default;
+    };
+} // namespace DiscordBot
+
+
+#endif //IRESTPROXY_HPP
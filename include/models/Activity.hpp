@@ -26,9 +26,9 @@
 #define ACTIVITY_HPP
 
 #include <memory>
+#include <stdint.h>
 #include <string>
-#include <atomic>
-#include <models/atomic.hpp>
+#include <vector>
 
 namespace DiscordBot
 {
@@ -60,53 +60,53 @@ namespace DiscordBot
         public:
             CParty() {}
 
-            atomic<std::string> ID;
-            atomic<std::vector<int>> Size;    //(current_size, max_size)	used to show the party's current and maximum size
+            std::string ID;
+            std::vector<int> Size;    //(current_size, max_size)	used to show the party's current and maximum size
 
             ~CParty() {}
     };
 
-    using Party = std::shared_ptr<CParty>;
+    using Party = std::shared_ptr<const CParty>;
 
     class CSecrets
     {
         public:
             CSecrets() {}
 
-            atomic<std::string> Join;
-            atomic<std::string> Spectate;
-            atomic<std::string> Match;
+            std::string Join;
+            std::string Spectate;
+            std::string Match;
 
             ~CSecrets() {}
     };
 
-    using Secrets = std::shared_ptr<CSecrets>;
+    using Secrets = std::shared_ptr<const CSecrets>;
 
     class CActivity
     {
         public:
-            CActivity(/* args */) {}
+            CActivity(/* args */) : Type(ActivityType::GAME), CreatedAt(0), StartTime(0), EndTime(0), Instance(false), Flags((ActivityFlags)0) {}
 
-            atomic<std::string> Name;
+            std::string Name;
             ActivityType Type;
-            atomic<std::string> URL;
-            std::atomic<int> CreatedAt;
-            std::atomic<int> StartTime;
-            std::atomic<int> EndTime;
-            atomic<std::string> AppID;
-            atomic<std::string> Details;
-            atomic<std::string> State;
+            std::string URL;
+            int64_t CreatedAt;      //!< Milliseconds since the unix epoch.
+            int64_t StartTime;      //!< Milliseconds since the unix epoch.
+            int64_t EndTime;        //!< Milliseconds since the unix epoch.
+            std::string AppID;
+            std::string Details;
+            std::string State;
             //Emoji
             Party PartyObject;
             //Asset
             Secrets Secret;
-            std::atomic<bool> Instance;
+            bool Instance;
             ActivityFlags Flags;            
 
             ~CActivity() {}
     };
 
-    using Activity = std::shared_ptr<CActivity>;
+    using Activity = std::shared_ptr<const CActivity>;
 } // namespace DiscordBot
 
 
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BAN_HPP
+#define BAN_HPP
+
+#include <string>
+#include <models/User.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Lightweight ban list entry. Only contains the informations which are delivered by the ban list endpoint.
+     */
+    struct SBan
+    {
+        SBan() : Bot(false) {}
+
+        std::string Reason;
+        snowflake UserID;
+        std::string Username;
+        std::string Discriminator;
+        std::string Avatar;
+        bool Bot;
+
+        User UserRef;   //!< Only set if the pager adds the users to the user cache. @see IGuildAdmin::GetGuildBans
+    };
+} // namespace DiscordBot
+
+
+#endif //BAN_HPP
@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef CACHEPOLICY_HPP
+#define CACHEPOLICY_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Entities with a configurable cache policy. @see IDiscordClient::SetCachePolicy
+     */
+    enum class CacheEntity
+    {
+        MEMBERS,        //!< Guild members. The member of the bot is always cached.
+        USERS,          //!< Users which aren't referenced by a cached member, e.g. message authors or users of evicted members. Referenced users are part of the member cache. Not cached by default, such users live as long as the application references them.
+        PRESENCES,      //!< Online state and activities of the users.
+        VOICE_STATES,   //!< Voice states of the members. The voice state of the bot is always cached.
+        CHANNELS        //!< Text and news channels. Voice channels and categories are always cached.
+    };
+
+    enum class CacheMode
+    {
+        NONE,   //!< Nothing is stored.
+        ALL,    //!< Everything is stored until discord removes it.
+        LRU     //!< Entries are evicted after the TTL and the least recently used ones if the byte budget is exceeded.
+    };
+
+    /**
+     * @brief Describes how long an entity is cached.
+     * 
+     * LRU caches are swept every 10 seconds by their own thread. Evicted members and channels are fetched again on demand (IDiscordClient::GetMember) or replaced by a stub object with the id.
+     */
+    struct SCachePolicy
+    {
+        SCachePolicy() : Mode(CacheMode::ALL), TTL(0), MaxBytes(0) {}
+        SCachePolicy(CacheMode mode, uint32_t ttl = 0, size_t maxBytes = 0) : Mode(mode), TTL(ttl), MaxBytes(maxBytes) {}
+
+        CacheMode Mode;
+        uint32_t TTL;       //!< Time since the last access or update in milliseconds, after which a entry is evicted. 0 for no ttl.
+        size_t MaxBytes;    //!< Approximated heap budget of the entity. 0 for no budget.
+    };
+} // namespace DiscordBot
+
+
+#endif //CACHEPOLICY_HPP
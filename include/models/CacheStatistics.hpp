@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef CACHESTATISTICS_HPP
+#define CACHESTATISTICS_HPP
+
+#include <stddef.h>
+#include <vector>
+#include <models/arena.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Number of entries and approximated heap usage of a cache.
+     */
+    struct SCacheUsage
+    {
+        SCacheUsage() : Count(0), Bytes(0) {}
+
+        size_t Count;
+        size_t Bytes;
+    };
+
+    /**
+     * @brief Caches of one guild. @see SCacheStatistics
+     */
+    struct SGuildCacheStatistics
+    {
+        snowflake GuildID;
+        SCacheUsage Members;        //!< Without the users, which are counted in SCacheStatistics::Users.
+        SCacheUsage Channels;
+        SCacheUsage Roles;
+        SCacheUsage VoiceStates;
+        arena::stats Arena;         //!< Chunks of the object memory of the guild. The objects are also counted in the caches above.
+
+        /**
+         * @return Returns the bytes of all caches of the guild.
+         */
+        inline size_t Bytes() const
+        {
+            return Members.Bytes + Channels.Bytes + Roles.Bytes + VoiceStates.Bytes;
+        }
+    };
+
+    /**
+     * @brief Approximated memory usage of the client caches. The values are calculated on request, so reading them doesn't slow down the event handling.
+     */
+    struct SCacheStatistics
+    {
+        SCacheUsage Users;
+        SCacheUsage Presences;
+        SCacheUsage Messages;               //!< Recent messages of all channels. @see IDiscordClient::SetMessageCache
+        SCacheUsage MemberIndex;            //!< Name index of IDiscordClient::FindMembers. Only the bytes are set.
+        SCacheUsage MusicQueues;            //!< Count is the number of queues.
+        SCacheUsage Config;                 //!< Command config of the controller.
+        SCacheUsage InternedStrings;        //!< Names and locales shared by all caches.
+        std::vector<SGuildCacheStatistics> Guilds;      //!< Sorted by bytes, the biggest guild first.
+
+        /**
+         * @return Returns the bytes of all caches.
+         */
+        inline size_t Bytes() const
+        {
+            size_t Ret = Users.Bytes + Presences.Bytes + Messages.Bytes + MemberIndex.Bytes + MusicQueues.Bytes + Config.Bytes + InternedStrings.Bytes;
+            for (auto &&e : Guilds)
+                Ret += e.Bytes();
+
+            return Ret;
+        }
+    };
+} // namespace DiscordBot
+
+#endif //CACHESTATISTICS_HPP
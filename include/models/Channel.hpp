@@ -30,7 +30,10 @@
 #include <models/User.hpp>
 #include <string>
 #include <models/Role.hpp>
-#include <models/atomic.hpp>
+#include <models/snowflake.hpp>
+#include <models/interned_string.hpp>
+#include <models/image_hash.hpp>
+#include <stdint.h>
 
 namespace DiscordBot
 {
@@ -50,39 +53,39 @@ namespace DiscordBot
         public:
             CPermissionOverwrites() {}
 
-            atomic<std::string> ID;     //!< User or role id
-            atomic<std::string> Type;   //!< role or user
+            snowflake ID;       //!< User or role id
+            interned_string Type;   //!< role or user
             Permission Allow;
             Permission Deny;
 
             ~CPermissionOverwrites() {}
     };
 
-    using PermissionOverwrites = std::shared_ptr<CPermissionOverwrites>;
+    using PermissionOverwrites = std::shared_ptr<const CPermissionOverwrites>;
 
     class CChannel
     {
         public:
-            CChannel() : Position(0), NSFW(false), Bitrate(0), UserLimit(0), RateLimit(0) {}
+            CChannel() : Type(ChannelTypes::GUILD_TEXT), Position(0), NSFW(false), Bitrate(0), UserLimit(0), RateLimit(0), LastPinTimestamp(0) {}
 
-            atomic<std::string> ID;
+            snowflake ID;
             ChannelTypes Type;
-            atomic<std::string> GuildID;
-            std::atomic<int> Position;
-            atomic<std::vector<PermissionOverwrites>> Overwrites;
-            atomic<std::string> Name;
-            atomic<std::string> Topic;
-            std::atomic<bool> NSFW;
-            atomic<std::string> LastMessageID;
-            std::atomic<int> Bitrate;
-            std::atomic<int> UserLimit;
-            std::atomic<int> RateLimit;
-            atomic<std::vector<User>> Recipients;
-            atomic<std::string> Icon;
-            atomic<std::string> OwnerID;
-            atomic<std::string> AppID;
-            atomic<std::string> ParentID;
-            atomic<std::string> LastPinTimestamp;
+            snowflake GuildID;
+            int Position;
+            std::vector<PermissionOverwrites> Overwrites;
+            std::string Name;
+            std::string Topic;
+            bool NSFW;
+            snowflake LastMessageID;
+            int Bitrate;
+            int UserLimit;
+            int RateLimit;
+            std::vector<User> Recipients;
+            image_hash Icon;
+            snowflake OwnerID;
+            snowflake AppID;
+            snowflake ParentID;
+            int64_t LastPinTimestamp;   //!< Milliseconds since the unix epoch.
 
             ~CChannel() {}
 
@@ -90,7 +93,7 @@ namespace DiscordBot
         /* data */
     };
 
-    using Channel = std::shared_ptr<CChannel>;
+    using Channel = std::shared_ptr<const CChannel>;
 }
 
 #endif //CHANNEL_HPP
\ No newline at end of file
@@ -27,7 +27,6 @@
 
 #include <memory>
 #include <string>
-#include <models/atomic.hpp>
 
 namespace DiscordBot
 {
@@ -36,10 +35,10 @@ namespace DiscordBot
         public:
             CEmbed(/* args */) {}
 
-            atomic<std::string> Title;
-            atomic<std::string> Description;
-            atomic<std::string> Type;
-            atomic<std::string> URL;
+            std::string Title;
+            std::string Description;
+            std::string Type;
+            std::string URL;
 
             ~CEmbed() {}
         private:
@@ -28,28 +28,58 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <vector>
 #include <models/User.hpp>
 #include <models/Channel.hpp>
 #include <models/GuildMember.hpp>
 #include <models/Role.hpp>
+#include <models/arena.hpp>
 #include <models/atomic.hpp>
+#include <models/image_hash.hpp>
+#include <models/snapshot_map.hpp>
+#include <models/snowflake.hpp>
 
 namespace DiscordBot
 {
     class CGuild
     {
         public:
-            CGuild(/* args */) {}
+            CGuild(/* args */) : Arena(std::make_shared<arena>()) {}
 
-            atomic<std::string> ID;
+            std::atomic<snowflake> ID;
             atomic<std::string> Name;
-            atomic<std::string> Icon;
+            atomic<image_hash> Icon;
 
             GuildMember Owner;
 
-            atomic<std::map<std::string, GuildMember>> Members;
-            atomic<std::map<std::string, Channel>> Channels; 
-            atomic<std::map<std::string, Role>> Roles;
+            snapshot_map<snowflake, GuildMember> Members;
+            snapshot_map<snowflake, Channel> Channels; 
+            snapshot_map<snowflake, Role> Roles;
+
+            /**
+             * @brief Memory of the members, roles, channels and voice states of this guild. Create them with arena_make_shared().
+             */
+            std::shared_ptr<arena> Arena;
+
+            /**
+             * @return Returns the role objects of a member. Roles which doesn't exist anymore are skipped.
+             */
+            inline std::vector<Role> GetRoles(const GuildMember &member) const
+            {
+                std::vector<Role> Ret;
+                if(!member)
+                    return Ret;
+
+                auto Snapshot = Roles.load();
+                for (auto &&e : member->Roles)
+                {
+                    auto IT = Snapshot->find(e);
+                    if(IT != Snapshot->end())
+                        Ret.push_back(IT->second);
+                }
+
+                return Ret;
+            }
 
             ~CGuild() {}
         private:
@@ -27,27 +27,30 @@
 
 #include <models/User.hpp>
 #include <models/VoiceState.hpp>
+#include <stdint.h>
 #include <vector>
 #include <string>
 #include <models/Role.hpp>
-#include <atomic>
-#include <models/atomic.hpp>
+#include <models/snowflake.hpp>
 
 namespace DiscordBot
 {
+    /**
+     * @brief A member is never modified after it's added to the cache. Every update of the member creates a modified copy and replaces the cached member.
+     */
     class CGuildMember
     {
         public:
-            CGuildMember(/* args */) : Deaf(false), Mute(false) {}
+            CGuildMember(/* args */) : JoinedAt(0), PremiumSince(0), Deaf(false), Mute(false) {}
 
-            atomic<std::string> GuildID;
+            snowflake GuildID;
             User UserRef;
-            atomic<std::string> Nick;
-            atomic<std::vector<Role>> Roles;
-            atomic<std::string> JoinedAt;
-            atomic<std::string> PremiumSince;
-            std::atomic<bool> Deaf;
-            std::atomic<bool> Mute;
+            std::string Nick;
+            std::vector<snowflake> Roles;   //!< Role ids of the member. Use CGuild::GetRoles to get the role objects.
+            int64_t JoinedAt;       //!< Milliseconds since the unix epoch.
+            int64_t PremiumSince;   //!< Milliseconds since the unix epoch or 0 if the member doesn't boost the guild.
+            bool Deaf : 1;
+            bool Mute : 1;
 
             VoiceState State;
 
@@ -56,7 +59,7 @@ namespace DiscordBot
             /* data */
     };
 
-    using GuildMember = std::shared_ptr<CGuildMember>;
+    using GuildMember = std::shared_ptr<const CGuildMember>;
 } // namespace DiscordBot
 
 
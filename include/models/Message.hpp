@@ -54,7 +54,7 @@ namespace DiscordBot
         public:
             CMessage(/* args */) {}
 
-            std::string ID;
+            snowflake ID;
             Channel ChannelRef;     //!< Could contain a dummy channel if this is a dm. Only the id field is filled.
             Guild GuildRef;
             User Author;
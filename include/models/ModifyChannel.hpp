@@ -107,7 +107,7 @@ namespace DiscordBot
 
             inline void SetCategorie(Channel Categorie)
             {
-                m_Values["parent_id"] = Categorie->ID;
+                m_Values["parent_id"] = Categorie->ID.str();
             }
 
             inline std::map<std::string, std::string> GetValues() const
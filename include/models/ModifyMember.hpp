@@ -108,7 +108,7 @@ namespace DiscordBot
              */
             inline void SetChannel(Channel c)
             {
-                m_Values["channel_id"] = c ? c->ID.load() : "null";
+                m_Values["channel_id"] = c ? c->ID.str() : "null";
             }
 
             inline std::map<std::string, std::string> GetValues() const
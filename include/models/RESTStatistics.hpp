@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RESTSTATISTICS_HPP
+#define RESTSTATISTICS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <models/RequestPriority.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Latency metrics of one priority class. All times are in milliseconds.
+     */
+    struct SPriorityStatistics
+    {
+        SPriorityStatistics() : Requests(0), Queued(0), TotalWait(0), MaxWait(0), TotalLatency(0), MaxLatency(0) {}
+
+        uint64_t Requests;      //!< Finished requests.
+        uint64_t Queued;        //!< Requests which are currently waiting for the rate limit.
+        uint64_t TotalWait;     //!< Sum of the time requests waited for the rate limit.
+        uint64_t MaxWait;       //!< Longest time a request waited for the rate limit.
+        uint64_t TotalLatency;  //!< Sum of the time between queuing and the response.
+        uint64_t MaxLatency;    //!< Longest time between queuing and the response.
+    };
+
+    /**
+     * @brief Response body sizes of one route.
+     */
+    struct STrafficStatistics
+    {
+        STrafficStatistics() : Responses(0), Compressed(0), WireBytes(0), DecodedBytes(0) {}
+
+        uint64_t Responses;
+        uint64_t Compressed;        //!< Responses which were sent gzip or deflate encoded.
+        uint64_t WireBytes;         //!< Body bytes as received.
+        uint64_t DecodedBytes;      //!< Body bytes after decompression.
+    };
+
+    /**
+     * @brief Statistics of the REST layer.
+     */
+    struct SRESTStatistics
+    {
+        SPriorityStatistics Priorities[(size_t)RequestPriority::COUNT];     //!< Indexed by RequestPriority.
+        std::map<std::string, STrafficStatistics> Routes;                   //!< Traffic per route template. E.g. "GET /guilds/:major/members"
+    };
+    /**
+     * @brief Throughput of a REST proxy. @see IRESTProxy
+     */
+    struct SProxyStatistics
+    {
+        SProxyStatistics() : Requests(0), Failed(0), InFlight(0), BytesIn(0), BytesOut(0), Uptime(0) {}
+
+        uint64_t Requests;      //!< Forwarded requests.
+        uint64_t Failed;        //!< Requests which couldn't be forwarded to discord.
+        uint64_t InFlight;      //!< Requests which are currently queued or forwarded.
+        uint64_t BytesIn;       //!< Request body bytes of the clients.
+        uint64_t BytesOut;      //!< Response body bytes to the clients.
+        uint64_t Uptime;        //!< Milliseconds since the proxy was started.
+    };
+} // namespace DiscordBot
+
+
+#endif //RESTSTATISTICS_HPP
@@ -0,0 +1,71 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef REQUESTPRIORITY_HPP
+#define REQUESTPRIORITY_HPP
+
+#include <config.h>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Priority class of a REST request. Higher classes are served first within the same rate limit bucket.
+     */
+    enum class RequestPriority
+    {
+        INTERACTIVE,    //!< Replies to users. E.g. command answers.
+        NORMAL,         //!< Default class.
+        BACKGROUND,     //!< Bulk work. E.g. mass role updates.
+
+        COUNT
+    };
+
+    /**
+     * @brief Overrides the priority of all REST requests of the current thread, as long as this object lives.
+     * 
+     * Example:
+     * 
+     * {
+     *      CRequestPriorityScope Scope(RequestPriority::BACKGROUND);
+     *      for(auto &&m : Members)
+     *          Admin->ModifyMember(...);
+     * }
+     */
+    class DISCORDBOT_EXPORT CRequestPriorityScope
+    {
+        public:
+            CRequestPriorityScope(RequestPriority Priority);
+
+            CRequestPriorityScope(const CRequestPriorityScope&) = delete;
+            CRequestPriorityScope &operator=(const CRequestPriorityScope&) = delete;
+
+            ~CRequestPriorityScope();
+
+        private:
+            int m_Prev;
+    };
+} // namespace DiscordBot
+
+
+#endif //REQUESTPRIORITY_HPP
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RETRYPOLICY_HPP
+#define RETRYPOLICY_HPP
+
+#include <stdint.h>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Describes how failed REST requests are repeated.
+     * 
+     * Requests are retried on network errors and 5xx responses with a jittered exponential backoff.
+     * POST requests are only retried if discord never received them (connection errors, 502, 503, 504).
+     */
+    struct SRetryPolicy
+    {
+        SRetryPolicy() : MaxRetries(3), BaseDelay(250), MaxDelay(8000), Deadline(30000), HedgeGETs(true), HedgePercentile(95), MinHedgeSamples(32) {}
+
+        uint32_t MaxRetries;        //!< Maximum count of retries after the first attempt.
+        uint32_t BaseDelay;         //!< Backoff delay of the first retry in milliseconds. Doubles for each retry.
+        uint32_t MaxDelay;          //!< Upper bound of one backoff delay in milliseconds.
+        uint32_t Deadline;          //!< Time budget of one call including all retries in milliseconds. 0 for no deadline.
+        bool HedgeGETs;             //!< Sends a second request for a GET, if the first one takes longer than the HedgePercentile latency of the route.
+        uint32_t HedgePercentile;   //!< Latency percentile of a route, after which a hedged request is send.
+        uint32_t MinHedgeSamples;   //!< Minimum count of latency samples of a route, before hedging starts.
+    };
+} // namespace DiscordBot
+
+
+#endif //RETRYPOLICY_HPP
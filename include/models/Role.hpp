@@ -28,8 +28,7 @@
 #include <string>
 #include <memory>
 #include <stdlib.h>
-#include <atomic>
-#include <models/atomic.hpp>
+#include <models/snowflake.hpp>
 
 namespace DiscordBot
 {
@@ -85,21 +84,21 @@ namespace DiscordBot
     class CRole
     {
         public:
-            CRole(/* args */) {}
+            CRole(/* args */) : Color(0), Position(0), Permissions((Permission)0), Hoist(false), Managed(false), Mentionable(false) {}
 
-            atomic<std::string> ID;
-            atomic<std::string> Name;
-            std::atomic<uint32_t> Color;     //Color of the role.
-            std::atomic<bool> Hoist;
-            std::atomic<int> Position;
+            snowflake ID;
+            std::string Name;
+            uint32_t Color;     //Color of the role.
+            int Position;
             Permission Permissions;
-            std::atomic<bool> Managed;
-            std::atomic<bool> Mentionable;
+            bool Hoist : 1;
+            bool Managed : 1;
+            bool Mentionable : 1;
 
             ~CRole() {}
     };
 
-    using Role = std::shared_ptr<CRole>;
+    using Role = std::shared_ptr<const CRole>;
 } // namespace DiscordBot
 
 
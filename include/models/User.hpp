@@ -28,10 +28,9 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <models/OnlineState.hpp>
-#include <models/Activity.hpp>
-#include <atomic>
-#include <models/atomic.hpp>
+#include <models/snowflake.hpp>
+#include <models/interned_string.hpp>
+#include <models/image_hash.hpp>
 
 namespace DiscordBot
 {
@@ -60,38 +59,36 @@ namespace DiscordBot
         NITRO = 2
     };
 
+    /**
+     * @brief Immutable user. The online state and activities are stored separately, use IDiscordClient::GetPresence to get them.
+     */
     class CUser
     {
         public:
-            CUser(/* args */) : Bot(false), System(false), MFAEnabled(false), Verified(false) {}
+            CUser(/* args */) : Flags(UserFlags::NONE), PublicFlags(UserFlags::NONE), Bot(false), System(false), MFAEnabled(false), Verified(false), PremiumType(PremiumTypes::NONE) {}
 
-            atomic<std::string> ID;
-            atomic<std::string> Username;
-            atomic<std::string> Discriminator;
-            atomic<std::string> Avatar;
-            std::atomic<bool> Bot;
-            std::atomic<bool> System;
-            std::atomic<bool> MFAEnabled;
-            atomic<std::string> Locale;
-            std::atomic<bool> Verified;
-            atomic<std::string> Email;
+            snowflake ID;
+            std::string Username;
+            std::string Discriminator;
+            image_hash Avatar;
+            interned_string Locale;
+            std::string Email;
             UserFlags Flags;
-            PremiumTypes PremiumType;
             UserFlags PublicFlags;
 
-            Activity Game;
-            OnlineState State;
-            OnlineState Desktop;
-            OnlineState Mobile;
-            OnlineState Web;
-            atomic<std::vector<Activity>> Activities;
+            //Packed into one byte. The enum is signed, so it needs one more bit than its largest value.
+            bool Bot : 1;
+            bool System : 1;
+            bool MFAEnabled : 1;
+            bool Verified : 1;
+            PremiumTypes PremiumType : 3;
 
             ~CUser() {}
 
         private:
     };
 
-    using User = std::shared_ptr<CUser>;
+    using User = std::shared_ptr<const CUser>;
 }
 
 #endif //USER_HPP
\ No newline at end of file
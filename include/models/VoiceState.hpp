@@ -29,8 +29,6 @@
 #include <models/Channel.hpp>
 #include <models/User.hpp>
 #include <string>
-#include <atomic>
-#include <models/atomic.hpp>
 
 namespace DiscordBot
 {
@@ -45,20 +43,20 @@ namespace DiscordBot
             Guild GuildRef;
             Channel ChannelRef;
             User UserRef;
-            atomic<std::string> SessionID;
-            std::atomic<bool> Deaf;
-            std::atomic<bool> Mute;
-            std::atomic<bool> SelfDeaf;
-            std::atomic<bool> SelfMute;
-            std::atomic<bool> SelfStream;
-            std::atomic<bool> Supress;
+            std::string SessionID;
+            bool Deaf : 1;
+            bool Mute : 1;
+            bool SelfDeaf : 1;
+            bool SelfMute : 1;
+            bool SelfStream : 1;
+            bool Supress : 1;
 
             ~CVoiceState() {}
         private:
             /* data */
     };
 
-    using VoiceState = std::shared_ptr<CVoiceState>;
+    using VoiceState = std::shared_ptr<const CVoiceState>;
 } // namespace DiscordBot
 
 
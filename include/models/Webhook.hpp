@@ -0,0 +1,54 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WEBHOOK_HPP
+#define WEBHOOK_HPP
+
+#include <memory>
+#include <string>
+#include <models/snowflake.hpp>
+#include <models/image_hash.hpp>
+
+namespace DiscordBot
+{
+    class CWebhook
+    {
+        public:
+            CWebhook() {}
+
+            snowflake ID;
+            std::string Token;      //!< Secure token of the webhook. Needed to execute the webhook.
+            snowflake ChannelID;
+            snowflake GuildID;
+            std::string Name;       //!< Default username of the webhook.
+            image_hash Avatar;      //!< Default avatar hash of the webhook.
+
+            ~CWebhook() {}
+    };
+
+    using Webhook = std::shared_ptr<const CWebhook>;
+} // namespace DiscordBot
+
+
+#endif //WEBHOOK_HPP
@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Memory pool for the objects of one guild. Small blocks are cut from chunks, which grow from 4 KiB up to 64 KiB so small guilds stay small, and freed blocks are kept in a free list per size class for the next allocation of the same size.
+     * The chunks are released together, when the arena and all objects in it are destroyed.
+     * 
+     * Blocks bigger than 1 KiB are forwarded to the global heap.
+     */
+    class arena
+    {
+        public:
+            struct stats
+            {
+                stats() : chunks(0), reserved(0), used(0), allocations(0) {}
+
+                size_t chunks;
+                size_t reserved;        //!< Bytes of all chunks.
+                size_t used;            //!< Bytes of the live blocks. The rest of the chunks is free or in the free lists.
+                size_t allocations;     //!< Live blocks.
+            };
+
+            arena() : m_Pos(nullptr), m_End(nullptr) 
+            {
+                for (auto &&e : m_Free)
+                    e = nullptr;
+            }
+
+            arena(const arena &) = delete;
+            arena &operator=(const arena &) = delete;
+
+            inline void *allocate(size_t size)
+            {
+                if(size > MAX_BLOCK)
+                    return ::operator new(size);
+
+                size_t cls = size_class(size);
+                size_t bytes = (cls + 1) * GRANULARITY;
+
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Stats.used += bytes;
+                m_Stats.allocations++;
+
+                //Reuses a freed block of the same size.
+                if(m_Free[cls])
+                {
+                    free_block *block = m_Free[cls];
+                    m_Free[cls] = block->next;
+                    return block;
+                }
+
+                if((size_t)(m_End - m_Pos) < bytes)
+                {
+                    size_t chunk = m_Stats.chunks < 4 ? (MIN_CHUNK_SIZE << m_Stats.chunks) : MAX_CHUNK_SIZE;
+                    m_Chunks.emplace_back(new char[chunk]);
+                    m_Pos = m_Chunks.back().get();
+                    m_End = m_Pos + chunk;
+                    m_Stats.chunks++;
+                    m_Stats.reserved += chunk;
+                }
+
+                void *ret = m_Pos;
+                m_Pos += bytes;
+                return ret;
+            }
+
+            inline void deallocate(void *ptr, size_t size) noexcept
+            {
+                if(!ptr)
+                    return;
+
+                if(size > MAX_BLOCK)
+                {
+                    ::operator delete(ptr);
+                    return;
+                }
+
+                size_t cls = size_class(size);
+
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Stats.used -= (cls + 1) * GRANULARITY;
+                m_Stats.allocations--;
+
+                free_block *block = static_cast<free_block*>(ptr);
+                block->next = m_Free[cls];
+                m_Free[cls] = block;
+            }
+
+            inline stats statistics()
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                return m_Stats;
+            }
+
+        private:
+            static const size_t GRANULARITY = 16;       //!< Also the alignment of the blocks.
+            static const size_t MAX_BLOCK = 1024;
+            static const size_t MIN_CHUNK_SIZE = 4 * 1024;
+            static const size_t MAX_CHUNK_SIZE = 64 * 1024;     //!< MIN_CHUNK_SIZE << 4
+
+            struct free_block
+            {
+                free_block *next;
+            };
+
+            static inline size_t size_class(size_t size) noexcept
+            {
+                return size == 0 ? 0 : (size - 1) / GRANULARITY;
+            }
+
+            std::mutex m_Lock;
+            std::vector<std::unique_ptr<char[]>> m_Chunks;
+            char *m_Pos;
+            char *m_End;
+            free_block *m_Free[MAX_BLOCK / GRANULARITY];
+            stats m_Stats;
+    };
+
+    /**
+     * @brief Allocator for std::allocate_shared. Every block keeps the arena alive, so objects can outlive the owner of the arena.
+     */
+    template<class T>
+    class arena_allocator
+    {
+        public:
+            using value_type = T;
+
+            arena_allocator(std::shared_ptr<arena> a) noexcept : m_Arena(std::move(a)) {}
+
+            template<class U>
+            arena_allocator(const arena_allocator<U> &val) noexcept : m_Arena(val.get_arena()) {}
+
+            inline T *allocate(size_t n)
+            {
+                return static_cast<T*>(m_Arena->allocate(n * sizeof(T)));
+            }
+
+            inline void deallocate(T *ptr, size_t n) noexcept
+            {
+                m_Arena->deallocate(ptr, n * sizeof(T));
+            }
+
+            inline const std::shared_ptr<arena> &get_arena() const noexcept
+            {
+                return m_Arena;
+            }
+
+        private:
+            std::shared_ptr<arena> m_Arena;
+    };
+
+    template<class T, class U>
+    inline bool operator==(const arena_allocator<T> &lhs, const arena_allocator<U> &rhs) noexcept
+    {
+        return lhs.get_arena() == rhs.get_arena();
+    }
+
+    template<class T, class U>
+    inline bool operator!=(const arena_allocator<T> &lhs, const arena_allocator<U> &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * @brief Creates an object and its control block in one arena block. Uses the global heap if the arena is null.
+     */
+    template<class T, class... Args>
+    inline std::shared_ptr<T> arena_make_shared(const std::shared_ptr<arena> &a, Args&&... args)
+    {
+        if(!a)
+            return std::make_shared<T>(std::forward<Args>(args)...);
+
+        return std::allocate_shared<T>(arena_allocator<T>(a), std::forward<Args>(args)...);
+    }
+} // namespace DiscordBot
+
+
+#endif //ARENA_HPP
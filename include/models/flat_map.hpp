@@ -0,0 +1,556 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef FLAT_MAP_HPP
+#define FLAT_MAP_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_MAP_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace DiscordBot
+{
+    /**
+     * @brief Open addressing hash map with one allocation for all entries.
+     * 
+     * Every slot has a control byte which is either empty or contains 7 bits of the hash. A lookup compares 16 control bytes at once (SSE2 if available)
+     * and only compares the keys of matching slots. The map uses linear probing and backward shift deletion, so an erase doesn't leave tombstones behind.
+     * 
+     * @attention Like std::unordered_map every insert can invalidate the iterators. Unlike std::unordered_map an erase can also move other entries.
+     */
+    template<class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+    class flat_map
+    {
+        public:
+            using key_type = K;
+            using mapped_type = V;
+            using value_type = std::pair<const K, V>;
+            using size_type = size_t;
+            using hasher = Hash;
+            using key_equal = KeyEqual;
+
+        private:
+            static const size_t GROUP_WIDTH = 16;
+            static const size_t MIN_CAPACITY = 16;
+            static const uint8_t EMPTY = 0x80;
+
+            using slot_type = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+            template<bool Const>
+            class iterator_base
+            {
+                friend class flat_map;
+                template<bool> friend class iterator_base;
+                using map_ptr = typename std::conditional<Const, const flat_map*, flat_map*>::type;
+
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = typename flat_map::value_type;
+                    using difference_type = ptrdiff_t;
+                    using reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+                    using pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+
+                    iterator_base() : m_Map(nullptr), m_Index(0) {}
+
+                    //Converts an iterator to a const_iterator.
+                    template<bool C = Const, class = typename std::enable_if<C>::type>
+                    iterator_base(const iterator_base<false> &it) : m_Map(it.m_Map), m_Index(it.m_Index) {}
+
+                    inline reference operator*() const
+                    {
+                        return *m_Map->slot(m_Index);
+                    }
+
+                    inline pointer operator->() const
+                    {
+                        return m_Map->slot(m_Index);
+                    }
+
+                    inline iterator_base &operator++()
+                    {
+                        m_Index = m_Map->next_full(m_Index + 1);
+                        return *this;
+                    }
+
+                    inline iterator_base operator++(int)
+                    {
+                        iterator_base tmp = *this;
+                        ++*this;
+                        return tmp;
+                    }
+
+                    inline bool operator==(const iterator_base &rhs) const
+                    {
+                        return m_Index == rhs.m_Index;
+                    }
+
+                    inline bool operator!=(const iterator_base &rhs) const
+                    {
+                        return m_Index != rhs.m_Index;
+                    }
+
+                private:
+                    iterator_base(map_ptr map, size_t index) : m_Map(map), m_Index(index) {}
+
+                    map_ptr m_Map;
+                    size_t m_Index;
+            };
+
+        public:
+            using iterator = iterator_base<false>;
+            using const_iterator = iterator_base<true>;
+
+            flat_map() : m_Ctrl(nullptr), m_Slots(nullptr), m_Capacity(0), m_Size(0) {}
+
+            flat_map(std::initializer_list<value_type> list) : flat_map()
+            {
+                reserve(list.size());
+                for (auto &&e : list)
+                    insert(e);
+            }
+
+            /**
+             * @brief Copies the table layout as it is. No rehashing is needed.
+             */
+            flat_map(const flat_map &val) : flat_map()
+            {
+                if(val.m_Size == 0)
+                    return;
+
+                allocate(val.m_Capacity);
+                memcpy(m_Ctrl, val.m_Ctrl, m_Capacity + GROUP_WIDTH - 1);
+
+                for (size_t i = 0; i < m_Capacity; i++)
+                {
+                    if(m_Ctrl[i] != EMPTY)
+                        new (slot(i)) value_type(*val.slot(i));
+                }
+
+                m_Size = val.m_Size;
+            }
+
+            flat_map(flat_map &&val) noexcept : flat_map()
+            {
+                swap(val);
+            }
+
+            inline flat_map &operator=(flat_map val) noexcept
+            {
+                swap(val);
+                return *this;
+            }
+
+            inline void swap(flat_map &val) noexcept
+            {
+                std::swap(m_Ctrl, val.m_Ctrl);
+                std::swap(m_Slots, val.m_Slots);
+                std::swap(m_Capacity, val.m_Capacity);
+                std::swap(m_Size, val.m_Size);
+            }
+
+            inline iterator begin()
+            {
+                return iterator(this, next_full(0));
+            }
+
+            inline const_iterator begin() const
+            {
+                return const_iterator(this, next_full(0));
+            }
+
+            inline const_iterator cbegin() const
+            {
+                return begin();
+            }
+
+            inline iterator end()
+            {
+                return iterator(this, m_Capacity);
+            }
+
+            inline const_iterator end() const
+            {
+                return const_iterator(this, m_Capacity);
+            }
+
+            inline const_iterator cend() const
+            {
+                return end();
+            }
+
+            inline size_t size() const
+            {
+                return m_Size;
+            }
+
+            inline bool empty() const
+            {
+                return m_Size == 0;
+            }
+
+            inline size_t capacity() const
+            {
+                return m_Capacity;
+            }
+
+            /**
+             * @return Returns the bytes allocated by the table. Doesn't include memory owned by the keys or values.
+             */
+            inline size_t memory_usage() const
+            {
+                return m_Capacity == 0 ? 0 : m_Capacity * sizeof(slot_type) + m_Capacity + GROUP_WIDTH - 1;
+            }
+
+            inline iterator find(const K &key)
+            {
+                return iterator(this, find_index(key));
+            }
+
+            inline const_iterator find(const K &key) const
+            {
+                return const_iterator(this, find_index(key));
+            }
+
+            inline size_t count(const K &key) const
+            {
+                return find_index(key) != m_Capacity ? 1 : 0;
+            }
+
+            inline V &operator[](const K &key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            inline std::pair<iterator, bool> insert(const value_type &val)
+            {
+                auto ret = try_emplace(val.first, val.second);
+                return ret;
+            }
+
+            inline std::pair<iterator, bool> insert(value_type &&val)
+            {
+                return try_emplace(val.first, std::move(val.second));
+            }
+
+            /**
+             * @brief Inserts a value, if the key doesn't exist.
+             */
+            template<class... Args>
+            std::pair<iterator, bool> try_emplace(const K &key, Args&&... args)
+            {
+                size_t hash = Hash()(key);
+                size_t index = find_index(key, hash);
+                if(index != m_Capacity)
+                    return {iterator(this, index), false};
+
+                if(m_Size + 1 > max_load())
+                    rehash(m_Capacity == 0 ? MIN_CAPACITY : m_Capacity * 2);
+
+                index = find_empty(hash);
+                new (slot(index)) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+                set_ctrl(index, h2(hash));
+                m_Size++;
+
+                return {iterator(this, index), true};
+            }
+
+            /**
+             * @return Returns the number of erased elements.
+             */
+            inline size_t erase(const K &key)
+            {
+                size_t index = find_index(key);
+                if(index == m_Capacity)
+                    return 0;
+
+                erase_index(index);
+                return 1;
+            }
+
+            /**
+             * @return Returns the iterator to the next element. Entries which wrap around the end of the table could be moved in front of the iterator.
+             */
+            inline iterator erase(const_iterator pos)
+            {
+                size_t index = pos.m_Index;
+                erase_index(index);
+
+                //The slot contains the next entry, if one was shifted back.
+                return iterator(this, next_full(index));
+            }
+
+            inline void clear()
+            {
+                destroy_all();
+                if(m_Ctrl)
+                    memset(m_Ctrl, EMPTY, m_Capacity + GROUP_WIDTH - 1);
+
+                m_Size = 0;
+            }
+
+            /**
+             * @brief Reserves space for at least count elements without rehashing.
+             */
+            inline void reserve(size_t count)
+            {
+                size_t cap = m_Capacity == 0 ? MIN_CAPACITY : m_Capacity;
+                while (count > cap - cap / 8)
+                    cap *= 2;
+
+                if(cap != m_Capacity)
+                    rehash(cap);
+            }
+
+            ~flat_map()
+            {
+                destroy_all();
+                delete[] m_Ctrl;
+                delete[] m_Slots;
+            }
+
+        private:
+            uint8_t *m_Ctrl;        //!< One control byte per slot and GROUP_WIDTH - 1 mirrored bytes of the start, so a group can be loaded at every index.
+            slot_type *m_Slots;
+            size_t m_Capacity;      //!< Always zero or a power of two.
+            size_t m_Size;
+
+            inline value_type *slot(size_t index)
+            {
+                return reinterpret_cast<value_type*>(&m_Slots[index]);
+            }
+
+            inline const value_type *slot(size_t index) const
+            {
+                return reinterpret_cast<const value_type*>(&m_Slots[index]);
+            }
+
+            //Max load factor of 7/8.
+            inline size_t max_load() const
+            {
+                return m_Capacity - m_Capacity / 8;
+            }
+
+            static inline size_t h1(size_t hash)
+            {
+                return hash >> 7;
+            }
+
+            static inline uint8_t h2(size_t hash)
+            {
+                return (uint8_t)(hash & 0x7F);
+            }
+
+            static inline unsigned trailing_zeros(uint32_t mask)
+            {
+#ifdef _MSC_VER
+                unsigned long ret;
+                _BitScanForward(&ret, mask);
+                return (unsigned)ret;
+#else
+                return (unsigned)__builtin_ctz(mask);
+#endif
+            }
+
+            /**
+             * @return Returns a bitmask of the slots in the group at index which contain the given control byte.
+             */
+            inline uint32_t match(size_t index, uint8_t ctrl) const
+            {
+#ifdef FLAT_MAP_SSE2
+                __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Ctrl + index));
+                return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)ctrl)));
+#else
+                uint32_t ret = 0;
+                for (size_t i = 0; i < GROUP_WIDTH; i++)
+                {
+                    if(m_Ctrl[index + i] == ctrl)
+                        ret |= (1u << i);
+                }
+
+                return ret;
+#endif
+            }
+
+            inline size_t find_index(const K &key) const
+            {
+                return m_Capacity == 0 ? 0 : find_index(key, Hash()(key));
+            }
+
+            /**
+             * @return Returns the slot of the key or m_Capacity if the key doesn't exist.
+             */
+            size_t find_index(const K &key, size_t hash) const
+            {
+                if(m_Capacity == 0)
+                    return 0;
+
+                size_t mask = m_Capacity - 1;
+                size_t pos = h1(hash) & mask;
+                uint8_t fingerprint = h2(hash);
+
+                while (true)
+                {
+                    uint32_t matches = match(pos, fingerprint);
+                    uint32_t empties = match(pos, EMPTY);
+
+                    //Linear probing never places an entry behind an empty slot of its probe sequence.
+                    if(empties)
+                        matches &= (1u << trailing_zeros(empties)) - 1;
+
+                    while (matches)
+                    {
+                        size_t index = (pos + trailing_zeros(matches)) & mask;
+                        if(KeyEqual()(slot(index)->first, key))
+                            return index;
+
+                        matches &= matches - 1;
+                    }
+
+                    if(empties)
+                        return m_Capacity;
+
+                    pos = (pos + GROUP_WIDTH) & mask;
+                }
+            }
+
+            size_t find_empty(size_t hash) const
+            {
+                size_t mask = m_Capacity - 1;
+                size_t pos = h1(hash) & mask;
+
+                while (true)
+                {
+                    uint32_t empties = match(pos, EMPTY);
+                    if(empties)
+                        return (pos + trailing_zeros(empties)) & mask;
+
+                    pos = (pos + GROUP_WIDTH) & mask;
+                }
+            }
+
+            inline size_t next_full(size_t index) const
+            {
+                while (index < m_Capacity && m_Ctrl[index] == EMPTY)
+                    index++;
+
+                return index;
+            }
+
+            inline void set_ctrl(size_t index, uint8_t ctrl)
+            {
+                m_Ctrl[index] = ctrl;
+                if(index < GROUP_WIDTH - 1)
+                    m_Ctrl[m_Capacity + index] = ctrl;
+            }
+
+            /**
+             * @brief Removes the entry and shifts the following entries of the cluster back, until an entry is at its home slot or a slot is empty.
+             */
+            void erase_index(size_t index)
+            {
+                size_t mask = m_Capacity - 1;
+                slot(index)->~value_type();
+
+                size_t hole = index;
+                for (size_t next = (hole + 1) & mask; m_Ctrl[next] != EMPTY; next = (next + 1) & mask)
+                {
+                    size_t home = h1(Hash()(slot(next)->first)) & mask;
+
+                    //Moves the entry if the hole is between its home slot and its current slot.
+                    if(((next - home) & mask) >= ((next - hole) & mask))
+                    {
+                        new (slot(hole)) value_type(std::move(*slot(next)));
+                        slot(next)->~value_type();
+                        set_ctrl(hole, m_Ctrl[next]);
+                        hole = next;
+                    }
+                }
+
+                set_ctrl(hole, EMPTY);
+                m_Size--;
+            }
+
+            void allocate(size_t cap)
+            {
+                m_Capacity = cap;
+                m_Ctrl = new uint8_t[cap + GROUP_WIDTH - 1];
+                m_Slots = new slot_type[cap];
+                memset(m_Ctrl, EMPTY, cap + GROUP_WIDTH - 1);
+            }
+
+            void rehash(size_t cap)
+            {
+                flat_map tmp;
+                tmp.allocate(cap);
+
+                for (size_t i = 0; i < m_Capacity; i++)
+                {
+                    if(m_Ctrl[i] == EMPTY)
+                        continue;
+
+                    size_t hash = Hash()(slot(i)->first);
+                    size_t index = tmp.find_empty(hash);
+                    new (tmp.slot(index)) value_type(std::move(*slot(i)));
+                    tmp.set_ctrl(index, h2(hash));
+                    tmp.m_Size++;
+                }
+
+                swap(tmp);
+            }
+
+            inline void destroy_all()
+            {
+                if(!std::is_trivially_destructible<value_type>::value)
+                {
+                    for (size_t i = 0; i < m_Capacity; i++)
+                    {
+                        if(m_Ctrl[i] != EMPTY)
+                            slot(i)->~value_type();
+                    }
+                }
+            }
+    };
+} // namespace DiscordBot
+
+#undef FLAT_MAP_SSE2
+
+#endif //FLAT_MAP_HPP
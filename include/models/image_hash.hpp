@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef IMAGE_HASH_HPP
+#define IMAGE_HASH_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Avatar or icon hash. Discord sends the md5 of the image as 32 hex digits, with a `a_` prefix for animated images. The hash is stored as 16 bytes and only formatted if needed. For more info see <a href="https://discord.com/developers/docs/reference#image-formatting">here</a>.
+     * 
+     * Strings which aren't a valid hash result in an empty image_hash.
+     */
+    class image_hash
+    {
+        public:
+            image_hash() noexcept : m_Bytes(), m_Flags(0) {}
+            image_hash(const std::string &val) noexcept : image_hash()
+            {
+                parse(val.data(), val.size());
+            }
+
+            image_hash(const char *val) noexcept : image_hash()
+            {
+                parse(val, strlen(val));
+            }
+
+            /**
+             * @brief Creates a hash from the 16 raw bytes. @see data()
+             */
+            image_hash(const uint8_t *bytes, bool animated) noexcept : m_Flags(VALID | (animated ? ANIMATED : 0))
+            {
+                memcpy(m_Bytes, bytes, sizeof(m_Bytes));
+            }
+
+            inline bool empty() const noexcept
+            {
+                return (m_Flags & VALID) == 0;
+            }
+
+            /**
+             * @return Returns true if the image is a gif.
+             */
+            inline bool animated() const noexcept
+            {
+                return (m_Flags & ANIMATED) != 0;
+            }
+
+            inline const uint8_t *data() const noexcept
+            {
+                return m_Bytes;
+            }
+
+            /**
+             * @return Returns the string representation or an empty string, if the hash is empty.
+             */
+            inline std::string str() const
+            {
+                if(empty())
+                    return "";
+
+                static const char HEX[] = "0123456789abcdef";
+                std::string ret = animated() ? "a_" : "";
+                ret.reserve(ret.size() + sizeof(m_Bytes) * 2);
+
+                for (auto &&b : m_Bytes)
+                {
+                    ret += HEX[b >> 4];
+                    ret += HEX[b & 0xF];
+                }
+
+                return ret;
+            }
+
+            inline operator std::string() const
+            {
+                return str();
+            }
+
+        private:
+            static const uint8_t VALID = 1;
+            static const uint8_t ANIMATED = 2;
+
+            static inline int hex_value(char c) noexcept
+            {
+                if(c >= '0' && c <= '9')
+                    return c - '0';
+                else if(c >= 'a' && c <= 'f')
+                    return c - 'a' + 10;
+                else if(c >= 'A' && c <= 'F')
+                    return c - 'A' + 10;
+
+                return -1;
+            }
+
+            inline void parse(const char *str, size_t len) noexcept
+            {
+                uint8_t flags = VALID;
+                if(len >= 2 && str[0] == 'a' && str[1] == '_')
+                {
+                    flags |= ANIMATED;
+                    str += 2;
+                    len -= 2;
+                }
+
+                if(len != sizeof(m_Bytes) * 2)
+                    return;
+
+                for (size_t i = 0; i < sizeof(m_Bytes); i++)
+                {
+                    int hi = hex_value(str[i * 2]);
+                    int lo = hex_value(str[i * 2 + 1]);
+                    if(hi < 0 || lo < 0)
+                    {
+                        memset(m_Bytes, 0, sizeof(m_Bytes));
+                        return;
+                    }
+
+                    m_Bytes[i] = (uint8_t)((hi << 4) | lo);
+                }
+
+                m_Flags = flags;
+            }
+
+            uint8_t m_Bytes[16];
+            uint8_t m_Flags;
+    };
+
+    inline bool operator==(const image_hash &lhs, const image_hash &rhs) noexcept
+    {
+        return lhs.empty() == rhs.empty() && lhs.animated() == rhs.animated() && memcmp(lhs.data(), rhs.data(), 16) == 0;
+    }
+
+    inline bool operator!=(const image_hash &lhs, const image_hash &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    inline std::ostream &operator<<(std::ostream &of, const image_hash &rhs)
+    {
+        of << rhs.str();
+        return of;
+    }
+} // namespace DiscordBot
+
+#endif //IMAGE_HASH_HPP
@@ -0,0 +1,233 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef INTERNED_STRING_HPP
+#define INTERNED_STRING_HPP
+
+#include <stddef.h>
+#include <string>
+#include <iostream>
+#include <mutex>
+#include <unordered_set>
+#include <functional>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Process wide pool of immutable strings. Each distinct value is stored once and never freed, so only use it for values from a small fixed set (locales, overwrite types).
+     * Names and other values which users choose must not be interned, every new value would grow the pool until the end of the process.
+     */
+    class string_pool
+    {
+        public:
+            static inline string_pool &instance()
+            {
+                static string_pool pool;
+                return pool;
+            }
+
+            /**
+             * @return Returns the pooled copy of the string. The pointer is valid until the end of the process.
+             */
+            inline const std::string *intern(const std::string &str)
+            {
+                if(str.empty())
+                    return &empty_string();
+
+                std::lock_guard<std::mutex> lock(m_Lock);
+                return &*m_Strings.insert(str).first;
+            }
+
+            /**
+             * @return Returns the number of distinct strings.
+             */
+            inline size_t size()
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                return m_Strings.size();
+            }
+
+            /**
+             * @return Returns the approximated heap usage of the pool in bytes.
+             */
+            inline size_t memory_usage()
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+
+                //Bucket array, one node per string (next pointer, cached hash, string) and the heap buffer of long strings.
+                size_t ret = m_Strings.bucket_count() * sizeof(void*);
+                size_t sso = std::string().capacity();
+                for (auto &&e : m_Strings)
+                {
+                    ret += sizeof(std::string) + 2 * sizeof(void*);
+                    if(e.capacity() > sso)
+                        ret += e.capacity() + 1;
+                }
+                
+                return ret;
+            }
+
+            static inline const std::string &empty_string()
+            {
+                static const std::string empty;
+                return empty;
+            }
+
+        private:
+            string_pool() {}
+
+            std::mutex m_Lock;
+            std::unordered_set<std::string> m_Strings;
+    };
+
+    /**
+     * @brief Pointer sized handle to a string of the string_pool. Copies and comparisons of two interned strings don't touch the characters.
+     * 
+     * Converts implicit from and to std::string, so it can replace string fields which repeat the same values.
+     */
+    class interned_string
+    {
+        public:
+            interned_string() noexcept : m_Str(&string_pool::empty_string()) {}
+            interned_string(const std::string &str) : m_Str(string_pool::instance().intern(str)) {}
+            interned_string(const char *str) : m_Str(string_pool::instance().intern(str)) {}
+
+            inline const std::string &str() const noexcept
+            {
+                return *m_Str;
+            }
+
+            inline operator const std::string&() const noexcept
+            {
+                return *m_Str;
+            }
+
+            inline const char *c_str() const noexcept
+            {
+                return m_Str->c_str();
+            }
+
+            inline size_t size() const noexcept
+            {
+                return m_Str->size();
+            }
+
+            inline bool empty() const noexcept
+            {
+                return m_Str->empty();
+            }
+
+            /**
+             * @return Returns the address of the pooled string, which is equal for equal strings.
+             */
+            inline const void *id() const noexcept
+            {
+                return m_Str;
+            }
+
+        private:
+            const std::string *m_Str;
+    };
+
+    inline bool operator==(const interned_string &lhs, const interned_string &rhs) noexcept
+    {
+        return lhs.id() == rhs.id();
+    }
+
+    inline bool operator!=(const interned_string &lhs, const interned_string &rhs) noexcept
+    {
+        return lhs.id() != rhs.id();
+    }
+
+    inline bool operator==(const interned_string &lhs, const std::string &rhs) noexcept
+    {
+        return lhs.str() == rhs;
+    }
+
+    inline bool operator==(const std::string &lhs, const interned_string &rhs) noexcept
+    {
+        return lhs == rhs.str();
+    }
+
+    inline bool operator!=(const interned_string &lhs, const std::string &rhs) noexcept
+    {
+        return lhs.str() != rhs;
+    }
+
+    inline bool operator!=(const std::string &lhs, const interned_string &rhs) noexcept
+    {
+        return lhs != rhs.str();
+    }
+
+    inline bool operator==(const interned_string &lhs, const char *rhs) noexcept
+    {
+        return lhs.str() == rhs;
+    }
+
+    inline bool operator!=(const interned_string &lhs, const char *rhs) noexcept
+    {
+        return lhs.str() != rhs;
+    }
+
+    inline std::string operator+(const std::string &lhs, const interned_string &rhs)
+    {
+        return lhs + rhs.str();
+    }
+
+    inline std::string operator+(const interned_string &lhs, const std::string &rhs)
+    {
+        return lhs.str() + rhs;
+    }
+
+    inline std::string operator+(const char *lhs, const interned_string &rhs)
+    {
+        return lhs + rhs.str();
+    }
+
+    inline std::string operator+(const interned_string &lhs, const char *rhs)
+    {
+        return lhs.str() + rhs;
+    }
+
+    inline std::ostream &operator<<(std::ostream &of, const interned_string &rhs)
+    {
+        of << rhs.str();
+        return of;
+    }
+} // namespace DiscordBot
+
+namespace std
+{
+    template<>
+    struct hash<DiscordBot::interned_string>
+    {
+        inline size_t operator()(const DiscordBot::interned_string &val) const noexcept
+        {
+            return std::hash<const void*>()(val.id());
+        }
+    };
+} // namespace std
+
+#endif //INTERNED_STRING_HPP
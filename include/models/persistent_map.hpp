@@ -0,0 +1,744 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PERSISTENT_MAP_HPP
+#define PERSISTENT_MAP_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace DiscordBot
+{
+    /**
+     * @brief Persistent hash map (hash array mapped trie). A copy shares all nodes with the original and costs O(1).
+     * 
+     * Every node has 32 slots, which are indexed by 5 bits of the hash and stored compressed with a bitmap. A write copies only the nodes on the path to its key,
+     * that are O(log32 n) nodes with up to 32 entries each. Nodes which aren't shared with another copy are modified in place, so a batch of writes on the same copy
+     * only pays for the first copy of each node.
+     * 
+     * The entries are visited in hash order. @see seek
+     * 
+     * @attention Like flat_map every write can invalidate the iterators. Iterating or finding on a non const map copies the visited nodes, which are shared with other copies.
+     */
+    template<class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+    class persistent_map
+    {
+        public:
+            using key_type = K;
+            using mapped_type = V;
+            using value_type = std::pair<const K, V>;
+            using size_type = size_t;
+            using hasher = Hash;
+            using key_equal = KeyEqual;
+
+        private:
+            static const unsigned BITS = 5;
+            static const unsigned MAX_DEPTH = (64 + BITS - 1) / BITS;    //!< Depth of the collision nodes, where all hash bits are used.
+
+            struct node
+            {
+                node() : datamap(0), nodemap(0) {}
+
+                uint32_t datamap;           //!< Slots which contain an entry.
+                uint32_t nodemap;           //!< Slots which contain a sub node.
+                std::vector<value_type> data;
+                std::vector<std::shared_ptr<node>> nodes;
+            };
+
+            using node_ptr = std::shared_ptr<node>;
+
+            template<bool Const>
+            class iterator_base
+            {
+                friend class persistent_map;
+                template<bool> friend class iterator_base;
+
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = typename persistent_map::value_type;
+                    using difference_type = ptrdiff_t;
+                    using reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+                    using pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+
+                    iterator_base() : m_Depth(-1), m_Value(nullptr) {}
+
+                    //Conversion from iterator to const_iterator.
+                    template<bool C = Const, class = typename std::enable_if<C>::type>
+                    iterator_base(const iterator_base<false> &it)
+                    {
+                        *this = it.template cast<true>();
+                    }
+
+                    inline reference operator*() const
+                    {
+                        return *const_cast<pointer>(m_Value);
+                    }
+
+                    inline pointer operator->() const
+                    {
+                        return const_cast<pointer>(m_Value);
+                    }
+
+                    inline iterator_base &operator++()
+                    {
+                        next();
+                        return *this;
+                    }
+
+                    inline iterator_base operator++(int)
+                    {
+                        iterator_base ret = *this;
+                        next();
+                        return ret;
+                    }
+
+                    inline bool operator==(const iterator_base &rhs) const
+                    {
+                        return m_Value == rhs.m_Value;
+                    }
+
+                    inline bool operator!=(const iterator_base &rhs) const
+                    {
+                        return m_Value != rhs.m_Value;
+                    }
+
+                private:
+                    struct frame
+                    {
+                        const node *n;
+                        uint32_t pos;       //!< Next slot or for collision nodes the next entry.
+                    };
+
+                    template<bool C>
+                    inline iterator_base<C> cast() const
+                    {
+                        iterator_base<C> ret;
+                        for (int i = 0; i <= m_Depth; i++)
+                            ret.m_Stack[i] = {m_Stack[i].n, m_Stack[i].pos};
+
+                        ret.m_Depth = m_Depth;
+                        ret.m_Value = m_Value;
+                        return ret;
+                    }
+
+                    /**
+                     * @brief Moves to the next entry. The slots of a node are visited in order and sub nodes are walked where they are.
+                     */
+                    void next()
+                    {
+                        while (m_Depth >= 0)
+                        {
+                            frame &f = m_Stack[m_Depth];
+                            if((unsigned)m_Depth == MAX_DEPTH)
+                            {
+                                if(f.pos < f.n->data.size())
+                                {
+                                    m_Value = &f.n->data[f.pos++];
+                                    return;
+                                }
+
+                                m_Depth--;
+                                continue;
+                            }
+
+                            uint32_t rest = f.pos >= 32 ? 0 : (f.n->datamap | f.n->nodemap) & (~0u << f.pos);
+                            if(rest == 0)
+                            {
+                                m_Depth--;
+                                continue;
+                            }
+
+                            uint32_t slot = trailing_zeros(rest);
+                            uint32_t bit = 1u << slot;
+                            f.pos = slot + 1;
+
+                            if(f.n->datamap & bit)
+                            {
+                                m_Value = &f.n->data[index(f.n->datamap, bit)];
+                                return;
+                            }
+
+                            m_Stack[m_Depth + 1] = {f.n->nodes[index(f.n->nodemap, bit)].get(), 0};
+                            m_Depth++;
+                        }
+
+                        m_Value = nullptr;
+                    }
+
+                    frame m_Stack[MAX_DEPTH + 1];
+                    int m_Depth;
+                    const value_type *m_Value;
+            };
+
+        public:
+            using iterator = iterator_base<false>;
+            using const_iterator = iterator_base<true>;
+
+            persistent_map() : m_Size(0) {}
+
+            template<class It>
+            persistent_map(It first, It last) : m_Size(0)
+            {
+                for (; first != last; ++first)
+                    insert(*first);
+            }
+
+            persistent_map(const persistent_map &) = default;
+            persistent_map &operator=(const persistent_map &) = default;
+
+            persistent_map(persistent_map &&val) noexcept : m_Root(std::move(val.m_Root)), m_Size(val.m_Size)
+            {
+                val.m_Size = 0;
+            }
+
+            inline persistent_map &operator=(persistent_map &&val) noexcept
+            {
+                m_Root = std::move(val.m_Root);
+                m_Size = val.m_Size;
+                val.m_Size = 0;
+
+                return *this;
+            }
+
+            inline void swap(persistent_map &val) noexcept
+            {
+                m_Root.swap(val.m_Root);
+                std::swap(m_Size, val.m_Size);
+            }
+
+            inline const_iterator begin() const
+            {
+                const_iterator ret;
+                if(!m_Root)
+                    return ret;
+
+                ret.m_Stack[0] = {m_Root.get(), 0};
+                ret.m_Depth = 0;
+                ret.next();
+                return ret;
+            }
+
+            /**
+             * @brief Copies all nodes which are shared with other copies, so the entries can be modified.
+             */
+            inline iterator begin()
+            {
+                make_unique(m_Root);
+                return static_cast<const persistent_map*>(this)->begin().template cast<false>();
+            }
+
+            inline const_iterator cbegin() const
+            {
+                return begin();
+            }
+
+            inline const_iterator end() const
+            {
+                return const_iterator();
+            }
+
+            inline iterator end()
+            {
+                return iterator();
+            }
+
+            inline const_iterator cend() const
+            {
+                return const_iterator();
+            }
+
+            inline size_t size() const
+            {
+                return m_Size;
+            }
+
+            inline bool empty() const
+            {
+                return m_Size == 0;
+            }
+
+            /**
+             * @brief The nodes grow on demand. Only exists for the interface of flat_map.
+             */
+            inline void reserve(size_t)
+            {
+            }
+
+            /**
+             * @return Returns the heap usage of the nodes in bytes. Nodes which are shared with other copies are counted too.
+             */
+            inline size_t memory_usage() const
+            {
+                return memory_usage(m_Root.get());
+            }
+
+            inline const_iterator find(const K &key) const
+            {
+                const_iterator ret;
+                const node *n = m_Root.get();
+                uint64_t hash = hash_of(key);
+
+                for (unsigned depth = 0; n; depth++)
+                {
+                    if(depth == MAX_DEPTH)
+                    {
+                        for (size_t i = 0; i < n->data.size(); i++)
+                        {
+                            if(key_equal()(n->data[i].first, key))
+                            {
+                                ret.m_Stack[depth] = {n, (uint32_t)i + 1};
+                                ret.m_Depth = (int)depth;
+                                ret.m_Value = &n->data[i];
+                                return ret;
+                            }
+                        }
+
+                        break;
+                    }
+
+                    uint32_t slot = chunk(hash, depth);
+                    uint32_t bit = 1u << slot;
+                    ret.m_Stack[depth] = {n, slot + 1};
+
+                    if(n->datamap & bit)
+                    {
+                        const value_type &e = n->data[index(n->datamap, bit)];
+                        if(!key_equal()(e.first, key))
+                            break;
+
+                        ret.m_Depth = (int)depth;
+                        ret.m_Value = &e;
+                        return ret;
+                    }
+
+                    if(!(n->nodemap & bit))
+                        break;
+
+                    n = n->nodes[index(n->nodemap, bit)].get();
+                }
+
+                return end();
+            }
+
+            /**
+             * @brief Copies the nodes on the path to the key, which are shared with other copies, so the value can be modified.
+             */
+            inline iterator find(const K &key)
+            {
+                if(static_cast<const persistent_map*>(this)->find(key) == cend())
+                    return end();
+
+                make_path(key);
+                return static_cast<const persistent_map*>(this)->find(key).template cast<false>();
+            }
+
+            inline size_t count(const K &key) const
+            {
+                return find(key) == end() ? 0 : 1;
+            }
+
+            /**
+             * @return Returns the entry at the position of the given hash or the first one after it. Used to resume a walk at a saved position. @see hash_of
+             * 
+             * @attention The entry which was at the position may be visited again.
+             */
+            inline const_iterator seek(uint64_t hash) const
+            {
+                const_iterator ret;
+                const node *n = m_Root.get();
+                if(!n)
+                    return ret;
+
+                for (unsigned depth = 0; ; depth++)
+                {
+                    if(depth == MAX_DEPTH)
+                    {
+                        ret.m_Stack[depth] = {n, 0};
+                        ret.m_Depth = (int)depth;
+                        break;
+                    }
+
+                    uint32_t slot = chunk(hash, depth);
+                    uint32_t bit = 1u << slot;
+
+                    //Continues with the sub node of the slot and afterwards with the following slots.
+                    if(n->nodemap & bit)
+                    {
+                        ret.m_Stack[depth] = {n, slot + 1};
+                        n = n->nodes[index(n->nodemap, bit)].get();
+                        continue;
+                    }
+
+                    ret.m_Stack[depth] = {n, slot};
+                    ret.m_Depth = (int)depth;
+                    break;
+                }
+
+                ret.next();
+                return ret;
+            }
+
+            /**
+             * @return Returns the hash which orders the entries. @see seek
+             */
+            static inline uint64_t hash_of(const K &key)
+            {
+                //Ids have few random bits in their lower part, so the hash is mixed before its bits index the nodes.
+                uint64_t h = (uint64_t)hasher()(key);
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                h *= 0xc4ceb9fe1a85ec53ULL;
+                h ^= h >> 33;
+                return h;
+            }
+
+            /**
+             * @brief Inserts a value, if the key doesn't exist.
+             */
+            inline std::pair<iterator, bool> insert(const value_type &val)
+            {
+                bool inserted = false;
+                assign(m_Root, val.first, hash_of(val.first), 0, val.second, false, inserted);
+                if(inserted)
+                    m_Size++;
+
+                return {static_cast<const persistent_map*>(this)->find(val.first).template cast<false>(), inserted};
+            }
+
+            /**
+             * @return Returns the value of the key. Inserts a default constructed value, if the key doesn't exist.
+             */
+            inline V &operator[](const K &key)
+            {
+                bool inserted = false;
+                V &ret = assign(m_Root, key, hash_of(key), 0, V(), false, inserted);
+                if(inserted)
+                    m_Size++;
+
+                return ret;
+            }
+
+            /**
+             * @return Returns the number of removed entries.
+             */
+            inline size_t erase(const K &key)
+            {
+                if(static_cast<const persistent_map*>(this)->find(key) == cend())
+                    return 0;
+
+                remove(m_Root, key, hash_of(key), 0);
+                if(--m_Size == 0)
+                    m_Root = nullptr;
+
+                return 1;
+            }
+
+            /**
+             * @return Returns the iterator to the entry after the removed one.
+             */
+            inline iterator erase(const_iterator pos)
+            {
+                const_iterator next = pos;
+                ++next;
+
+                if(next == cend())
+                {
+                    erase(pos->first);
+                    return end();
+                }
+
+                K key = next->first;
+                erase(pos->first);
+                return find(key);
+            }
+
+            inline void clear()
+            {
+                m_Root = nullptr;
+                m_Size = 0;
+            }
+
+            ~persistent_map() {}
+
+        private:
+            static inline uint32_t chunk(uint64_t hash, unsigned depth)
+            {
+                return (uint32_t)(hash >> (depth * BITS)) & 31;
+            }
+
+            /**
+             * @return Returns the position of a slot in the compressed array.
+             */
+            static inline size_t index(uint32_t map, uint32_t bit)
+            {
+                return popcount(map & (bit - 1));
+            }
+
+            static inline unsigned popcount(uint32_t mask)
+            {
+#ifdef _MSC_VER
+                return (unsigned)__popcnt(mask);
+#else
+                return (unsigned)__builtin_popcount(mask);
+#endif
+            }
+
+            static inline unsigned trailing_zeros(uint32_t mask)
+            {
+#ifdef _MSC_VER
+                unsigned long ret;
+                _BitScanForward(&ret, mask);
+                return (unsigned)ret;
+#else
+                return (unsigned)__builtin_ctz(mask);
+#endif
+            }
+
+            /**
+             * @return Returns a node of slot, which can be modified. Shared nodes are copied.
+             */
+            static node *make_mutable(node_ptr &slot)
+            {
+                if(!slot)
+                    slot = std::make_shared<node>();
+                else if(slot.use_count() != 1)
+                    slot = std::make_shared<node>(*slot);
+                else
+                {
+                    //The last other owner may have released the node just now, its reads must happen before our writes.
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                }
+
+                return slot.get();
+            }
+
+            static void make_unique(node_ptr &slot)
+            {
+                if(!slot)
+                    return;
+
+                node *n = make_mutable(slot);
+                for (auto &&e : n->nodes)
+                    make_unique(e);
+            }
+
+            void make_path(const K &key)
+            {
+                uint64_t hash = hash_of(key);
+                node_ptr *slot = &m_Root;
+
+                for (unsigned depth = 0; ; depth++)
+                {
+                    node *n = make_mutable(*slot);
+                    if(depth == MAX_DEPTH)
+                        break;
+
+                    uint32_t bit = 1u << chunk(hash, depth);
+                    if(!(n->nodemap & bit))
+                        break;
+
+                    slot = &n->nodes[index(n->nodemap, bit)];
+                }
+            }
+
+            /**
+             * @brief Inserts into a vector whose elements may not be assignable.
+             */
+            template<class T>
+            static void insert_at(std::vector<T> &vec, size_t pos, T &&val)
+            {
+                std::vector<T> ret;
+                ret.reserve(vec.size() + 1);
+                for (size_t i = 0; i < vec.size(); i++)
+                {
+                    if(i == pos)
+                        ret.push_back(std::move(val));
+
+                    ret.push_back(std::move(vec[i]));
+                }
+
+                if(pos == vec.size())
+                    ret.push_back(std::move(val));
+
+                vec.swap(ret);
+            }
+
+            template<class T>
+            static void erase_at(std::vector<T> &vec, size_t pos)
+            {
+                std::vector<T> ret;
+                ret.reserve(vec.size() - 1);
+                for (size_t i = 0; i < vec.size(); i++)
+                {
+                    if(i != pos)
+                        ret.push_back(std::move(vec[i]));
+                }
+
+                vec.swap(ret);
+            }
+
+            /**
+             * @return Returns the value of the key in the subtree of slot. Inserts val, if the key doesn't exist. The nodes on the path are made modifiable.
+             */
+            static V &assign(node_ptr &slot, const K &key, uint64_t hash, unsigned depth, const V &val, bool replace, bool &inserted)
+            {
+                node *n = make_mutable(slot);
+                if(depth == MAX_DEPTH)
+                {
+                    for (auto &&e : n->data)
+                    {
+                        if(key_equal()(e.first, key))
+                        {
+                            if(replace)
+                                e.second = val;
+
+                            return e.second;
+                        }
+                    }
+
+                    inserted = true;
+                    n->data.emplace_back(key, val);
+                    return n->data.back().second;
+                }
+
+                uint32_t bit = 1u << chunk(hash, depth);
+                if(n->nodemap & bit)
+                    return assign(n->nodes[index(n->nodemap, bit)], key, hash, depth + 1, val, replace, inserted);
+
+                if(n->datamap & bit)
+                {
+                    size_t pos = index(n->datamap, bit);
+                    value_type &e = n->data[pos];
+                    if(key_equal()(e.first, key))
+                    {
+                        if(replace)
+                            e.second = val;
+
+                        return e.second;
+                    }
+
+                    //Two keys share the slot, so both move into a new sub node.
+                    node_ptr sub;
+                    bool dummy = false;
+                    assign(sub, e.first, hash_of(e.first), depth + 1, e.second, false, dummy);
+
+                    erase_at(n->data, pos);
+                    n->datamap &= ~bit;
+                    insert_at(n->nodes, index(n->nodemap, bit), std::move(sub));
+                    n->nodemap |= bit;
+
+                    return assign(n->nodes[index(n->nodemap, bit)], key, hash, depth + 1, val, replace, inserted);
+                }
+
+                size_t pos = index(n->datamap, bit);
+                insert_at(n->data, pos, value_type(key, val));
+                n->datamap |= bit;
+
+                inserted = true;
+                return n->data[pos].second;
+            }
+
+            /**
+             * @brief Removes an existing key from the subtree of slot. A sub node with a single entry left is merged into its parent.
+             */
+            static void remove(node_ptr &slot, const K &key, uint64_t hash, unsigned depth)
+            {
+                node *n = make_mutable(slot);
+                if(depth == MAX_DEPTH)
+                {
+                    for (size_t i = 0; i < n->data.size(); i++)
+                    {
+                        if(key_equal()(n->data[i].first, key))
+                        {
+                            erase_at(n->data, i);
+                            break;
+                        }
+                    }
+
+                    return;
+                }
+
+                uint32_t bit = 1u << chunk(hash, depth);
+                if(n->datamap & bit)
+                {
+                    erase_at(n->data, index(n->datamap, bit));
+                    n->datamap &= ~bit;
+                    return;
+                }
+
+                size_t pos = index(n->nodemap, bit);
+                remove(n->nodes[pos], key, hash, depth + 1);
+
+                node *sub = n->nodes[pos].get();
+                if(!sub->nodes.empty() || sub->data.size() > 1)
+                    return;
+
+                if(sub->data.size() == 1)
+                {
+                    value_type e = std::move(sub->data.front());
+                    erase_at(n->nodes, pos);
+                    n->nodemap &= ~bit;
+                    insert_at(n->data, index(n->datamap, bit), std::move(e));
+                    n->datamap |= bit;
+                }
+                else
+                {
+                    erase_at(n->nodes, pos);
+                    n->nodemap &= ~bit;
+                }
+            }
+
+            static size_t memory_usage(const node *n)
+            {
+                if(!n)
+                    return 0;
+
+                //The control block of make_shared is approximated with two counters.
+                size_t ret = sizeof(node) + 2 * sizeof(long) + n->data.capacity() * sizeof(value_type) + n->nodes.capacity() * sizeof(node_ptr);
+                for (auto &&e : n->nodes)
+                    ret += memory_usage(e.get());
+
+                return ret;
+            }
+
+            node_ptr m_Root;
+            size_t m_Size;
+    };
+} // namespace DiscordBot
+
+
+#endif //PERSISTENT_MAP_HPP
@@ -0,0 +1,423 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SHARDED_MAP_HPP
+#define SHARDED_MAP_HPP
+
+#include <stddef.h>
+#include <array>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <models/snapshot_map.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Immutable snapshot of a sharded map. Holds the snapshot of every shard, so taking it only copies N pointers and never the entries.
+     * 
+     * The shards are loaded one after another, so a writer which updates two shards meanwhile may only be seen in one of them.
+     */
+    template<class Map, size_t N, class Hash>
+    class sharded_snapshot
+    {
+        public:
+            using map_type = Map;
+            using key_type = typename Map::key_type;
+            using value_type = typename Map::value_type;
+            using shard_ptr = std::shared_ptr<const Map>;
+
+            /**
+             * @brief Walks the shards in order. Only valid as long as the snapshot exists.
+             */
+            class const_iterator
+            {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = typename Map::value_type;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const value_type*;
+                    using reference = const value_type&;
+
+                    const_iterator() : m_Snapshot(nullptr), m_Shard(N) {}
+
+                    inline reference operator*() const
+                    {
+                        return *m_IT;
+                    }
+
+                    inline pointer operator->() const
+                    {
+                        return &*m_IT;
+                    }
+
+                    inline const_iterator &operator++()
+                    {
+                        ++m_IT;
+                        skip_empty();
+                        return *this;
+                    }
+
+                    inline const_iterator operator++(int)
+                    {
+                        const_iterator ret = *this;
+                        ++(*this);
+                        return ret;
+                    }
+
+                    inline bool operator==(const const_iterator &rhs) const
+                    {
+                        return m_Shard == rhs.m_Shard && (m_Shard == N || m_IT == rhs.m_IT);
+                    }
+
+                    inline bool operator!=(const const_iterator &rhs) const
+                    {
+                        return !(*this == rhs);
+                    }
+
+                private:
+                    friend class sharded_snapshot;
+
+                    const_iterator(const sharded_snapshot *snapshot, size_t shard, typename Map::const_iterator it) : m_Snapshot(snapshot), m_Shard(shard), m_IT(it) {}
+
+                    inline void skip_empty()
+                    {
+                        while (m_Shard < N && m_IT == m_Snapshot->m_Shards[m_Shard]->end())
+                        {
+                            if(++m_Shard < N)
+                                m_IT = m_Snapshot->m_Shards[m_Shard]->begin();
+                        }
+                    }
+
+                    const sharded_snapshot *m_Snapshot;
+                    size_t m_Shard;
+                    typename Map::const_iterator m_IT;
+            };
+
+            using iterator = const_iterator;
+
+            sharded_snapshot()
+            {
+                auto empty = std::make_shared<const Map>();
+                m_Shards.fill(empty);
+            }
+
+            explicit sharded_snapshot(std::array<shard_ptr, N> shards) : m_Shards(std::move(shards)) {}
+
+            /**
+             * @return Returns the index of the shard of a key.
+             */
+            static inline size_t index(const key_type &key)
+            {
+                //The shards use the lower bits of the hash for their buckets, so the shard is chosen by the upper bits.
+                return (Hash()(key) >> (sizeof(size_t) * 8 - 8)) % N;
+            }
+
+            inline const_iterator begin() const
+            {
+                const_iterator ret(this, 0, m_Shards[0]->begin());
+                ret.skip_empty();
+                return ret;
+            }
+
+            inline const_iterator end() const
+            {
+                return const_iterator();
+            }
+
+            inline const_iterator find(const key_type &key) const
+            {
+                size_t i = index(key);
+                auto IT = m_Shards[i]->find(key);
+                if(IT == m_Shards[i]->end())
+                    return end();
+
+                return const_iterator(this, i, IT);
+            }
+
+            inline size_t count(const key_type &key) const
+            {
+                return m_Shards[index(key)]->count(key);
+            }
+
+            inline size_t size() const
+            {
+                size_t ret = 0;
+                for (auto &&e : m_Shards)
+                    ret += e->size();
+
+                return ret;
+            }
+
+            inline bool empty() const
+            {
+                for (auto &&e : m_Shards)
+                {
+                    if(!e->empty())
+                        return false;
+                }
+
+                return true;
+            }
+
+            /**
+             * @return Returns the snapshot of the shard with the given index, which must be less than N.
+             */
+            inline const shard_ptr &shard_at(size_t i) const
+            {
+                return m_Shards[i];
+            }
+
+        private:
+            std::array<shard_ptr, N> m_Shards;
+    };
+
+    /**
+     * @brief snapshot_map split into N independent shards. A writer only locks and copies the shard of its key, so writers of different keys rarely wait for each other and every copy has 1/N of the entries.
+     * 
+     * A snapshot of the whole map holds the snapshots of the shards without copying any entry. @see sharded_snapshot
+     */
+    template<class K, class V, size_t N = 16, class Hash = std::hash<K>>
+    class sharded_map
+    {
+        public:
+            using shard_type = snapshot_map<K, V>;
+            using map_type = typename shard_type::map_type;
+            using value_type = typename map_type::value_type;
+            using snapshot = sharded_snapshot<map_type, N, Hash>;
+
+            sharded_map() {}
+
+            inline shard_type &shard(const K &key)
+            {
+                return m_Shards[index(key)];
+            }
+
+            inline const shard_type &shard(const K &key) const
+            {
+                return m_Shards[index(key)];
+            }
+
+            /**
+             * @return Returns the shard with the given index, which must be less than N.
+             */
+            inline shard_type &shard_at(size_t i)
+            {
+                return m_Shards[i];
+            }
+
+            inline const shard_type &shard_at(size_t i) const
+            {
+                return m_Shards[i];
+            }
+
+            /**
+             * @return Returns the index of the shard of a key.
+             */
+            static inline size_t index(const K &key)
+            {
+                return snapshot::index(key);
+            }
+
+            inline V get(const K &key) const
+            {
+                return shard(key).get(key);
+            }
+
+            inline bool contains(const K &key) const
+            {
+                return shard(key).contains(key);
+            }
+
+            /**
+             * @brief Inserts a value, if the key doesn't exist.
+             * 
+             * @return Returns false if the key already exists.
+             */
+            inline bool insert(const K &key, const V &val)
+            {
+                return shard(key).insert(key, val);
+            }
+
+            /**
+             * @brief Inserts many values with one copy per touched shard.
+             * 
+             * @param replace: True to replace existing values.
+             */
+            template<class It>
+            inline void insert(It first, It last, bool replace)
+            {
+                std::vector<value_type> groups[N];
+                for (; first != last; ++first)
+                    groups[index(first->first)].push_back(*first);
+
+                for (size_t i = 0; i < N; i++)
+                {
+                    if(groups[i].empty())
+                        continue;
+
+                    auto &group = groups[i];
+                    m_Shards[i].update([&group, replace](map_type &map)
+                    {
+                        map.reserve(map.size() + group.size());
+                        for (auto &&e : group)
+                        {
+                            if(replace)
+                                map[e.first] = e.second;
+                            else
+                                map.insert(e);
+                        }
+                    });
+                }
+            }
+
+            /**
+             * @brief Inserts or replaces a value.
+             */
+            inline void set(const K &key, const V &val)
+            {
+                shard(key).set(key, val);
+            }
+
+            /**
+             * @return Returns false if the key doesn't exist.
+             */
+            inline bool erase(const K &key)
+            {
+                return shard(key).erase(key);
+            }
+
+            /**
+             * @brief Erases many keys with one copy per touched shard.
+             */
+            template<class It>
+            inline void erase(It first, It last)
+            {
+                std::vector<K> groups[N];
+                for (; first != last; ++first)
+                    groups[index(*first)].push_back(*first);
+
+                for (size_t i = 0; i < N; i++)
+                {
+                    if(groups[i].empty())
+                        continue;
+
+                    auto &group = groups[i];
+                    m_Shards[i].update([&group](map_type &map)
+                    {
+                        for (auto &&e : group)
+                            map.erase(e);
+                    });
+                }
+            }
+
+            inline void clear()
+            {
+                for (auto &&e : m_Shards)
+                    e.clear();
+            }
+
+            inline size_t size() const
+            {
+                size_t ret = 0;
+                for (auto &&e : m_Shards)
+                    ret += e.size();
+
+                return ret;
+            }
+
+            inline bool empty() const
+            {
+                return size() == 0;
+            }
+
+            /**
+             * @return Returns the heap usage of the shard tables in bytes.
+             */
+            inline size_t memory_usage() const
+            {
+                size_t ret = 0;
+                for (auto &&e : m_Shards)
+                    ret += e.load()->memory_usage();
+
+                return ret;
+            }
+
+            /**
+             * @return Returns an immutable snapshot of all shards. No entry is copied.
+             */
+            inline snapshot load() const
+            {
+                std::array<typename snapshot::shard_ptr, N> shards;
+                for (size_t i = 0; i < N; i++)
+                    shards[i] = m_Shards[i].load();
+
+                return snapshot(std::move(shards));
+            }
+
+            /**
+             * @return Merges the shards into one map. Copies all entries, prefer load() or for_each().
+             */
+            inline operator map_type() const
+            {
+                map_type ret;
+                ret.reserve(size());
+                for (auto &&s : m_Shards)
+                {
+                    auto map = s.load();
+                    for (auto &&e : *map)
+                        ret.insert(e);
+                }
+
+                return ret;
+            }
+
+            /**
+             * @brief Calls f for every entry until f returns false. Every shard is walked on its own snapshot, so entries which are written meanwhile may or may not be visited.
+             */
+            template<class F>
+            inline void for_each(F f) const
+            {
+                for (auto &&s : m_Shards)
+                {
+                    auto map = s.load();
+                    for (auto &&e : *map)
+                    {
+                        if(!f(e))
+                            return;
+                    }
+                }
+            }
+
+            ~sharded_map() {}
+
+        private:
+            shard_type m_Shards[N];
+    };
+} // namespace DiscordBot
+
+
+#endif //SHARDED_MAP_HPP
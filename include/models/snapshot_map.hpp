@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SNAPSHOT_MAP_HPP
+#define SNAPSHOT_MAP_HPP
+
+#include <models/persistent_map.hpp>
+#include <memory>
+#include <mutex>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Read-copy-update map. Readers get an immutable snapshot, writers publish a new version and never block the readers of older versions.
+     * Old snapshots stay valid as long as someone holds them.
+     * 
+     * The default persistent_map shares its nodes between the versions, so a write only copies the path to its key. With another map type every write copies the whole map.
+     * Readers only lock to copy the pointer of the current version, the lock belongs to this map and isn't shared with others.
+     * 
+     * Use update() to apply multiple changes with one publish.
+     */
+    template<class K, class V, class Map = persistent_map<K, V>>
+    class snapshot_map
+    {
+        public:
+            using map_type = Map;
+            using snapshot = std::shared_ptr<const Map>;
+
+            snapshot_map() : m_Map(std::make_shared<const Map>()) {}
+            snapshot_map(const snapshot_map &val) : m_Map(val.load()) {}
+
+            inline snapshot_map &operator=(const snapshot_map &val)
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+                publish(val.load());
+
+                return *this;
+            }
+
+            inline snapshot_map &operator=(const Map &val)
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+                publish(std::make_shared<const Map>(val));
+
+                return *this;
+            }
+
+            /**
+             * @return Returns the current version of the map. The snapshot never changes.
+             */
+            inline snapshot load() const
+            {
+                std::lock_guard<std::mutex> lock(m_ReadLock);
+                return m_Map;
+            }
+
+            inline operator Map() const
+            {
+                return *load();
+            }
+
+            /**
+             * @return Returns the value of a key or a default constructed value, if the key doesn't exist.
+             */
+            inline V get(const K &key) const
+            {
+                auto map = load();
+                auto IT = map->find(key);
+                if(IT == map->end())
+                    return V();
+
+                return IT->second;
+            }
+
+            inline bool contains(const K &key) const
+            {
+                auto map = load();
+                return map->find(key) != map->end();
+            }
+
+            inline size_t size() const
+            {
+                return load()->size();
+            }
+
+            inline bool empty() const
+            {
+                return load()->empty();
+            }
+
+            /**
+             * @brief Inserts a value, if the key doesn't exist.
+             * 
+             * @return Returns false if the key already exists.
+             */
+            inline bool insert(const K &key, const V &val)
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+                if(m_Map->find(key) != m_Map->end())
+                    return false;
+
+                Map map = *m_Map;
+                map.insert({key, val});
+                publish(std::make_shared<const Map>(std::move(map)));
+
+                return true;
+            }
+
+            /**
+             * @brief Inserts or replaces a value.
+             */
+            inline void set(const K &key, const V &val)
+            {
+                update([&key, &val](Map &map)
+                {
+                    map[key] = val;
+                });
+            }
+
+            /**
+             * @return Returns false if the key doesn't exist.
+             */
+            inline bool erase(const K &key)
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+                if(m_Map->find(key) == m_Map->end())
+                    return false;
+
+                Map map = *m_Map;
+                map.erase(key);
+                publish(std::make_shared<const Map>(std::move(map)));
+
+                return true;
+            }
+
+            inline void clear()
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+                publish(std::make_shared<const Map>());
+            }
+
+            /**
+             * @brief Calls f with a copy of the current version and publishes the modified copy.
+             */
+            template<class F>
+            inline void update(F f)
+            {
+                std::lock_guard<std::mutex> lock(m_WriteLock);
+
+                Map map = *m_Map;
+                f(map);
+                publish(std::make_shared<const Map>(std::move(map)));
+            }
+
+            ~snapshot_map() {}
+
+        private:
+            /**
+             * @brief Replaces the current version. The old version is released outside of the read lock.
+             */
+            inline void publish(snapshot map)
+            {
+                std::lock_guard<std::mutex> lock(m_ReadLock);
+                m_Map.swap(map);
+            }
+
+            std::mutex m_WriteLock;             //!< Serializes the writers. The current version may be read under it without the read lock.
+            mutable std::mutex m_ReadLock;      //!< Guards the pointer of the current version.
+            snapshot m_Map;
+    };
+} // namespace DiscordBot
+
+
+#endif //SNAPSHOT_MAP_HPP
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SNOWFLAKE_HPP
+#define SNOWFLAKE_HPP
+
+#include <stdint.h>
+#include <string>
+#include <iostream>
+#include <functional>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Discord id. Stored as 64-bit integer and only formatted if needed. For more info see <a href="https://discord.com/developers/docs/reference#snowflakes">here</a>.
+     * 
+     * The string constructors are explicit, because invalid strings result in an empty snowflake. Use try_parse for input which may be invalid.
+     */
+    class snowflake
+    {
+        public:
+            static const uint64_t DISCORD_EPOCH = 1420070400000ULL;
+
+            constexpr snowflake() noexcept : m_Value(0) {}
+            constexpr snowflake(uint64_t val) noexcept : m_Value(val) {}
+            explicit snowflake(const std::string &val) noexcept : m_Value(parse(val.data(), val.size())) {}
+            explicit snowflake(const char *val) noexcept : m_Value(parse(val, std::char_traits<char>::length(val))) {}
+
+            /**
+             * @brief Parses a decimal id.
+             * 
+             * @return Returns 0 if the string isn't a valid id.
+             */
+            static inline uint64_t parse(const char *str, size_t len) noexcept
+            {
+                //An uint64 has at most 20 digits.
+                if(len == 0 || len > 20)
+                    return 0;
+
+                uint64_t ret = 0;
+                for (size_t i = 0; i < len; i++)
+                {
+                    unsigned digit = (unsigned)(str[i] - '0');
+                    if(digit > 9)
+                        return 0;
+
+                    //The value doesn't fit into 64 bits.
+                    if(ret > (UINT64_MAX - digit) / 10)
+                        return 0;
+
+                    ret = ret * 10 + digit;
+                }
+
+                return ret;
+            }
+
+            /**
+             * @brief Parses a decimal id and reports invalid input, instead of returning an empty snowflake.
+             * 
+             * @return Returns false if the string isn't a valid id. out is only changed on success.
+             */
+            static inline bool try_parse(const std::string &str, snowflake &out) noexcept
+            {
+                uint64_t val = parse(str.data(), str.size());
+                if(val == 0)
+                    return false;
+
+                out = snowflake(val);
+                return true;
+            }
+
+            constexpr uint64_t value() const noexcept
+            {
+                return m_Value;
+            }
+
+            constexpr bool empty() const noexcept
+            {
+                return m_Value == 0;
+            }
+
+            /**
+             * @return Returns the creation time of the id in milliseconds since the unix epoch.
+             */
+            constexpr uint64_t timestamp() const noexcept
+            {
+                return (m_Value >> 22) + DISCORD_EPOCH;
+            }
+
+            /**
+             * @return Returns the decimal representation or an empty string, if the snowflake is empty.
+             */
+            inline std::string str() const
+            {
+                if(m_Value == 0)
+                    return "";
+
+                char buf[20];
+                char *end = buf + sizeof(buf);
+                char *beg = end;
+
+                uint64_t val = m_Value;
+                while (val != 0)
+                {
+                    *--beg = (char)('0' + val % 10);
+                    val /= 10;
+                }
+
+                return std::string(beg, end);
+            }
+
+        private:
+            uint64_t m_Value;
+    };
+
+    constexpr bool operator==(snowflake lhs, snowflake rhs) noexcept
+    {
+        return lhs.value() == rhs.value();
+    }
+
+    constexpr bool operator!=(snowflake lhs, snowflake rhs) noexcept
+    {
+        return lhs.value() != rhs.value();
+    }
+
+    constexpr bool operator<(snowflake lhs, snowflake rhs) noexcept
+    {
+        return lhs.value() < rhs.value();
+    }
+
+    constexpr bool operator>(snowflake lhs, snowflake rhs) noexcept
+    {
+        return lhs.value() > rhs.value();
+    }
+
+    inline std::string operator+(const std::string &lhs, snowflake rhs)
+    {
+        return lhs + rhs.str();
+    }
+
+    inline std::string operator+(snowflake lhs, const std::string &rhs)
+    {
+        return lhs.str() + rhs;
+    }
+
+    inline std::ostream &operator<<(std::ostream &of, snowflake rhs)
+    {
+        of << rhs.str();
+        return of;
+    }
+} // namespace DiscordBot
+
+namespace std
+{
+    template<>
+    struct hash<DiscordBot::snowflake>
+    {
+        inline size_t operator()(DiscordBot::snowflake val) const noexcept
+        {
+            //The lower bits of an id are a counter and the worker ids, the upper bits a timestamp. Mixes both to spread the ids over the buckets.
+            uint64_t x = val.value();
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            return (size_t)x;
+        }
+    };
+} // namespace std
+
+#endif //SNOWFLAKE_HPP
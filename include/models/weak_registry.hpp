@@ -0,0 +1,579 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef WEAK_REGISTRY_HPP
+#define WEAK_REGISTRY_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <models/persistent_map.hpp>
+#include <models/sharded_map.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Registry of shared objects by key, which only holds weak references. An object lives as long as someone else owns it or the entry is pinned.
+     * 
+     * Entries of released objects stay in the registry until sweep() removes them in steps of bounded size. While pinning is enabled, every added object is pinned.
+     * While journaling is enabled, the keys of added objects are recorded, so the owner can process new entries without walking all entries. @see take_added
+     */
+    template<class K, class T, size_t N = 16, class Hash = std::hash<K>>
+    class weak_registry
+    {
+        public:
+            using value_ptr = std::shared_ptr<T>;
+            using map_type = persistent_map<K, value_ptr, Hash>;
+            using value_type = typename map_type::value_type;
+
+            struct entry
+            {
+                std::weak_ptr<T> ref;
+                value_ptr pin;      //!< Strong reference of a pinned entry.
+
+                inline value_ptr lock() const
+                {
+                    return pin ? pin : ref.lock();
+                }
+
+                inline bool alive() const
+                {
+                    return pin || !ref.expired();
+                }
+            };
+
+        private:
+            using shard_map = sharded_map<K, entry, N, Hash>;
+            using entry_map = typename shard_map::map_type;
+
+        public:
+            /**
+             * @brief Immutable snapshot of the registry. Holds the snapshots of the shards, so taking it never copies the entries.
+             * 
+             * The objects are locked when they are reached, entries of objects which are released by then are skipped.
+             */
+            class snapshot
+            {
+                public:
+                    using key_type = K;
+                    using value_type = typename weak_registry::value_type;
+
+                    /**
+                     * @brief Walks the living objects. Dereferencing returns the entry by value, the iterator holds a strong reference of the current object.
+                     */
+                    class const_iterator
+                    {
+                        public:
+                            using iterator_category = std::input_iterator_tag;
+                            using value_type = typename weak_registry::value_type;
+                            using difference_type = std::ptrdiff_t;
+                            using pointer = const value_type*;
+                            using reference = value_type;
+
+                            const_iterator() {}
+
+                            inline reference operator*() const
+                            {
+                                return value_type(m_IT->first, m_Obj);
+                            }
+
+                            inline const value_ptr &object() const
+                            {
+                                return m_Obj;
+                            }
+
+                            inline const_iterator &operator++()
+                            {
+                                ++m_IT;
+                                skip_released();
+                                return *this;
+                            }
+
+                            inline bool operator==(const const_iterator &rhs) const
+                            {
+                                return m_IT == rhs.m_IT;
+                            }
+
+                            inline bool operator!=(const const_iterator &rhs) const
+                            {
+                                return m_IT != rhs.m_IT;
+                            }
+
+                        private:
+                            friend class snapshot;
+                            using entry_iterator = typename shard_map::snapshot::const_iterator;
+
+                            explicit const_iterator(entry_iterator it) : m_IT(it)
+                            {
+                                skip_released();
+                            }
+
+                            inline void skip_released()
+                            {
+                                m_Obj = nullptr;
+                                for (; m_IT != entry_iterator(); ++m_IT)
+                                {
+                                    m_Obj = m_IT->second.lock();
+                                    if(m_Obj)
+                                        break;
+                                }
+                            }
+
+                            entry_iterator m_IT;
+                            value_ptr m_Obj;
+                    };
+
+                    using iterator = const_iterator;
+
+                    snapshot() {}
+                    explicit snapshot(typename shard_map::snapshot entries) : m_Entries(std::move(entries)) {}
+
+                    inline const_iterator begin() const
+                    {
+                        return const_iterator(m_Entries.begin());
+                    }
+
+                    inline const_iterator end() const
+                    {
+                        return const_iterator();
+                    }
+
+                    inline const_iterator find(const K &key) const
+                    {
+                        const_iterator ret(m_Entries.find(key));
+                        if(ret != end() && !(ret.m_IT->first == key))
+                            return end();
+
+                        return ret;
+                    }
+
+                    /**
+                     * @return Returns the object of a key or null if the key doesn't exist or the object is released.
+                     */
+                    inline value_ptr get(const K &key) const
+                    {
+                        auto IT = m_Entries.find(key);
+                        return IT == m_Entries.end() ? value_ptr() : IT->second.lock();
+                    }
+
+                    inline size_t count(const K &key) const
+                    {
+                        return get(key) ? 1 : 0;
+                    }
+
+                    /**
+                     * @return Returns the number of entries, including released objects which weren't swept when the snapshot was taken.
+                     */
+                    inline size_t size() const
+                    {
+                        return m_Entries.size();
+                    }
+
+                    inline bool empty() const
+                    {
+                        return begin() == end();
+                    }
+
+                private:
+                    typename shard_map::snapshot m_Entries;
+            };
+
+            weak_registry() : m_Pinning(false), m_Journaling(false), m_SweepShard(0), m_SweepHash(0), m_SweepResume(false) {}
+
+            /**
+             * @return Returns the object of a key or null if the key doesn't exist or the object is released.
+             */
+            inline value_ptr get(const K &key) const
+            {
+                return m_Entries.get(key).lock();
+            }
+
+            inline bool contains(const K &key) const
+            {
+                return m_Entries.get(key).alive();
+            }
+
+            /**
+             * @brief Adds an object, if the key has no living object.
+             * 
+             * @return Returns the object of the registry, which is val or the object another caller added first.
+             */
+            inline value_ptr insert(const K &key, const value_ptr &val)
+            {
+                bool pin = m_Pinning;
+                entry old = m_Entries.get(key);
+                value_ptr ret = old.lock();
+                if(ret && (old.pin || !pin))
+                    return ret;
+
+                bool added = false;
+                m_Entries.shard(key).update([&key, &val, &ret, &added, pin](entry_map &map)
+                {
+                    entry &e = map[key];
+                    ret = e.lock();
+                    if(!ret)
+                    {
+                        ret = val;
+                        e.ref = val;
+                        added = true;
+                    }
+
+                    if(pin)
+                        e.pin = ret;
+                });
+
+                if(added)
+                    journal(&key, &key + 1);
+
+                return ret;
+            }
+
+            /**
+             * @brief Adds or replaces an object.
+             */
+            inline void set(const K &key, const value_ptr &val)
+            {
+                bool pin = m_Pinning;
+                m_Entries.shard(key).update([&key, &val, pin](entry_map &map)
+                {
+                    entry &e = map[key];
+                    e.ref = val;
+                    e.pin = pin ? val : value_ptr();
+                });
+
+                journal(&key, &key + 1);
+            }
+
+            /**
+             * @brief Adds many objects with one copy per touched shard.
+             * 
+             * @param replace: True to replace living objects.
+             */
+            template<class It>
+            inline void insert(It first, It last, bool replace)
+            {
+                std::vector<value_type> groups[N];
+                for (; first != last; ++first)
+                    groups[shard_map::index(first->first)].push_back(*first);
+
+                bool pin = m_Pinning;
+                std::vector<K> added;
+                for (size_t i = 0; i < N; i++)
+                {
+                    if(groups[i].empty())
+                        continue;
+
+                    auto &group = groups[i];
+                    bool journaling = m_Journaling;
+                    m_Entries.shard_at(i).update([&group, &added, replace, pin, journaling](entry_map &map)
+                    {
+                        map.reserve(map.size() + group.size());
+                        for (auto &&g : group)
+                        {
+                            entry &e = map[g.first];
+                            if(!replace && e.alive())
+                                continue;
+
+                            e.ref = g.second;
+                            e.pin = pin ? g.second : value_ptr();
+                            if(journaling)
+                                added.push_back(g.first);
+                        }
+                    });
+                }
+
+                journal(added.begin(), added.end());
+            }
+
+            /**
+             * @return Returns false if the key doesn't exist.
+             */
+            inline bool erase(const K &key)
+            {
+                return m_Entries.erase(key);
+            }
+
+            inline void clear()
+            {
+                m_Entries.clear();
+            }
+
+            /**
+             * @brief Keeps the object of a key alive until it is unpinned.
+             * 
+             * @return Returns false if the key has no living object.
+             */
+            inline bool pin(const K &key)
+            {
+                bool ret = false;
+                m_Entries.shard(key).update([&key, &ret](entry_map &map)
+                {
+                    auto IT = map.find(key);
+                    if(IT != map.end())
+                    {
+                        IT->second.pin = IT->second.lock();
+                        ret = IT->second.pin != nullptr;
+                    }
+                });
+
+                return ret;
+            }
+
+            /**
+             * @brief Removes the strong references of many keys with one copy per touched shard. The objects are released, if nobody else owns them.
+             */
+            template<class It>
+            inline void unpin(It first, It last)
+            {
+                std::vector<K> groups[N];
+                for (; first != last; ++first)
+                    groups[shard_map::index(*first)].push_back(*first);
+
+                for (size_t i = 0; i < N; i++)
+                {
+                    if(groups[i].empty())
+                        continue;
+
+                    auto &group = groups[i];
+                    m_Entries.shard_at(i).update([&group](entry_map &map)
+                    {
+                        for (auto &&e : group)
+                        {
+                            auto IT = map.find(e);
+                            if(IT != map.end())
+                                IT->second.pin = nullptr;
+                        }
+                    });
+                }
+            }
+
+            /**
+             * @brief Enables or disables the pinning of new objects. Enabling pins all living objects, disabling unpins all objects.
+             */
+            inline void set_pinning(bool pin)
+            {
+                m_Pinning = pin;
+                for (size_t i = 0; i < N; i++)
+                {
+                    m_Entries.shard_at(i).update([pin](entry_map &map)
+                    {
+                        for (auto &&e : map)
+                            e.second.pin = pin ? e.second.ref.lock() : value_ptr();
+                    });
+                }
+            }
+
+            inline bool pinning() const
+            {
+                return m_Pinning;
+            }
+
+            /**
+             * @brief Enables or disables the journal of added objects. Disabling drops the recorded keys.
+             */
+            inline void set_journaling(bool enable)
+            {
+                std::lock_guard<std::mutex> lock(m_JournalLock);
+                m_Journaling = enable;
+                if(!enable)
+                    std::vector<K>().swap(m_Journal);
+            }
+
+            /**
+             * @return Returns the keys of the objects, which were added or replaced since the last call. A key may be returned multiple times.
+             */
+            inline std::vector<K> take_added()
+            {
+                std::vector<K> ret;
+                std::lock_guard<std::mutex> lock(m_JournalLock);
+                ret.swap(m_Journal);
+
+                return ret;
+            }
+
+            /**
+             * @brief Removes the entries of released objects. Every step checks at most step entries of one shard and erases the released ones with one copy of the shard.
+             * The walk continues at the position where the previous call stopped and ends after all shards were walked once or once the time budget is used up.
+             * 
+             * @param budget: Time after which no further step is started.
+             * @param step: Maximum number of entries which are checked per step.
+             * @param reclaimed: Receives the keys of the removed entries, may be null.
+             * 
+             * @return Returns the number of removed entries.
+             */
+            inline size_t sweep(std::chrono::microseconds budget, size_t step, std::vector<K> *reclaimed = nullptr)
+            {
+                std::lock_guard<std::mutex> lock(m_SweepLock);
+                auto deadline = std::chrono::steady_clock::now() + budget;
+                size_t ret = 0;
+
+                if(step == 0)
+                    step = 1;
+
+                for (size_t done = 0; done < N; )
+                {
+                    auto &shard = m_Entries.shard_at(m_SweepShard);
+
+                    //Only steps with released objects write the shard.
+                    std::vector<K> released;
+                    bool finished;
+                    {
+                        auto map = shard.load();
+                        auto IT = m_SweepResume ? map->seek(m_SweepHash) : map->begin();
+                        for (size_t i = 0; i < step && IT != map->end(); ++IT, i++)
+                        {
+                            if(!IT->second.alive())
+                                released.push_back(IT->first);
+                        }
+
+                        //The next call starts at the first entry which wasn't checked.
+                        finished = IT == map->end();
+                        if(!finished)
+                            m_SweepHash = entry_map::hash_of(IT->first);
+                    }
+
+                    m_SweepResume = !finished;
+                    if(finished)
+                    {
+                        m_SweepShard = (m_SweepShard + 1) % N;
+                        done++;
+                    }
+
+                    if(!released.empty())
+                    {
+                        shard.update([&ret, &released, reclaimed](entry_map &map)
+                        {
+                            for (auto &&e : released)
+                            {
+                                //The key may have received a new object meanwhile.
+                                auto IT = map.find(e);
+                                if(IT == map.end() || IT->second.alive())
+                                    continue;
+
+                                map.erase(e);
+                                if(reclaimed)
+                                    reclaimed->push_back(e);
+
+                                ret++;
+                            }
+                        });
+                    }
+
+                    if(std::chrono::steady_clock::now() >= deadline)
+                        break;
+                }
+
+                return ret;
+            }
+
+            /**
+             * @return Returns the number of entries, including released objects which aren't swept yet.
+             */
+            inline size_t size() const
+            {
+                return m_Entries.size();
+            }
+
+            /**
+             * @return Returns the heap usage of the entry tables in bytes.
+             */
+            inline size_t memory_usage() const
+            {
+                return m_Entries.memory_usage();
+            }
+
+            /**
+             * @return Returns an immutable snapshot of all shards. No entry is copied.
+             */
+            inline snapshot load() const
+            {
+                return snapshot(m_Entries.load());
+            }
+
+            /**
+             * @return Returns a map of all living objects. Copies all entries, prefer load() or for_each().
+             */
+            inline operator map_type() const
+            {
+                map_type ret;
+                for_each([&ret](const value_type &e)
+                {
+                    ret.insert(e);
+                    return true;
+                });
+
+                return ret;
+            }
+
+            /**
+             * @brief Calls f for every living object until f returns false. @see sharded_map::for_each
+             */
+            template<class F>
+            inline void for_each(F f) const
+            {
+                m_Entries.for_each([&f](const typename entry_map::value_type &e)
+                {
+                    value_ptr obj = e.second.lock();
+                    if(!obj)
+                        return true;
+
+                    return f(value_type(e.first, obj));
+                });
+            }
+
+            ~weak_registry() {}
+
+        private:
+            template<class It>
+            inline void journal(It first, It last)
+            {
+                if(!m_Journaling || first == last)
+                    return;
+
+                std::lock_guard<std::mutex> lock(m_JournalLock);
+                if(m_Journaling)
+                    m_Journal.insert(m_Journal.end(), first, last);
+            }
+
+            shard_map m_Entries;
+            std::atomic<bool> m_Pinning;
+            std::atomic<bool> m_Journaling;
+            std::mutex m_JournalLock;
+            std::vector<K> m_Journal;
+
+            std::mutex m_SweepLock;
+            size_t m_SweepShard;        //!< Shard of the next sweep step.
+            uint64_t m_SweepHash;       //!< Position of the next sweep step in the shard. @see persistent_map::seek
+            bool m_SweepResume;         //!< False if the next step starts at the begin of the shard.
+    };
+} // namespace DiscordBot
+
+
+#endif //WEAK_REGISTRY_HPP
@@ -49,7 +49,7 @@ namespace DiscordBot
 
         CommandsConfig cfg = m_Controller->GetCmdConfig();
         if(cfg)
-            cfg->AddRoles(ctx->Msg->GuildRef->ID, Cmd, RoleIDs);
+            cfg->AddRoles(ctx->Msg->GuildRef->ID.load().str(), Cmd, RoleIDs);
     }
 
     void CRightsCommand::RemoveRoles(CommandContext ctx)
@@ -64,7 +64,7 @@ namespace DiscordBot
 
         CommandsConfig cfg = m_Controller->GetCmdConfig();
         if(cfg)
-            cfg->RemoveRoles(ctx->Msg->GuildRef->ID, Cmd, RoleIDs);
+            cfg->RemoveRoles(ctx->Msg->GuildRef->ID.load().str(), Cmd, RoleIDs);
     }
 
     void CRightsCommand::RemoveAllRoles(CommandContext ctx)
@@ -81,7 +81,7 @@ namespace DiscordBot
 
         CommandsConfig cfg = m_Controller->GetCmdConfig();
         if(cfg)
-            cfg->DeleteCommand(ctx->Msg->GuildRef->ID, Cmd);
+            cfg->DeleteCommand(ctx->Msg->GuildRef->ID.load().str(), Cmd);
     }
 
     void CRightsCommand::GetRoles(CommandContext ctx)
@@ -99,16 +99,16 @@ namespace DiscordBot
         CommandsConfig cfg = m_Controller->GetCmdConfig();
         if(cfg)
         {
-            std::vector<std::string> Roles = cfg->GetRoles(ctx->Msg->GuildRef->ID, Cmd);
+            std::vector<std::string> Roles = cfg->GetRoles(ctx->Msg->GuildRef->ID.load().str(), Cmd);
             std::string Msg;
             for (auto &&e : Roles)
             {
                 if(!Msg.empty())
                     Msg += ", ";
 
-                auto IT = ctx->Msg->GuildRef->Roles->find(e);
-                if(IT != ctx->Msg->GuildRef->Roles->end())
-                    Msg += IT->second->Name;
+                Role role = ctx->Msg->GuildRef->Roles.get(snowflake(e));
+                if(role)
+                    Msg += role->Name;
             }
 
             if(Msg.empty())
@@ -120,14 +120,16 @@ namespace DiscordBot
 
     std::string CRightsCommand::GetRoleID(Guild guild, const std::string &RoleName)
     {
-        auto IT = guild->Roles->find(RoleName);
-        if(IT != guild->Roles->end())
+        //The parameter is user input, which is either an id or a name.
+        snowflake ID;
+        auto Roles = guild->Roles.load();
+        if(snowflake::try_parse(RoleName, ID) && Roles->find(ID) != Roles->end())
             return RoleName;
 
-        for (auto &&e : guild->Roles.load())
+        for (auto &&e : *Roles)
         {
             if(e.second->Name == RoleName)
-                return e.second->ID;
+                return e.second->ID.str();
         }
 
         return "";
@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "BanPager.hpp"
+#include "DiscordClient.hpp"
+#include <models/DiscordException.hpp>
+#include "../helpers/JSONReader.hpp"
+
+namespace DiscordBot
+{
+    CBanPager::CBanPager(CDiscordClient *client, snowflake GuildID, size_t Limit, snowflake After, snowflake Before, bool CacheUsers) : m_Client(client), m_GuildID(GuildID), m_Limit(Limit), m_Backward(false), m_CacheUsers(CacheUsers), m_HasNext(true)
+    {
+        if(m_Limit == 0)
+            m_Limit = 1;
+        else if(m_Limit > MAX_LIMIT)
+            m_Limit = MAX_LIMIT;
+
+        if(!After.empty())
+            m_Cursor = After;
+        else if(!Before.empty())
+        {
+            m_Cursor = Before;
+            m_Backward = true;
+        }
+    }
+
+    std::vector<SBan> CBanPager::Next()
+    {
+        std::vector<SBan> ret;
+        if(!m_HasNext)
+            return ret;
+
+        std::string URL = "/guilds/" + m_GuildID + "/bans?limit=" + std::to_string(m_Limit);
+        if(!m_Cursor.empty())
+            URL += (m_Backward ? "&before=" : "&after=") + m_Cursor;
+
+        auto res = m_Client->Get(URL);
+        if(res->statusCode != 200)
+            throw CDiscordClientException("Unable to get ban list. Error: " + res->body + " HTTP Code: " + std::to_string(res->statusCode), DiscordClientErrorType::HTTP_ERROR);
+
+        //Reads the users straight from the list, without parsing every ban and user again.
+        CJSONReader Reader(res->body);
+        std::string Key;
+
+        Reader.BeginArray();
+        while (Reader.NextElement())
+        {
+            SBan Entry;
+            Reader.BeginObject();
+            while (Reader.NextKey(Key))
+            {
+                if(Key == "reason")
+                    Reader.ReadString(Entry.Reason);
+                else if(Key == "user")
+                {
+                    Reader.BeginObject();
+                    while (Reader.NextKey(Key))
+                    {
+                        if(Key == "id")
+                        {
+                            std::string ID;
+                            Reader.ReadString(ID);
+                            Entry.UserID = snowflake(ID);
+                        }
+                        else if(Key == "username")
+                            Reader.ReadString(Entry.Username);
+                        else if(Key == "discriminator")
+                            Reader.ReadString(Entry.Discriminator);
+                        else if(Key == "avatar")
+                            Reader.ReadString(Entry.Avatar);
+                        else if(Key == "bot")
+                            Reader.ReadBool(Entry.Bot);
+                        else
+                            Reader.Skip();
+                    }
+                }
+                else
+                    Reader.Skip();
+            }
+
+            if(m_CacheUsers && !Reader.Failed())
+            {
+                auto user = std::make_shared<CUser>();
+                user->ID = Entry.UserID;
+                user->Username = Entry.Username;
+                user->Discriminator = Entry.Discriminator;
+                user->Avatar = Entry.Avatar;
+                user->Bot = Entry.Bot;
+
+                Entry.UserRef = m_Client->GetUserOrAdd(user);
+            }
+
+            ret.push_back(std::move(Entry));
+        }
+
+        if(Reader.Failed())
+            throw CDiscordClientException("Unable to parse ban list. Body: " + res->body, DiscordClientErrorType::HTTP_ERROR);
+
+        //The list is sorted by the user id. The cursor is the last id in moving direction.
+        if(!ret.empty())
+            m_Cursor = m_Backward ? ret.front().UserID : ret.back().UserID;
+
+        m_HasNext = ret.size() == m_Limit;
+        return ret;
+    }
+} // namespace DiscordBot
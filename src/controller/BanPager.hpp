@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BANPAGER_HPP
+#define BANPAGER_HPP
+
+#include <controller/IBanPager.hpp>
+#include <string>
+
+namespace DiscordBot
+{
+    class CDiscordClient;
+
+    class CBanPager : public IBanPager
+    {
+        public:
+            /**
+             * @param client: Client which executes the requests.
+             * @param GuildID: Guild of the ban list.
+             * @param Limit: Entries per page.
+             * @param After: Start id for the forward direction.
+             * @param Before: Start id for the backward direction. Ignored if After is set.
+             * @param CacheUsers: True to add the users to the user cache.
+             */
+            CBanPager(CDiscordClient *client, snowflake GuildID, size_t Limit, snowflake After, snowflake Before, bool CacheUsers);
+
+            bool HasNext() override
+            {
+                return m_HasNext;
+            }
+
+            std::vector<SBan> Next() override;
+
+            ~CBanPager() {}
+
+            static const size_t MAX_LIMIT = 1000;  //!< Maximum page size of discord.
+
+        private:
+
+            CDiscordClient *m_Client;
+            snowflake m_GuildID;
+            size_t m_Limit;
+            snowflake m_Cursor;
+            bool m_Backward;
+            bool m_CacheUsers;
+            bool m_HasNext;
+    };
+} // namespace DiscordBot
+
+
+#endif //BANPAGER_HPP
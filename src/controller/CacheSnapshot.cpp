@@ -0,0 +1,596 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "CacheSnapshot.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include <Log.hpp>
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    namespace
+    {
+        const char MAGIC[4] = {'L', 'D', 'B', 'S'};
+        const uint32_t ENDIAN_MARK = 0x01020304;
+
+        //Smallest possible size of the entries in bytes.
+        const size_t MIN_USER_SIZE = 35;
+        const size_t MIN_GUILD_SIZE = 33;
+        const size_t MIN_ROLE_SIZE = 29;
+        const size_t MIN_CHANNEL_SIZE = 79;
+        const size_t MIN_OVERWRITE_SIZE = 28;
+        const size_t MIN_MEMBER_SIZE = 33;
+
+        const uint8_t HASH_VALID = 1;
+        const uint8_t HASH_ANIMATED = 2;
+
+        class CWriter
+        {
+            public:
+                template<class T>
+                inline void Put(T Val)
+                {
+                    m_Buffer.append((const char*)&Val, sizeof(T));
+                }
+
+                inline void PutID(snowflake ID)
+                {
+                    Put<uint64_t>(ID.value());
+                }
+
+                inline void PutString(const std::string &Str)
+                {
+                    Put<uint32_t>((uint32_t)Str.size());
+                    m_Buffer.append(Str);
+                }
+
+                inline void PutHash(const image_hash &Hash)
+                {
+                    if(Hash.empty())
+                    {
+                        Put<uint8_t>(0);
+                        return;
+                    }
+
+                    Put<uint8_t>(HASH_VALID | (Hash.animated() ? HASH_ANIMATED : 0));
+                    m_Buffer.append((const char*)Hash.data(), 16);
+                }
+
+                /**
+                 * @brief Writes the index of the string in the string table. Every interned string is only stored once.
+                 */
+                inline void PutInterned(const interned_string &Str)
+                {
+                    const std::string *Key = &(const std::string&)Str;
+                    auto IT = m_Index.find(Key);
+                    if(IT == m_Index.end())
+                    {
+                        IT = m_Index.insert({Key, (uint32_t)m_Strings.size()}).first;
+                        m_Strings.push_back(Key);
+                    }
+
+                    Put<uint32_t>(IT->second);
+                }
+
+                inline const std::string &GetBuffer() const
+                {
+                    return m_Buffer;
+                }
+
+                inline const std::vector<const std::string*> &GetStrings() const
+                {
+                    return m_Strings;
+                }
+
+            private:
+                std::string m_Buffer;
+                std::unordered_map<const std::string*, uint32_t> m_Index;
+                std::vector<const std::string*> m_Strings;
+        };
+
+        /**
+         * @brief Bounds checked reader. After the first read past the end all values are zero and Failed() returns true.
+         */
+        class CReader
+        {
+            public:
+                CReader(const char *Data, size_t Size) : m_Pos(Data), m_End(Data + Size), m_Failed(false) {}
+
+                template<class T>
+                inline T Get()
+                {
+                    T Ret = T();
+                    if(!Need(sizeof(T)))
+                        return Ret;
+
+                    memcpy(&Ret, m_Pos, sizeof(T));
+                    m_Pos += sizeof(T);
+                    return Ret;
+                }
+
+                inline snowflake GetID()
+                {
+                    return Get<uint64_t>();
+                }
+
+                inline std::string GetString()
+                {
+                    uint32_t Len = Get<uint32_t>();
+                    if(!Need(Len))
+                        return "";
+
+                    std::string Ret(m_Pos, Len);
+                    m_Pos += Len;
+                    return Ret;
+                }
+
+                inline image_hash GetHash()
+                {
+                    uint8_t Flags = Get<uint8_t>();
+                    if((Flags & HASH_VALID) == 0 || !Need(16))
+                        return image_hash();
+
+                    image_hash Ret((const uint8_t*)m_Pos, (Flags & HASH_ANIMATED) != 0);
+                    m_Pos += 16;
+                    return Ret;
+                }
+
+                inline interned_string GetInterned(const std::vector<interned_string> &Strings)
+                {
+                    uint32_t Index = Get<uint32_t>();
+                    if(Index >= Strings.size())
+                    {
+                        m_Failed = true;
+                        return interned_string();
+                    }
+
+                    return Strings[Index];
+                }
+
+                /**
+                 * @brief Reads the size of an array. Sizes which can't fit into the rest of the file fail the read, so a damaged file never allocates huge arrays.
+                 * 
+                 * @param MinSize: Minimum size of one entry in bytes.
+                 */
+                inline uint32_t GetCount(size_t MinSize)
+                {
+                    uint32_t Count = Get<uint32_t>();
+                    if((size_t)(m_End - m_Pos) / MinSize < Count)
+                    {
+                        m_Failed = true;
+                        m_Pos = m_End;
+                        return 0;
+                    }
+
+                    return Count;
+                }
+
+                inline bool Failed() const
+                {
+                    return m_Failed;
+                }
+
+            private:
+                inline bool Need(size_t Size)
+                {
+                    if(m_Failed || (size_t)(m_End - m_Pos) < Size)
+                    {
+                        m_Failed = true;
+                        m_Pos = m_End;
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                const char *m_Pos;
+                const char *m_End;
+                bool m_Failed;
+        };
+
+        void WriteUser(CWriter &Writer, const User &Usr)
+        {
+            Writer.PutID(Usr->ID);
+            Writer.PutString(Usr->Username);
+            Writer.PutString(Usr->Discriminator);
+            Writer.PutHash(Usr->Avatar);
+            Writer.PutInterned(Usr->Locale);
+            Writer.PutString(Usr->Email);
+            Writer.Put<uint32_t>((uint32_t)Usr->Flags);
+            Writer.Put<uint32_t>((uint32_t)Usr->PublicFlags);
+            Writer.Put<uint8_t>(Usr->Bot | (Usr->System << 1) | (Usr->MFAEnabled << 2) | (Usr->Verified << 3));
+            Writer.Put<uint8_t>((uint8_t)Usr->PremiumType);
+        }
+
+        User ReadUser(CReader &Reader, const std::vector<interned_string> &Strings)
+        {
+            auto Ret = std::make_shared<CUser>();
+            Ret->ID = Reader.GetID();
+            Ret->Username = Reader.GetString();
+            Ret->Discriminator = Reader.GetString();
+            Ret->Avatar = Reader.GetHash();
+            Ret->Locale = Reader.GetInterned(Strings);
+            Ret->Email = Reader.GetString();
+            Ret->Flags = (UserFlags)Reader.Get<uint32_t>();
+            Ret->PublicFlags = (UserFlags)Reader.Get<uint32_t>();
+
+            uint8_t Bits = Reader.Get<uint8_t>();
+            Ret->Bot = (Bits & 1) != 0;
+            Ret->System = (Bits & 2) != 0;
+            Ret->MFAEnabled = (Bits & 4) != 0;
+            Ret->Verified = (Bits & 8) != 0;
+            Ret->PremiumType = (PremiumTypes)Reader.Get<uint8_t>();
+
+            return Ret;
+        }
+
+        void WriteRole(CWriter &Writer, const Role &Value)
+        {
+            Writer.PutID(Value->ID);
+            Writer.PutString(Value->Name);
+            Writer.Put<uint32_t>(Value->Color);
+            Writer.Put<int32_t>(Value->Position);
+            Writer.Put<uint64_t>((uint64_t)Value->Permissions);
+            Writer.Put<uint8_t>(Value->Hoist | (Value->Managed << 1) | (Value->Mentionable << 2));
+        }
+
+        Role ReadRole(CReader &Reader, const std::shared_ptr<arena> &Arena)
+        {
+            auto Ret = arena_make_shared<CRole>(Arena);
+            Ret->ID = Reader.GetID();
+            Ret->Name = Reader.GetString();
+            Ret->Color = Reader.Get<uint32_t>();
+            Ret->Position = Reader.Get<int32_t>();
+            Ret->Permissions = (Permission)Reader.Get<uint64_t>();
+
+            uint8_t Bits = Reader.Get<uint8_t>();
+            Ret->Hoist = (Bits & 1) != 0;
+            Ret->Managed = (Bits & 2) != 0;
+            Ret->Mentionable = (Bits & 4) != 0;
+
+            return Ret;
+        }
+
+        void WriteChannel(CWriter &Writer, const Channel &Value)
+        {
+            Writer.PutID(Value->ID);
+            Writer.Put<uint8_t>((uint8_t)Value->Type);
+            Writer.Put<int32_t>(Value->Position);
+
+            Writer.Put<uint32_t>((uint32_t)Value->Overwrites.size());
+            for (auto &&e : Value->Overwrites)
+            {
+                Writer.PutID(e->ID);
+                Writer.PutInterned(e->Type);
+                Writer.Put<uint64_t>((uint64_t)e->Allow);
+                Writer.Put<uint64_t>((uint64_t)e->Deny);
+            }
+
+            Writer.PutString(Value->Name);
+            Writer.PutString(Value->Topic);
+            Writer.Put<uint8_t>(Value->NSFW);
+            Writer.PutID(Value->LastMessageID);
+            Writer.Put<int32_t>(Value->Bitrate);
+            Writer.Put<int32_t>(Value->UserLimit);
+            Writer.Put<int32_t>(Value->RateLimit);
+            Writer.PutHash(Value->Icon);
+            Writer.PutID(Value->OwnerID);
+            Writer.PutID(Value->AppID);
+            Writer.PutID(Value->ParentID);
+            Writer.Put<int64_t>(Value->LastPinTimestamp);
+        }
+
+        Channel ReadChannel(CReader &Reader, const std::vector<interned_string> &Strings, snowflake GuildID, const std::shared_ptr<arena> &Arena)
+        {
+            auto Ret = arena_make_shared<CChannel>(Arena);
+            Ret->ID = Reader.GetID();
+            Ret->GuildID = GuildID;
+            Ret->Type = (ChannelTypes)Reader.Get<uint8_t>();
+            Ret->Position = Reader.Get<int32_t>();
+
+            uint32_t Count = Reader.GetCount(MIN_OVERWRITE_SIZE);
+            Ret->Overwrites.reserve(Count);
+            for (uint32_t i = 0; i < Count; i++)
+            {
+                auto Overwrite = arena_make_shared<CPermissionOverwrites>(Arena);
+                Overwrite->ID = Reader.GetID();
+                Overwrite->Type = Reader.GetInterned(Strings);
+                Overwrite->Allow = (Permission)Reader.Get<uint64_t>();
+                Overwrite->Deny = (Permission)Reader.Get<uint64_t>();
+                Ret->Overwrites.push_back(Overwrite);
+            }
+
+            Ret->Name = Reader.GetString();
+            Ret->Topic = Reader.GetString();
+            Ret->NSFW = Reader.Get<uint8_t>() != 0;
+            Ret->LastMessageID = Reader.GetID();
+            Ret->Bitrate = Reader.Get<int32_t>();
+            Ret->UserLimit = Reader.Get<int32_t>();
+            Ret->RateLimit = Reader.Get<int32_t>();
+            Ret->Icon = Reader.GetHash();
+            Ret->OwnerID = Reader.GetID();
+            Ret->AppID = Reader.GetID();
+            Ret->ParentID = Reader.GetID();
+            Ret->LastPinTimestamp = Reader.Get<int64_t>();
+
+            return Ret;
+        }
+
+        void WriteMember(CWriter &Writer, const GuildMember &Member)
+        {
+            Writer.PutID(Member->UserRef->ID);
+            Writer.PutString(Member->Nick);
+
+            Writer.Put<uint32_t>((uint32_t)Member->Roles.size());
+            for (auto &&e : Member->Roles)
+                Writer.PutID(e);
+
+            Writer.Put<int64_t>(Member->JoinedAt);
+            Writer.Put<int64_t>(Member->PremiumSince);
+            Writer.Put<uint8_t>(Member->Deaf | (Member->Mute << 1));
+        }
+
+        /**
+         * @return Returns null if the user of the member isn't in the snapshot.
+         */
+        GuildMember ReadMember(CReader &Reader, const persistent_map<snowflake, User> &Users, snowflake GuildID, const std::shared_ptr<arena> &Arena)
+        {
+            auto Ret = arena_make_shared<CGuildMember>(Arena);
+            Ret->GuildID = GuildID;
+
+            snowflake UserID = Reader.GetID();
+            Ret->Nick = Reader.GetString();
+
+            uint32_t Count = Reader.GetCount(sizeof(uint64_t));
+            Ret->Roles.reserve(Count);
+            for (uint32_t i = 0; i < Count; i++)
+                Ret->Roles.push_back(Reader.GetID());
+
+            Ret->JoinedAt = Reader.Get<int64_t>();
+            Ret->PremiumSince = Reader.Get<int64_t>();
+
+            uint8_t Bits = Reader.Get<uint8_t>();
+            Ret->Deaf = (Bits & 1) != 0;
+            Ret->Mute = (Bits & 2) != 0;
+
+            auto IT = Users.find(UserID);
+            if(IT == Users.end())
+                return GuildMember();
+
+            Ret->UserRef = IT->second;
+            return Ret;
+        }
+
+        void WriteGuild(CWriter &Writer, const Guild &Value)
+        {
+            Writer.PutID(Value->ID.load());
+            Writer.PutString(Value->Name.load());
+            Writer.PutHash(Value->Icon.load());
+
+            GuildMember Owner = Value->Owner;
+            Writer.PutID((Owner && Owner->UserRef) ? Owner->UserRef->ID : snowflake());
+
+            auto Roles = Value->Roles.load();
+            Writer.Put<uint32_t>((uint32_t)Roles->size());
+            for (auto &&e : *Roles)
+                WriteRole(Writer, e.second);
+
+            auto Channels = Value->Channels.load();
+            Writer.Put<uint32_t>((uint32_t)Channels->size());
+            for (auto &&e : *Channels)
+                WriteChannel(Writer, e.second);
+
+            //Members without a user object can't be restored.
+            auto Members = Value->Members.load();
+            uint32_t Count = 0;
+            for (auto &&e : *Members)
+            {
+                if(e.second->UserRef)
+                    Count++;
+            }
+
+            Writer.Put<uint32_t>(Count);
+            for (auto &&e : *Members)
+            {
+                if(e.second->UserRef)
+                    WriteMember(Writer, e.second);
+            }
+        }
+
+        Guild ReadGuild(CReader &Reader, const std::vector<interned_string> &Strings, const persistent_map<snowflake, User> &Users)
+        {
+            Guild Ret = Guild(new CGuild());
+            snowflake ID = Reader.GetID();
+            Ret->ID = ID;
+            Ret->Name = Reader.GetString();
+            Ret->Icon = Reader.GetHash();
+            snowflake OwnerID = Reader.GetID();
+
+            uint32_t Count = Reader.GetCount(MIN_ROLE_SIZE);
+            Ret->Roles.update([&Reader, &Ret, Count](persistent_map<snowflake, Role> &Roles)
+            {
+                Roles.reserve(Count);
+                for (uint32_t i = 0; i < Count; i++)
+                {
+                    Role Tmp = ReadRole(Reader, Ret->Arena);
+                    Roles.insert({Tmp->ID, Tmp});
+                }
+            });
+
+            Count = Reader.GetCount(MIN_CHANNEL_SIZE);
+            Ret->Channels.update([&Reader, &Strings, &Ret, Count, ID](persistent_map<snowflake, Channel> &Channels)
+            {
+                Channels.reserve(Count);
+                for (uint32_t i = 0; i < Count; i++)
+                {
+                    Channel Tmp = ReadChannel(Reader, Strings, ID, Ret->Arena);
+                    Channels.insert({Tmp->ID, Tmp});
+                }
+            });
+
+            Count = Reader.GetCount(MIN_MEMBER_SIZE);
+            Ret->Members.update([&Reader, &Users, &Ret, Count, ID](persistent_map<snowflake, GuildMember> &Members)
+            {
+                Members.reserve(Count);
+                for (uint32_t i = 0; i < Count; i++)
+                {
+                    GuildMember Tmp = ReadMember(Reader, Users, ID, Ret->Arena);
+                    if(Tmp)
+                        Members.insert({Tmp->UserRef->ID, Tmp});
+                }
+            });
+
+            Ret->Owner = Ret->Members.get(OwnerID);
+            return Ret;
+        }
+    }
+
+    bool CCacheSnapshot::Save(const std::string &Path, const persistent_map<snowflake, Guild> &Guilds, const persistent_map<snowflake, User> &Users)
+    {
+        //The body is written first, to collect the strings of the string table.
+        CWriter Body;
+        Body.Put<uint32_t>((uint32_t)Users.size());
+        for (auto &&e : Users)
+            WriteUser(Body, e.second);
+
+        Body.Put<uint32_t>((uint32_t)Guilds.size());
+        for (auto &&e : Guilds)
+            WriteGuild(Body, e.second);
+
+        CWriter Head;
+        for (auto &&e : MAGIC)
+            Head.Put<char>(e);
+
+        Head.Put<uint32_t>(FORMAT_VERSION);
+        Head.Put<uint32_t>(ENDIAN_MARK);
+        Head.Put<int64_t>(GetTimeMillis());
+
+        Head.Put<uint32_t>((uint32_t)Body.GetStrings().size());
+        for (auto &&e : Body.GetStrings())
+            Head.PutString(*e);
+
+        std::string Tmp = Path + ".tmp";
+        std::ofstream out(Tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!out.is_open())
+        {
+            llog << lerror << "Failed to open the cache snapshot " << Tmp << lendl;
+            return false;
+        }
+
+        out.write(Head.GetBuffer().data(), Head.GetBuffer().size());
+        out.write(Body.GetBuffer().data(), Body.GetBuffer().size());
+        out.close();
+
+        if(out.fail())
+        {
+            llog << lerror << "Failed to write the cache snapshot " << Tmp << lendl;
+            remove(Tmp.c_str());
+            return false;
+        }
+
+        //Windows can't rename onto an existing file.
+        if(rename(Tmp.c_str(), Path.c_str()) != 0)
+        {
+            remove(Path.c_str());
+            if(rename(Tmp.c_str(), Path.c_str()) != 0)
+            {
+                llog << lerror << "Failed to replace the cache snapshot " << Path << lendl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool CCacheSnapshot::Load(const std::string &Path, persistent_map<snowflake, Guild> &Guilds, persistent_map<snowflake, User> &Users)
+    {
+        //The whole file is read with one call and parsed in place.
+        std::ifstream in(Path, std::ios::in | std::ios::binary | std::ios::ate);
+        if(!in.is_open())
+            return false;
+
+        std::string Buffer((size_t)in.tellg(), '\0');
+        in.seekg(0);
+        in.read(&Buffer[0], Buffer.size());
+        if(in.fail())
+        {
+            llog << lerror << "Failed to read the cache snapshot " << Path << lendl;
+            return false;
+        }
+
+        CReader Reader(Buffer.data(), Buffer.size());
+        char Magic[sizeof(MAGIC)];
+        for (auto &&e : Magic)
+            e = Reader.Get<char>();
+
+        uint32_t Version = Reader.Get<uint32_t>();
+        uint32_t EndianMark = Reader.Get<uint32_t>();
+        Reader.Get<int64_t>();
+
+        if(Reader.Failed() || memcmp(Magic, MAGIC, sizeof(MAGIC)) != 0 || Version != FORMAT_VERSION || EndianMark != ENDIAN_MARK)
+        {
+            llog << lerror << "Ignoring the cache snapshot " << Path << ", the file has another format or version" << lendl;
+            return false;
+        }
+
+        uint32_t Count = Reader.GetCount(sizeof(uint32_t));
+        std::vector<interned_string> Strings;
+        Strings.reserve(Count);
+        for (uint32_t i = 0; i < Count; i++)
+            Strings.push_back(Reader.GetString());
+
+        persistent_map<snowflake, User> LoadedUsers;
+        Count = Reader.GetCount(MIN_USER_SIZE);
+        LoadedUsers.reserve(Count);
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            User Tmp = ReadUser(Reader, Strings);
+            LoadedUsers.insert({Tmp->ID, Tmp});
+        }
+
+        persistent_map<snowflake, Guild> LoadedGuilds;
+        Count = Reader.GetCount(MIN_GUILD_SIZE);
+        LoadedGuilds.reserve(Count);
+        for (uint32_t i = 0; i < Count && !Reader.Failed(); i++)
+        {
+            Guild Tmp = ReadGuild(Reader, Strings, LoadedUsers);
+            LoadedGuilds.insert({Tmp->ID.load(), Tmp});
+        }
+
+        if(Reader.Failed())
+        {
+            llog << lerror << "Ignoring the cache snapshot " << Path << ", the file is damaged" << lendl;
+            return false;
+        }
+
+        Guilds = std::move(LoadedGuilds);
+        Users = std::move(LoadedUsers);
+        return true;
+    }
+} // namespace DiscordBot
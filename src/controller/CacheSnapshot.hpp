@@ -0,0 +1,66 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef CACHESNAPSHOT_HPP
+#define CACHESNAPSHOT_HPP
+
+#include <stdint.h>
+#include <string>
+#include <models/persistent_map.hpp>
+#include <models/Guild.hpp>
+#include <models/User.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Binary file of the guild and user caches. Used to serve cached data right after a restart, until discord sends the guilds again.
+     * 
+     * The file starts with a fixed header, followed by a table of all interned strings, the users and the guilds with their roles, channels and members.
+     * All fields have a fixed width and are stored in the byte order of the host. Files with another version or byte order are ignored.
+     * Voice states and presences aren't stored, they are outdated after a restart.
+     */
+    class CCacheSnapshot
+    {
+        public:
+            static const uint32_t FORMAT_VERSION = 2;
+
+            /**
+             * @brief Writes the caches to a file. The data is written to "Path.tmp" and renamed afterwards, so an interrupted write never damages the last snapshot.
+             * 
+             * @return Returns false if the file couldn't be written.
+             */
+            static bool Save(const std::string &Path, const persistent_map<snowflake, Guild> &Guilds, const persistent_map<snowflake, User> &Users);
+
+            /**
+             * @brief Reads a snapshot. The maps are only changed if the whole file could be read.
+             * 
+             * @return Returns false if the file doesn't exist, is damaged or has another version.
+             */
+            static bool Load(const std::string &Path, persistent_map<snowflake, Guild> &Guilds, persistent_map<snowflake, User> &Users);
+    };
+} // namespace DiscordBot
+
+
+#endif //CACHESNAPSHOT_HPP
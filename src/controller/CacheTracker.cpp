@@ -0,0 +1,181 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "CacheTracker.hpp"
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    CCacheTracker::CCacheTracker()
+    {
+        for (auto &&e : m_Modes)
+            e = CacheMode::ALL;
+
+        //Users without a member are only kept while the application references them.
+        m_Modes[(size_t)CacheEntity::USERS] = CacheMode::NONE;
+        m_Caches[(size_t)CacheEntity::USERS].Policy = SCachePolicy(CacheMode::NONE);
+    }
+
+    void CCacheTracker::SetPolicy(CacheEntity Entity, const SCachePolicy &Policy)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        SCache &Cache = m_Caches[(size_t)Entity];
+
+        Cache.Policy = Policy;
+        m_Modes[(size_t)Entity] = Policy.Mode;
+
+        //Only LRU caches are tracked.
+        if(Policy.Mode != CacheMode::LRU)
+        {
+            Cache.Entries.clear();
+            Cache.Index.clear();
+            Cache.Bytes = 0;
+        }
+    }
+
+    SCachePolicy CCacheTracker::GetPolicy(CacheEntity Entity)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Caches[(size_t)Entity].Policy;
+    }
+
+    void CCacheTracker::Touch(CacheEntity Entity, const SCacheKey &Key, size_t Bytes)
+    {
+        if(m_Modes[(size_t)Entity] != CacheMode::LRU)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        SCache &Cache = m_Caches[(size_t)Entity];
+
+        auto IT = Cache.Index.find(Key);
+        if(IT != Cache.Index.end())
+        {
+            Cache.Bytes -= IT->second->Bytes;
+            Cache.Entries.splice(Cache.Entries.begin(), Cache.Entries, IT->second);
+        }
+        else
+        {
+            Cache.Entries.push_front(SEntry());
+            Cache.Entries.front().Key = Key;
+            Cache.Index.insert({Key, Cache.Entries.begin()});
+        }
+
+        SEntry &Entry = Cache.Entries.front();
+        Entry.LastAccess = GetTimeMillis();
+        Entry.Bytes = Bytes;
+        Cache.Bytes += Bytes;
+    }
+
+    void CCacheTracker::Track(CacheEntity Entity, const SCacheKey &Key, size_t Bytes)
+    {
+        if(m_Modes[(size_t)Entity] != CacheMode::LRU)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        SCache &Cache = m_Caches[(size_t)Entity];
+
+        if(Cache.Index.count(Key) != 0)
+            return;
+
+        Cache.Entries.push_front(SEntry());
+        SEntry &Entry = Cache.Entries.front();
+        Entry.Key = Key;
+        Entry.LastAccess = GetTimeMillis();
+        Entry.Bytes = Bytes;
+
+        Cache.Index.insert({Key, Cache.Entries.begin()});
+        Cache.Bytes += Bytes;
+    }
+
+    void CCacheTracker::Remove(CacheEntity Entity, const SCacheKey &Key)
+    {
+        if(m_Modes[(size_t)Entity] != CacheMode::LRU)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        SCache &Cache = m_Caches[(size_t)Entity];
+
+        auto IT = Cache.Index.find(Key);
+        if(IT != Cache.Index.end())
+        {
+            Cache.Bytes -= IT->second->Bytes;
+            Cache.Entries.erase(IT->second);
+            Cache.Index.erase(IT);
+        }
+    }
+
+    void CCacheTracker::RemoveGuild(snowflake Guild)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for (auto &&Cache : m_Caches)
+        {
+            for (auto IT = Cache.Entries.begin(); IT != Cache.Entries.end();)
+            {
+                if(IT->Key.Guild == Guild)
+                {
+                    Cache.Bytes -= IT->Bytes;
+                    Cache.Index.erase(IT->Key);
+                    IT = Cache.Entries.erase(IT);
+                }
+                else
+                    IT++;
+            }
+        }
+    }
+
+    std::vector<SCacheKey> CCacheTracker::Sweep(CacheEntity Entity, int64_t Now)
+    {
+        std::vector<SCacheKey> Ret;
+        if(m_Modes[(size_t)Entity] != CacheMode::LRU)
+            return Ret;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        SCache &Cache = m_Caches[(size_t)Entity];
+
+        //The oldest entries are at the end.
+        while (!Cache.Entries.empty())
+        {
+            SEntry &Entry = Cache.Entries.back();
+            bool Expired = Cache.Policy.TTL != 0 && (Now - Entry.LastAccess) >= Cache.Policy.TTL;
+            bool OverBudget = Cache.Policy.MaxBytes != 0 && Cache.Bytes > Cache.Policy.MaxBytes;
+
+            if(!Expired && !OverBudget)
+                break;
+
+            Ret.push_back(Entry.Key);
+            Cache.Bytes -= Entry.Bytes;
+            Cache.Index.erase(Entry.Key);
+            Cache.Entries.pop_back();
+        }
+
+        return Ret;
+    }
+
+    size_t CCacheTracker::GetBytes(CacheEntity Entity)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Caches[(size_t)Entity].Bytes;
+    }
+} // namespace DiscordBot
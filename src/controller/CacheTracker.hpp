@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef CACHETRACKER_HPP
+#define CACHETRACKER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <vector>
+#include <models/CachePolicy.hpp>
+#include <models/flat_map.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Identifies a cache entry. Guild is empty for entities without a guild (users).
+     */
+    struct SCacheKey
+    {
+        SCacheKey() {}
+        SCacheKey(snowflake guild, snowflake id) : Guild(guild), ID(id) {}
+
+        snowflake Guild;
+        snowflake ID;
+    };
+
+    inline bool operator==(const SCacheKey &lhs, const SCacheKey &rhs)
+    {
+        return lhs.Guild == rhs.Guild && lhs.ID == rhs.ID;
+    }
+
+    struct SCacheKeyHash
+    {
+        inline size_t operator()(const SCacheKey &Key) const noexcept
+        {
+            std::hash<snowflake> hash;
+            return hash(Key.ID) ^ (hash(Key.Guild) * 31);
+        }
+    };
+
+    /**
+     * @brief Holds the cache policies and the access order of all LRU cached entities. The entities itself stay in the snapshot maps of the client, this class only decides what to evict.
+     */
+    class CCacheTracker
+    {
+        public:
+            CCacheTracker();
+
+            void SetPolicy(CacheEntity Entity, const SCachePolicy &Policy);
+            SCachePolicy GetPolicy(CacheEntity Entity);
+
+            /**
+             * @return Returns false if the policy of the entity is CacheMode::NONE.
+             */
+            inline bool IsCached(CacheEntity Entity) const
+            {
+                return m_Modes[(size_t)Entity] != CacheMode::NONE;
+            }
+
+            /**
+             * @brief Marks a entry as recently used. Only LRU cached entities are tracked.
+             * 
+             * @param Bytes: Approximated heap usage of the entry.
+             */
+            void Touch(CacheEntity Entity, const SCacheKey &Key, size_t Bytes);
+
+            /**
+             * @brief Adds a entry, if it isn't tracked yet. Doesn't change the access time of tracked entries.
+             */
+            void Track(CacheEntity Entity, const SCacheKey &Key, size_t Bytes);
+
+            /**
+             * @brief Stops the tracking of a removed entry.
+             */
+            void Remove(CacheEntity Entity, const SCacheKey &Key);
+
+            /**
+             * @brief Stops the tracking of all entries of a guild.
+             */
+            void RemoveGuild(snowflake Guild);
+
+            /**
+             * @brief Removes all entries which exceeded the ttl and the least recently used entries until the byte budget is met.
+             * 
+             * @return Returns the removed entries, which the caller must evict.
+             */
+            std::vector<SCacheKey> Sweep(CacheEntity Entity, int64_t Now);
+
+            /**
+             * @return Returns the approximated heap usage of all tracked entries of a entity.
+             */
+            size_t GetBytes(CacheEntity Entity);
+
+            ~CCacheTracker() {}
+
+        private:
+            static const size_t ENTITY_COUNT = (size_t)CacheEntity::CHANNELS + 1;
+
+            struct SEntry
+            {
+                SCacheKey Key;
+                int64_t LastAccess;
+                size_t Bytes;
+            };
+
+            using LRUList = std::list<SEntry>;
+
+            struct SCache
+            {
+                SCache() : Bytes(0) {}
+
+                SCachePolicy Policy;
+                LRUList Entries;    //!< Most recently used first.
+                flat_map<SCacheKey, LRUList::iterator, SCacheKeyHash> Index;
+                size_t Bytes;
+            };
+
+            std::mutex m_Lock;
+            SCache m_Caches[ENTITY_COUNT];
+            std::atomic<CacheMode> m_Modes[ENTITY_COUNT];
+    };
+} // namespace DiscordBot
+
+
+#endif //CACHETRACKER_HPP
@@ -24,9 +24,12 @@
 
 #include "DiscordClient.hpp"
 #include <iostream>
+#include <algorithm>
 #include <sodium.h>
 #include <models/DiscordException.hpp>
 #include "../helpers/Helper.hpp"
+#include "../helpers/MemoryUsage.hpp"
+#include "CacheSnapshot.hpp"
 
 #define CLOG_IMPLEMENTATION
 #include <Log.hpp>
@@ -49,13 +52,15 @@ namespace DiscordBot
         return DiscordClient(new CDiscordClient(Token, Intents));
     }
 
-    CDiscordClient::CDiscordClient(const std::string &Token, Intent Intents) : m_Intents(Intents), m_Token(Token), m_Terminate(false), m_HeartACKReceived(false), m_Quit(false), m_LastSeqNum(-1), m_IsAFK(false), m_State(OnlineState::ONLINE)
+    CDiscordClient::CDiscordClient(const std::string &Token, Intent Intents) : m_Intents(Intents), m_Token(Token), m_Terminate(false), m_HeartACKReceived(false), m_Quit(false), m_LastSeqNum(-1), m_EventWorkers(0), m_IsAFK(false), m_State(OnlineState::ONLINE)
     {
 #ifdef DISCORDBOT_UNIX
         //Ignores the SIGPIPE signal.
         signal(SIGPIPE, SIG_IGN);
 #endif
-        USER_AGENT = std::string("libDiscordBot (https://github.com/tostc/libDiscordBot, ") + VERSION + ")";
+        m_REST = std::make_shared<CRESTClient>(BASE_URL, std::string("libDiscordBot (https://github.com/tostc/libDiscordBot, ") + VERSION + ")");
+        m_REST->SetAuthorization("Bot " + m_Token);
+        m_WebhookREST = std::make_shared<CRESTClient>(BASE_URL, std::string("libDiscordBot (https://github.com/tostc/libDiscordBot, ") + VERSION + ")");
 
         m_EVManger.SubscribeMessage(QUEUE_NEXT_SONG, std::bind(&CDiscordClient::OnMessageReceive, this, std::placeholders::_1));  
         m_EVManger.SubscribeMessage(RESUME, std::bind(&CDiscordClient::OnMessageReceive, this, std::placeholders::_1));  
@@ -66,7 +71,6 @@ namespace DiscordBot
         ix::SocketTLSOptions DisabledTrust;
         DisabledTrust.caFile = "NONE";
 
-        m_HTTPClient.setTLSOptions(DisabledTrust);
         m_Socket.setTLSOptions(DisabledTrust);
     }
 
@@ -120,13 +124,13 @@ namespace DiscordBot
         SendOP(OPCodes::PRESENCE_UPDATE, CreateUserInfoJSON());
     }
 
-    void CDiscordClient::ChangeVoiceState(const std::string &Guild, const std::string &Channel)
+    void CDiscordClient::ChangeVoiceState(snowflake Guild, snowflake Channel)
     {
         CJSON json;
-        json.AddPair("guild_id", Guild);
+        json.AddPair("guild_id", Guild.str());
 
         if(!Channel.empty())
-            json.AddPair("channel_id", Channel);
+            json.AddPair("channel_id", Channel.str());
         else
             json.AddPair("channel_id", nullptr);
 
@@ -138,7 +142,7 @@ namespace DiscordBot
 
     void CDiscordClient::Join(Channel channel)
     {
-        if (!channel || channel->GuildID->empty() || channel->ID->empty())
+        if (!channel || channel->GuildID.empty() || channel->ID.empty())
             return;
 
         ChangeVoiceState(channel->GuildID, channel->ID);
@@ -164,7 +168,7 @@ namespace DiscordBot
         if(embed)
             json.AddJSON("embed", embed | Serialize);
 
-        auto res = Post("/channels/" + channel->ID + "/messages", json.Serialize());
+        auto res = Post("/channels/" + channel->ID + "/messages", json.Serialize(), RequestPriority::INTERACTIVE);
         if (res->statusCode != 200)
             llog << lerror << "Failed to send message HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
     }
@@ -172,9 +176,9 @@ namespace DiscordBot
     void CDiscordClient::SendMessage(User user, const std::string Text, Embed embed, bool TTS)
     {
         CJSON json;
-        json.AddPair("recipient_id", user->ID.load());
+        json.AddPair("recipient_id", user->ID.str());
 
-        auto res = Post("/users/@me/channels", json.Serialize());
+        auto res = Post("/users/@me/channels", json.Serialize(), RequestPriority::INTERACTIVE);
         if (res->statusCode != 200)
             llog << lerror << "Failed to send message HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
         else
@@ -187,6 +191,128 @@ namespace DiscordBot
         }
     }
 
+    void CDiscordClient::SendFiles(Channel channel, const std::vector<std::string> &Files, const std::string Text, Embed embed)
+    {
+        if(!channel || (channel->Type != ChannelTypes::GUILD_TEXT && channel->Type != ChannelTypes::DM))
+            return;
+
+        if(Files.empty() || Files.size() > MAX_FILES)
+        {
+            llog << lerror << "Failed to send files: Between 1 and 10 files are allowed" << lendl;
+            return;
+        }
+
+        CJSON json;
+        json.AddPair("content", Text);
+
+        if(embed)
+            json.AddJSON("embed", embed | Serialize);
+
+        CMultipartBody Body;
+        Body.AddField("payload_json", json.Serialize(), "application/json");
+
+        for (size_t i = 0; i < Files.size(); i++)
+        {
+            if(!Body.AddFile("files[" + std::to_string(i) + "]", Files[i]))
+            {
+                llog << lerror << "Failed to open file or the files exceed 8 MiB: " << Files[i] << lendl;
+                return;
+            }
+        }
+
+        auto res = m_REST->Request("POST", "/channels/" + channel->ID + "/messages", Body.Build(), Body.GetContentType(), RequestPriority::INTERACTIVE);
+        if (res->statusCode != 200)
+            llog << lerror << "Failed to send files HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
+    }
+
+    Webhook CDiscordClient::GetWebhook(Channel channel, const std::string &Name)
+    {
+        if(!channel || (channel->Type != ChannelTypes::GUILD_TEXT && channel->Type != ChannelTypes::GUILD_NEWS))
+            return nullptr;
+
+        auto Key = std::make_pair(channel->ID, Name);
+        auto IT = m_Webhooks->find(Key);
+        if(IT != m_Webhooks->end())
+            return IT->second;
+
+        //Prevents that two threads create a webhook for the same channel.
+        std::lock_guard<std::mutex> lock(m_WebhookLock);
+        IT = m_Webhooks->find(Key);
+        if(IT != m_Webhooks->end())
+            return IT->second;
+
+        Webhook Ret;
+        auto res = Get("/channels/" + channel->ID + "/webhooks");
+        if(res->statusCode != 200)
+        {
+            llog << lerror << "Failed to get webhooks HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
+            return nullptr;
+        }
+
+        CJSON json;
+        auto Array = json.Deserialize<std::vector<std::string>>(res->body);
+        for (auto &&e : Array)
+        {
+            Webhook Tmp = Deserialize<Webhook>(e);
+
+            //Only webhooks with a token can be executed.
+            if(!Tmp->Token.empty() && Tmp->Name == Name)
+            {
+                Ret = Tmp;
+                break;
+            }
+        }
+
+        if(!Ret)
+        {
+            json.AddPair("name", Name);
+
+            res = Post("/channels/" + channel->ID + "/webhooks", json.Serialize());
+            if(res->statusCode != 200)
+            {
+                llog << lerror << "Failed to create webhook HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
+                return nullptr;
+            }
+
+            Ret = Deserialize<Webhook>(res->body);
+        }
+
+        m_Webhooks->insert({Key, Ret});
+        return Ret;
+    }
+
+    void CDiscordClient::ExecuteWebhook(Webhook webhook, const std::string &Text, Embed embed, const std::string &Username, const std::string &AvatarURL, bool TTS)
+    {
+        if(!webhook)
+            return;
+
+        CJSON json;
+        json.AddPair("content", Text);
+        json.AddPair("tts", TTS);
+
+        if(!Username.empty())
+            json.AddPair("username", Username);
+
+        if(!AvatarURL.empty())
+            json.AddPair("avatar_url", AvatarURL);
+
+        if(embed)
+            json.AddJSON("embeds", "[" + (embed | Serialize) + "]");
+
+        //wait=false, discord answers before the message is created and we don't need to parse it.
+        auto res = m_WebhookREST->Request("POST", "/webhooks/" + webhook->ID + "/" + webhook->Token + "?wait=false", json.Serialize());
+        if(res->statusCode == 404 || res->statusCode == 401)
+        {
+            //The webhook was deleted or its token was reset, the next GetWebhook call fetches a new one.
+            auto IT = m_Webhooks->find(std::make_pair(webhook->ChannelID, webhook->Name));
+            if(IT != m_Webhooks->end() && IT->second == webhook)
+                m_Webhooks->erase(IT);
+        }
+
+        if (res->statusCode != 204 && res->statusCode != 200)
+            llog << lerror << "Failed to execute webhook HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
+    }
+
     AudioSource CDiscordClient::GetAudioSource(Guild guild)
     {
         if(!guild)
@@ -218,6 +344,12 @@ namespace DiscordBot
 
     void CDiscordClient::Run()
     {
+        if(!m_SnapshotFile.empty())
+            LoadCacheSnapshot();
+
+        if(m_EventWorkers > 0)
+            m_Dispatcher.Start(m_EventWorkers, std::bind(&CDiscordClient::OnDispatch, this, std::placeholders::_1));
+
         //Requests the gateway endpoint for bots.
         auto res = Get("/gateway/bot");
         if (res->statusCode == 200)
@@ -237,10 +369,13 @@ namespace DiscordBot
             m_Socket.setUrl(m_Gateway->URL + "/?v=8&encoding=json");
             m_Socket.setOnMessageCallback(std::bind(&CDiscordClient::OnWebsocketEvent, this, std::placeholders::_1));
             m_Socket.start();
+            m_Sweeper = std::thread(&CDiscordClient::CacheSweeper, this);
 
             //Runs until the bot quits.
             while (!m_Quit)
                 std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            m_Sweeper.join();
         }
         else
             llog << lerror << "HTTP " << res->statusCode << " Error " << res->errorMsg << lendl;
@@ -248,18 +383,19 @@ namespace DiscordBot
 
     void CDiscordClient::Quit()
     {
-        auto IT = m_Guilds->begin();
-        while (IT != m_Guilds->end())
-        {
-            Leave(IT->second);
-            IT++;
-        }
+        if(!m_SnapshotFile.empty())
+            SaveCacheSnapshot(m_SnapshotFile);
+
+        auto Guilds = m_Guilds.load();
+        for (auto &&e : *Guilds)
+            Leave(e.second);
 
         m_Terminate = true;
         if (m_Heartbeat.joinable())
             m_Heartbeat.join();
 
         m_Socket.stop();
+        m_Dispatcher.Stop();
         
         if (m_Controller)
         {
@@ -268,10 +404,13 @@ namespace DiscordBot
             m_Controller = nullptr;
         }
 
-        m_Guilds->clear();
+        m_Guilds.clear();
+        m_Permissions.Clear();
+        m_Messages.Clear();
+        m_MemberIndex.Clear();
         m_VoiceSockets->clear();
         m_AudioSources->clear();
-        m_Users->clear();
+        m_Users.clear();
         m_MusicQueues->clear();
         m_Quit = true;
     }
@@ -301,7 +440,7 @@ namespace DiscordBot
 
     bool CDiscordClient::StartSpeaking(Channel channel)
     {
-        if (!channel || channel->GuildID->empty())
+        if (!channel || channel->GuildID.empty())
             return false;
 
         AudioSource Source;
@@ -320,7 +459,7 @@ namespace DiscordBot
 
     bool CDiscordClient::StartSpeaking(Channel channel, AudioSource source)
     {
-        if (!channel || channel->GuildID->empty())
+        if (!channel || channel->GuildID.empty())
             return false;
 
         VoiceSockets::iterator IT = m_VoiceSockets->find(channel->GuildID);
@@ -368,7 +507,7 @@ namespace DiscordBot
 
     void CDiscordClient::RemoveSong(Channel channel, size_t Index)
     {
-        if (!channel || channel->GuildID->empty())
+        if (!channel || channel->GuildID.empty())
             return;
 
         auto IT = m_MusicQueues->find(channel->GuildID);
@@ -378,7 +517,7 @@ namespace DiscordBot
 
     void CDiscordClient::RemoveSong(Channel channel, const std::string &Name)
     {
-        if (!channel || channel->GuildID->empty())
+        if (!channel || channel->GuildID.empty())
             return;
 
         auto IT = m_MusicQueues->find(channel->GuildID);
@@ -392,7 +531,7 @@ namespace DiscordBot
         {
             case QUEUE_NEXT_SONG:
             {
-                auto Data = std::static_pointer_cast<TMessage<std::string>>(Msg);
+                auto Data = std::static_pointer_cast<TMessage<snowflake>>(Msg);
 
                 AudioSource Source;
 
@@ -472,456 +611,20 @@ namespace DiscordBot
                     case OPCodes::DISPATCH:
                     {
                         m_LastSeqNum = Pay.S;
-                        std::hash<std::string> hash;
 
-                        //Gateway Events https://discordapp.com/developers/docs/topics/gateway#commands-and-events-gateway-events
-                        switch (Adler32(Pay.T.c_str()))
+                        if(!m_Dispatcher.IsRunning())
+                            OnDispatch(Pay);
+                        else
                         {
-                            //Called after the handshake is completed.
-                            case Adler32("READY"):
+                            //READY and RESUMED change the state of all guilds, so they wait for the queued events and run on the socket thread.
+                            size_t Event = Adler32(Pay.T.c_str());
+                            if(Event == Adler32("READY") || Event == Adler32("RESUMED"))
                             {
-                                json.ParseObject(Pay.D);
-                                m_SessionID = json.GetValue<std::string>("session_id");
-
-                                // json.ParseObject();
-                                json.GetValue<std::string>("user") >> m_BotUser >> m_Users;
-
-                                auto Unavailables = json.GetValue<std::vector<std::string>>("guilds");
-                                for (auto &&e : Unavailables)
-                                {
-                                    CJSON tmp;
-                                    tmp.ParseObject(e);
-
-                                    m_Unavailables.push_back(tmp.GetValue<std::string>("id"));
-                                }
-
-                                // m_BotUser = CreateUser(json);
-
-                                llog << linfo << "Connected with Discord! " << m_Socket.getUrl() << lendl;
-
-                                if (m_Controller)
-                                    m_Controller->OnReady();
+                                m_Dispatcher.Wait();
+                                OnDispatch(Pay);
                             }
-                            break;
-
-                            /*------------------------GUILDS Intent------------------------*/
-
-                            case Adler32("GUILD_CREATE"):
-                            {
-                                json.ParseObject(Pay.D);
-
-                                Guild guild = Guild(new CGuild());
-                                guild->ID = json.GetValue<std::string>("id");
-                                guild->Name = json.GetValue<std::string>("name");
-                                guild->Icon = json.GetValue<std::string>("icon");
-
-                                //Get all Roles;
-                                std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("roles");
-                                for (auto &&e : Array)
-                                {
-                                    Role Tmp;
-                                    e >> Tmp;
-                                    guild->Roles->insert({Tmp->ID, Tmp});
-                                }
-
-                                //Get all Channels;
-                                Array = json.GetValue<std::vector<std::string>>("channels");
-                                for (auto &&e : Array)
-                                {
-                                    Channel Tmp;
-                                    (e & m_Users) >> Tmp;
-                                    
-                                    Tmp->GuildID = guild->ID;
-                                    guild->Channels->insert({Tmp->ID, Tmp});
-                                }
-
-                                //Get all members.
-                                Array = json.GetValue<std::vector<std::string>>("members");
-                                for (auto &&e : Array)
-                                {
-                                    CJSON Member;
-                                    Member.ParseObject(e);
-
-                                    GuildMember Tmp = CreateMember(Member, guild);
-
-                                    // if (Tmp->UserRef)
-                                    //     guild->Members[Tmp->UserRef->ID] = Tmp;
-                                }
-
-                                //Get all voice states.
-                                Array = json.GetValue<std::vector<std::string>>("voice_states");
-                                for (auto &&e : Array)
-                                {
-                                    CJSON State;
-                                    State.ParseObject(e);
-
-                                    CreateVoiceState(State, guild);
-                                }
-
-                                //Gets the owner object.
-                                std::string OwnerID = json.GetValue<std::string>("owner_id");
-                                guild->Owner = GetMember(guild, OwnerID);
-                                m_Guilds->insert({guild->ID, guild});
-
-                                auto IT = std::find(m_Unavailables.begin(), m_Unavailables.end(), guild->ID);
-                                if(IT != m_Unavailables.end())
-                                {
-                                    m_Unavailables.erase(IT);
-
-                                    if(m_Controller)
-                                        m_Controller->OnGuildAvailable(guild);
-                                }
-                                else if(m_Controller)
-                                    m_Controller->OnGuildJoin(guild);
-                            }break;
-
-                            case Adler32("GUILD_DELETE"):
-                            {
-                                json.ParseObject(Pay.D);
-
-                                auto IT = m_Guilds->find(json.GetValue<std::string>("id"));
-                                if(IT != m_Guilds->end())
-                                {
-                                    bool Unavailable = json.GetValue<bool>("unavailable");
-                                    auto InnerIT = std::find(m_Unavailables.begin(), m_Unavailables.end(), IT->second->ID);
-
-                                    if(Unavailable && m_Controller && InnerIT != m_Unavailables.end())
-                                    {
-                                        m_Unavailables.erase(InnerIT);
-                                        m_Controller->OnGuildUnavailable(IT->second);
-                                    }
-                                    else if(!Unavailable && m_Controller)
-                                        m_Controller->OnGuildLeave(IT->second);
-                                    else
-                                        m_Unavailables.push_back(IT->second->ID);
-
-                                    m_VoiceSockets->erase(IT->second->ID);
-                                    m_MusicQueues->erase(IT->second->ID);
-                                    m_Guilds->erase(IT);
-                                }
-
-                                llog << linfo << "GUILD_DELETE" << lendl;
-                            }break;
-
-                            /*------------------------GUILDS Intent------------------------*/
-
-                            /*------------------------CHANNEL Intent------------------------*/
-
-                            case Adler32("CHANNEL_CREATE"):
-                            {
-                                Channel Tmp;
-                                (Pay.D & m_Users) >> Tmp;
-
-                                auto IT = m_Guilds->find(Tmp->GuildID);
-                                if(IT != m_Guilds->end())
-                                    IT->second->Channels->insert({Tmp->ID, Tmp});
-                            }break;
-
-                            case Adler32("CHANNEL_UPDATE"):
-                            {
-                                Channel Tmp;
-                                (Pay.D & m_Users) >> Tmp;
-
-                                auto IT = m_Guilds->find(Tmp->GuildID);
-                                if(IT != m_Guilds->end())
-                                {
-                                    IT->second->Channels->erase(Tmp->ID);
-                                    IT->second->Channels->insert({Tmp->ID, Tmp});
-                                }
-                            }break;
-
-                            case Adler32("CHANNEL_DELETE"):
-                            {
-                                Channel Tmp;
-                                (Pay.D & m_Users) >> Tmp;
-
-                                auto IT = m_Guilds->find(Tmp->GuildID);
-                                if(IT != m_Guilds->end())
-                                    IT->second->Channels->erase(Tmp->ID);
-                            }break;
-
-                            /*------------------------CHANNEL Intent------------------------*/
-
-                            /*------------------------GUILD_MEMBERS Intent------------------------*/
-                            //ATTENTION: NEEDS "Server Members Intent" ACTIVATED TO WORK, OTHERWISE THE BOT FAIL TO CONNECT AND A ERROR IS WRITTEN TO THE CONSOLE!!!
-
-                            case Adler32("GUILD_MEMBER_ADD"):
-                            {
-                                CJSON Member;
-                                Member.ParseObject(Pay.D);
-
-                                std::string GuildID = Member.GetValue<std::string>("guild_id");
-
-                                auto IT = m_Guilds->find(GuildID);
-                                if(IT != m_Guilds->end())
-                                {
-                                    Guild guild = IT->second;//m_Guilds[GuildID];
-                                    GuildMember Tmp = CreateMember(Member, guild);
-
-                                    if(m_Controller)
-                                        m_Controller->OnMemberAdd(guild, Tmp);
-                                }
-                                else
-                                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
-                            }break;
-
-                            case Adler32("GUILD_MEMBER_UPDATE"):
-                            {
-                                json.ParseObject(Pay.D);
-                                std::string GuildID = json.GetValue<std::string>("guild_id");
-                                std::string Premium = json.GetValue<std::string>("premium_since");
-                                std::string Nick = json.GetValue<std::string>("nick");
-                                std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("roles");
-
-                                json.ParseObject(json.GetValue<std::string>("user"));
-                                std::string UserID = json.GetValue<std::string>("id");
-
-                                auto GIT = m_Guilds->find(GuildID);
-                                if(GIT != m_Guilds->end())
-                                {
-                                    Guild guild = GIT->second;//m_Guilds[GuildID];
-                                    auto IT = guild->Members->find(UserID);
-                                    if(IT != guild->Members->end())
-                                    {
-                                        IT->second->Roles->clear();
-                                        for (auto &&e : Array)
-                                            IT->second->Roles->push_back(guild->Roles->at(e));                               
-
-                                        IT->second->Nick = Nick;
-                                        IT->second->PremiumSince = Premium;
-
-                                        if(m_Controller)
-                                            m_Controller->OnMemberUpdate(guild, IT->second);
-                                    } 
-                                }
-                                else
-                                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
-                            }break;
-
-                            case Adler32("GUILD_BAN_ADD"):
-                            case Adler32("GUILD_MEMBER_REMOVE"):
-                            {
-                                json.ParseObject(Pay.D);
-                                std::string GuildID = json.GetValue<std::string>("guild_id");
-
-                                json.ParseObject(json.GetValue<std::string>("user"));
-                                std::string UserID = json.GetValue<std::string>("id");
-
-                                auto GIT = m_Guilds->find(GuildID);
-                                if(GIT != m_Guilds->end())
-                                {
-                                    Guild guild = GIT->second;//m_Guilds[GuildID];
-
-                                    auto IT = guild->Members->find(UserID);
-                                    if(IT != guild->Members->end())
-                                    {
-                                        GuildMember member = IT->second;
-                                        guild->Members->erase(IT);
-
-                                        if(m_Controller)
-                                            m_Controller->OnMemberRemove(guild, member);
-                                    }                                
-
-                                    if(m_Users->find(UserID) != m_Users->end())
-                                    {
-                                        if(m_Users->at(UserID).use_count() == 1)
-                                            m_Users->erase(UserID);
-                                    }
-                                }
-                                else
-                                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
-                            }break;
-
-                            /*------------------------GUILD_MEMBERS Intent------------------------*/
-
-                            /*------------------------GUILD_PRESENCES Intent------------------------*/
-                            //ATTENTION: NEEDS "Presence Intent" ACTIVATED TO WORK, OTHERWISE THE BOT FAIL TO CONNECT AND A ERROR IS WRITTEN TO THE CONSOLE!!!
-
-                            case Adler32("PRESENCE_UPDATE"):
-                            { 
-                                json.ParseObject(Pay.D);
-                                User user = m_Users | json.GetValue<std::string>("user");
-
-                                if(!json.GetValue<std::string>("game").empty())
-                                {
-                                    CJSON JGame;
-                                    JGame.ParseObject(json.GetValue<std::string>("game"));
-                                    user->Game = CreateActivity(JGame);
-                                }
-
-                                user->State = StrToOnlineState(json.GetValue<std::string>("status"));
-                                std::vector<std::string> Acts = json.GetValue<std::vector<std::string>>("activities");
-                                for (auto &&e : Acts)
-                                {
-                                    CJSON JAct;
-                                    JAct.ParseObject(e);
-                                    user->Activities->push_back(CreateActivity(JAct));
-                                }
-
-                                CJSON JClientState;
-                                JClientState.ParseObject(json.GetValue<std::string>("client_status")); 
-
-                                user->Desktop = StrToOnlineState(JClientState.GetValue<std::string>("desktop"));      
-                                user->Mobile = StrToOnlineState(JClientState.GetValue<std::string>("mobile"));   
-                                user->Web = StrToOnlineState(JClientState.GetValue<std::string>("web"));                      
-
-                                auto GIT = m_Guilds->find(json.GetValue<std::string>("guild_id"));
-                                if(GIT != m_Guilds->end())
-                                {
-                                    GuildMember member;
-                                    auto MIT = GIT->second->Members->find(user->ID);
-                                    if(MIT == GIT->second->Members->end())
-                                        member = GetMember(GIT->second, user->ID);
-                                    else
-                                        member = MIT->second;
-
-                                    if(m_Controller)
-                                        m_Controller->OnPresenceUpdate(GIT->second, member);
-                                }
-                            }break;
-
-                            /*------------------------GUILD_PRESENCES Intent------------------------*/
-
-                            /*------------------------GUILD_VOICE_STATES Intent------------------------*/
-
-                            case Adler32("VOICE_STATE_UPDATE"):
-                            {
-                                json.ParseObject(Pay.D);
-
-                                auto G = m_Guilds->find(json.GetValue<std::string>("guild_id"));
-                                auto M = G->second->Members->find(json.GetValue<std::string>("user_id"));
-                                Channel c;
-                                if(M->second->State)
-                                    c = M->second->State->ChannelRef;   //Saves the old channel.
-
-                                VoiceState Tmp = CreateVoiceState(json, nullptr);
-
-                                if (m_Controller && Tmp->GuildRef)
-                                {
-                                    if(Tmp->UserRef)
-                                    {
-                                        if(Tmp->UserRef->ID == m_BotUser->ID && !Tmp->ChannelRef)
-                                        {
-                                            m_VoiceSockets->erase(Tmp->GuildRef->ID);
-                                            m_MusicQueues->erase(Tmp->GuildRef->ID);
-                                        }
-
-                                        auto IT = Tmp->GuildRef->Members->find(Tmp->UserRef->ID);
-                                        if(IT != Tmp->GuildRef->Members->end())
-                                        {
-                                            m_Controller->OnVoiceStateUpdate(Tmp->GuildRef, IT->second);
-
-                                            auto AIT = m_Admins->find(Tmp->GuildRef->ID);
-                                            if(AIT != m_Admins->end())
-                                            {
-                                                auto Admin = std::dynamic_pointer_cast<CGuildAdmin>(AIT->second);
-
-                                                if(!c)
-                                                    c = Tmp->ChannelRef;
-                                                    
-                                                if(c)
-                                                    Admin->OnUserVoiceStateChanged(c, IT->second);
-                                            }
-                                        }
-                                    }
-                                }   
-                            }break;
-
-                            /*------------------------GUILD_VOICE_STATES Intent------------------------*/
-
-                            //Called if your bot joins a voice channel.
-                            case Adler32("VOICE_SERVER_UPDATE"):
-                            {
-                                json.ParseObject(Pay.D);
-                                Guilds::iterator GIT = m_Guilds->find(json.GetValue<std::string>("guild_id"));
-                                if (GIT != m_Guilds->end())
-                                {
-                                    auto UIT = GIT->second->Members->find(m_BotUser->ID);
-                                    if (UIT != GIT->second->Members->end())
-                                    {
-                                        VoiceSocket Socket = VoiceSocket(new CVoiceSocket(json, UIT->second->State->SessionID, m_BotUser->ID));
-                                        Socket->SetOnSpeakFinish(std::bind(&CDiscordClient::OnSpeakFinish, this, std::placeholders::_1));
-                                        m_VoiceSockets->insert({GIT->second->ID, Socket});
-
-                                        //Creates a music queue for the server.
-                                        if(m_QueueFactory)
-                                        {
-                                            if(m_MusicQueues->find(GIT->second->ID) == m_MusicQueues->end())
-                                            {
-                                                MusicQueue MQ = m_QueueFactory->Create();
-                                                MQ->SetGuildID(GIT->second->ID);
-                                                MQ->SetOnWaitFinishCallback(std::bind(&CDiscordClient::OnQueueWaitFinish, this, std::placeholders::_1, std::placeholders::_2));
-                                                m_MusicQueues->insert({GIT->second->ID, MQ});
-                                            }
-                                        }
-
-                                        //Plays the queued audiosource.
-                                        AudioSources::iterator IT = m_AudioSources->find(GIT->second->ID);
-                                        if (IT != m_AudioSources->end())
-                                        {
-                                            Socket->StartSpeaking(IT->second);
-                                            m_AudioSources->erase(IT);
-                                        }
-                                    }
-                                }
-                            }break;
-
-                            /*------------------------GUILD_MESSAGES Intent------------------------*/
-
-                            case Adler32("MESSAGE_CREATE"):
-                            case Adler32("MESSAGE_UPDATE"):
-                            case Adler32("MESSAGE_DELETE"):
-                            {
-                                json.ParseObject(Pay.D);
-                                Message msg = CreateMessage(json);
-
-                                std::shared_ptr<CGuildAdmin> Admin;
-                                auto AIT = m_Admins->find(msg->GuildRef->ID);
-                                if(AIT != m_Admins->end())
-                                    Admin = std::dynamic_pointer_cast<CGuildAdmin>(AIT->second);
-
-                                switch (Adler32(Pay.T.c_str()))
-                                {
-                                    case Adler32("MESSAGE_CREATE"):
-                                    {
-                                        if (m_Controller)
-                                            m_Controller->OnMessage(msg);
-
-                                        if(Admin)
-                                            Admin->OnMessageEvent(ActionType::MESSAGE_CREATED, msg->ChannelRef, msg);
-                                    }break;
-
-                                    case Adler32("MESSAGE_UPDATE"):
-                                    {
-                                        if (m_Controller)
-                                            m_Controller->OnMessageEdited(msg);
-
-                                        if(Admin)
-                                            Admin->OnMessageEvent(ActionType::MESSAGE_EDITED, msg->ChannelRef, msg);
-                                    }break;
-
-                                    case Adler32("MESSAGE_DELETE"):
-                                    {
-                                        if (m_Controller)
-                                            m_Controller->OnMessageDeleted(msg);
-
-                                        if(Admin)
-                                            Admin->OnMessageEvent(ActionType::MESSAGE_DELETED, msg->ChannelRef, msg);
-                                    }break;
-                                }
-
-                            }break;
-
-                            /*------------------------GUILD_MESSAGES Intent------------------------*/
-
-                            //Called if a session resumed.
-                            case Adler32("RESUMED"):
-                            {
-                                llog << linfo << "Resumed" << lendl;
-
-                                if (m_Controller)
-                                    m_Controller->OnResume();
-                            } break;
+                            else
+                                m_Dispatcher.Post(GetDispatchKey(Event, Pay.D), std::move(Pay));
                         }
                 }break;
 
@@ -979,494 +682,1912 @@ namespace DiscordBot
         }
     }
 
-    void CDiscordClient::Heartbeat()
+    void CDiscordClient::OnDispatch(const SPayload &Pay)
     {
-        while (!m_Terminate)
+        CJSON json;
+
+        //Gateway Events https://discordapp.com/developers/docs/topics/gateway#commands-and-events-gateway-events
+        switch (Adler32(Pay.T.c_str()))
         {
-            //Start a reconnect.
-            if (!m_HeartACKReceived)
+            //Called after the handshake is completed.
+            case Adler32("READY"):
             {
-                m_Socket.stop();
+                json.ParseObject(Pay.D);
+                m_SessionID = json.GetValue<std::string>("session_id");
 
-                // m_Users->clear();
-                // m_Guilds->clear();
+                //The new session starts its sequence at 1 again.
+                m_Presences.ResetSequences();
+                {
+                    std::lock_guard<std::mutex> lock(m_UserSeqLock);
+                    m_UserSeqs.clear();
+                }
 
-                m_VoiceSockets->clear();
+                // json.ParseObject();
+                json.GetValue<std::string>("user") >> m_BotUser >> m_Users;
 
-                if (m_Controller)
-                    m_Controller->OnDisconnect();
+                std::lock_guard<std::mutex> lock(m_GuildListLock);
+                auto Unavailables = json.GetValue<std::vector<std::string>>("guilds");
+                for (auto &&e : Unavailables)
+                {
+                    CJSON tmp;
+                    tmp.ParseObject(e);
 
-                m_Terminate = true;
-                m_EVManger.PostMessage(RESUME, 0, 100);
+                    m_Unavailables.push_back(snowflake(tmp.GetValue<std::string>("id")));
+                }
 
-                break;
-            }
+                //Removes the snapshot guilds, which the bot left while it was offline.
+                if(!m_SnapshotGuilds.empty())
+                {
+                    std::vector<snowflake> Candidates;
+                    auto IT = m_SnapshotGuilds.begin();
+                    while (IT != m_SnapshotGuilds.end())
+                    {
+                        if(std::find(m_Unavailables.begin(), m_Unavailables.end(), *IT) != m_Unavailables.end())
+                        {
+                            IT++;
+                            continue;
+                        }
 
-            SendOP(OPCodes::HEARTBEAT, m_LastSeqNum != -1 ? std::to_string(m_LastSeqNum) : "");
-            m_HeartACKReceived = false;
+                        Guild guild = m_Guilds.get(*IT);
+                        if(guild)
+                        {
+                            m_Cache.RemoveGuild(*IT);
+                            m_Permissions.InvalidateGuild(*IT);
+                            m_MemberIndex.RemoveGuild(*IT);
+                            m_Guilds.erase(*IT);
+
+                            auto Members = guild->Members.load();
+                            for (auto &&e : *Members)
+                                Candidates.push_back(e.first);
+                        }
 
-            // Terminateable timeout.
-            int64_t Beg = GetTimeMillis();
-            while (((GetTimeMillis() - Beg) < m_HeartbeatInterval) && !m_Terminate)
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        IT = m_SnapshotGuilds.erase(IT);
+                    }
 
-            // std::this_thread::sleep_for(std::chrono::milliseconds(m_HeartbeatInterval));
-        }
-    }
+                    RemoveOrphanUsers(&Candidates);
+                }
 
-    void CDiscordClient::SendOP(CDiscordClient::OPCodes OP, const std::string &D)
-    {
-        SPayload Pay;
-        Pay.OP = (uint32_t)OP;
-        Pay.D = D;
+                // m_BotUser = CreateUser(json);
 
-        try
-        {
-            CJSON json;
-            std::string TT = json.Serialize(Pay);
-            m_Socket.send(json.Serialize(Pay));
-        }
-        catch (const CJSONException &e)
-        {
-            llog << lerror << "Failed to serialize the Payload object. Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
-        }
-    }
+                llog << linfo << "Connected with Discord! " << m_Socket.getUrl() << lendl;
 
-    void CDiscordClient::SendIdentity()
-    {
-        SIdentify id;
-        id.Token = m_Token;
-        id.Properties["$os"] = "linux";
-        id.Properties["$browser"] = "libDiscordBot";
-        id.Properties["$device"] = "libDiscordBot";
-        id.Properties["presence"] = CreateUserInfoJSON();
-        id.Intents = m_Intents;
+                if (m_Controller)
+                    m_Controller->OnReady();
+            }
+            break;
 
-        CJSON json;
-        SendOP(OPCodes::IDENTIFY, json.Serialize(id));
-    }
+            /*------------------------GUILDS Intent------------------------*/
 
-    void CDiscordClient::SendResume()
-    {
-        SResume resume;
-        resume.Token = m_Token;
-        resume.SessionID = m_SessionID;
-        resume.Seq = m_LastSeqNum;
+            case Adler32("GUILD_CREATE"):
+            {
+                json.ParseObject(Pay.D);
 
-        CJSON json;
-        SendOP(OPCodes::RESUME, json.Serialize(resume));
-    }
+                Guild guild = Guild(new CGuild());
+                guild->ID = snowflake(json.GetValue<std::string>("id"));
+                guild->Name = json.GetValue<std::string>("name");
+                guild->Icon = json.GetValue<std::string>("icon");
 
-    void CDiscordClient::OnSpeakFinish(const std::string &Guild)
-    {
-        if(m_Controller)
-        {
-            m_EVManger.PostMessage(QUEUE_NEXT_SONG, Guild);
+                //The guild was loaded from the cache snapshot and is replaced now.
+                Guild SnapshotGuild;
+                {
+                    std::lock_guard<std::mutex> lock(m_GuildListLock);
+                    auto SnapshotIT = std::find(m_SnapshotGuilds.begin(), m_SnapshotGuilds.end(), guild->ID);
+                    if(SnapshotIT != m_SnapshotGuilds.end())
+                    {
+                        m_SnapshotGuilds.erase(SnapshotIT);
+                        SnapshotGuild = m_Guilds.get(guild->ID);
+                    }
+                }
 
-            auto IT = m_Guilds->find(Guild);
-            if(IT != m_Guilds->end())
-                m_Controller->OnEndSpeaking(IT->second);
-        }
-    }
+                //Get all Roles;
+                std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("roles");
+                guild->Roles.update([&Array, &guild](persistent_map<snowflake, Role> &Roles)
+                {
+                    Roles.reserve(Roles.size() + Array.size());
+                    for (auto &&e : Array)
+                    {
+                        Role Tmp;
+                        e >> Tmp;
+                        Tmp = arena_make_shared<CRole>(guild->Arena, *Tmp);
+                        Roles.insert({Tmp->ID, Tmp});
+                    }
+                });
 
-    ix::HttpResponsePtr CDiscordClient::Get(const std::string &URL)
-    {
-        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+                //Get all Channels;
+                Array = json.GetValue<std::vector<std::string>>("channels");
+                guild->Channels.update([this, &Array, &guild](persistent_map<snowflake, Channel> &Channels)
+                {
+                    Channels.reserve(Channels.size() + Array.size());
+                    for (auto &&e : Array)
+                    {
+                        Channel Tmp;
+                        (e & m_Users) >> Tmp;
 
-        //Adds the bot token.
-        args->extraHeaders["Authorization"] = "Bot " + m_Token;
-        args->extraHeaders["User-Agent"] = USER_AGENT;
+                        if(!m_Cache.IsCached(CacheEntity::CHANNELS) && IsEvictableChannel(Tmp))
+                            continue;
 
-        return m_HTTPClient.get(std::string(BASE_URL) + URL, args);
-    }
+                        //The channel objects of the guild create event doesn't contain the guild id.
+                        auto Copy = arena_make_shared<CChannel>(guild->Arena, *Tmp);
+                        Copy->GuildID = guild->ID.load();
+                        Channels.insert({Copy->ID, Copy});
 
-    ix::HttpResponsePtr CDiscordClient::Post(const std::string &URL, const std::string &Body)
-    {
-        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+                        if(IsEvictableChannel(Copy))
+                            m_Cache.Touch(CacheEntity::CHANNELS, SCacheKey(Copy->GuildID, Copy->ID), ApproxSize(Channel(Copy)));
+                    }
+                });
 
-        //Adds the bot token.
-        args->extraHeaders["Authorization"] = "Bot " + m_Token;
-        args->extraHeaders["Content-Type"] = "application/json";
-        args->extraHeaders["User-Agent"] = USER_AGENT;
+                //Get all members.
+                Array = json.GetValue<std::vector<std::string>>("members");
 
-        return m_HTTPClient.post(std::string(BASE_URL) + URL, Body, args);
-    }
+                //Adds all new users with one copy per user shard. Users of the snapshot are replaced.
+                std::vector<std::pair<snowflake, User>> NewUsers;
+                NewUsers.reserve(Array.size());
+                for (auto &&e : Array)
+                {
+                    CJSON Member;
+                    Member.ParseObject(e);
 
-    ix::HttpResponsePtr CDiscordClient::Put(const std::string &URL, const std::string &Body)
-    {
-        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+                    std::string UserInfo = Member.GetValue<std::string>("user");
+                    if(UserInfo.empty())
+                        continue;
 
-        //Adds the bot token.
-        args->extraHeaders["Authorization"] = "Bot " + m_Token;
-        args->extraHeaders["Content-Type"] = "application/json";
-        args->extraHeaders["User-Agent"] = USER_AGENT;
+                    User Tmp = Deserialize<User>(UserInfo);
+                    NewUsers.push_back({Tmp->ID, Tmp});
+                }
 
-        return m_HTTPClient.put(std::string(BASE_URL) + URL, Body, args);
-    }
+                m_Users.insert(NewUsers.begin(), NewUsers.end(), SnapshotGuild != nullptr);
 
-    ix::HttpResponsePtr CDiscordClient::Patch(const std::string &URL, const std::string &Body)
-    {
-        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+                guild->Members.update([this, &Array, &guild](persistent_map<snowflake, GuildMember> &Members)
+                {
+                    Members.reserve(Members.size() + Array.size());
+                    for (auto &&e : Array)
+                    {
+                        CJSON Member;
+                        Member.ParseObject(e);
 
-        //Adds the bot token.
-        args->extraHeaders["Authorization"] = "Bot " + m_Token;
-        args->extraHeaders["Content-Type"] = "application/json";
-        args->extraHeaders["User-Agent"] = USER_AGENT;
+                        CreateMember(Member, guild, &Members);
+                    }
+                });
 
-        return m_HTTPClient.patch(std::string(BASE_URL) + URL, Body, args);
-    }
+                //The registry only holds weak references, so the users are kept until the members own them.
+                NewUsers.clear();
 
-    ix::HttpResponsePtr CDiscordClient::Delete(const std::string &URL, const std::string &Body)
-    {
-        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+                //Large guilds only send a part of the members. The other members of the snapshot are kept, until discord sends them.
+                std::vector<snowflake> Candidates;
+                if(SnapshotGuild)
+                {
+                    bool Partial = json.GetValue<uint32_t>("member_count") > Array.size();
+                    auto Old = SnapshotGuild->Members.load();
+                    guild->Members.update([&Old, &Candidates, Partial](persistent_map<snowflake, GuildMember> &Members)
+                    {
+                        for (auto &&e : *Old)
+                        {
+                            if(Members.count(e.first) != 0)
+                                continue;
 
-        //Adds the bot token.
-        args->extraHeaders["Authorization"] = "Bot " + m_Token;
-        args->extraHeaders["User-Agent"] = USER_AGENT;
+                            if(Partial)
+                                Members.insert(e);
+                            else
+                                Candidates.push_back(e.first);
+                        }
+                    });
+                }
 
-        if(Body != "")
-        {
-            args->extraHeaders["Content-Type"] = "application/json";
-            return m_HTTPClient.request(std::string(BASE_URL) + URL, "DELETE", Body, args);
-        }
-        else
-            return m_HTTPClient.del(std::string(BASE_URL) + URL, args);
-    }
+                //Indexes all members at once, instead of one sorted insert per member.
+                m_MemberIndex.Build(guild->ID, *guild->Members.load());
 
-    void CDiscordClient::OnQueueWaitFinish(const std::string &Guild, AudioSource Source)
-    {
-        if(!Source)
-        {
-            m_EVManger.PostMessage(QUEUE_NEXT_SONG, Guild);
-            return;
-        }
+                //Get all voice states.
+                Array = json.GetValue<std::vector<std::string>>("voice_states");
+                for (auto &&e : Array)
+                {
+                    CJSON State;
+                    State.ParseObject(e);
 
-        VoiceSockets::iterator IT = m_VoiceSockets->find(Guild);
-        if(IT != m_VoiceSockets->end())
-            IT->second->StartSpeaking(Source);
-    }
+                    CreateVoiceState(State, guild);
+                }
 
-    std::string CDiscordClient::OnlineStateToStr(OnlineState state)
-    {
-        switch(state)
-        {
-            case OnlineState::ONLINE:
-            {
-                return "online";
-            }break;
+                //Gets the owner object.
+                snowflake OwnerID = snowflake(json.GetValue<std::string>("owner_id"));
+                guild->Owner = GetMember(guild, OwnerID);
+                m_Guilds.set(guild->ID, guild);
+                m_Permissions.InvalidateGuild(guild->ID);
 
-            case OnlineState::DND:
-            {
-                return "dnd";
-            }break;
+                if(SnapshotGuild)
+                {
+                    SnapshotGuild = nullptr;
+                    RemoveOrphanUsers(&Candidates);
+                }
 
-            case OnlineState::IDLE:
-            {
-                return "idle";
+                bool WasUnavailable = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_GuildListLock);
+                    auto IT = std::find(m_Unavailables.begin(), m_Unavailables.end(), guild->ID);
+                    if(IT != m_Unavailables.end())
+                    {
+                        m_Unavailables.erase(IT);
+                        WasUnavailable = true;
+                    }
+                }
+
+                if(WasUnavailable)
+                {
+                    if(m_Controller)
+                        m_Controller->OnGuildAvailable(guild);
+                }
+                else if(m_Controller)
+                    m_Controller->OnGuildJoin(guild);
+            }break;
+
+            case Adler32("GUILD_DELETE"):
+            {
+                json.ParseObject(Pay.D);
+
+                Guild guild = m_Guilds.get(snowflake(json.GetValue<std::string>("id")));
+                if(guild)
+                {
+                    bool Unavailable = json.GetValue<bool>("unavailable");
+                    bool Known = false;
+                    {
+                        std::lock_guard<std::mutex> lock(m_GuildListLock);
+                        auto InnerIT = std::find(m_Unavailables.begin(), m_Unavailables.end(), guild->ID);
+                        Known = InnerIT != m_Unavailables.end();
+
+                        if(Unavailable && m_Controller && Known)
+                            m_Unavailables.erase(InnerIT);
+                        else if(Unavailable || !m_Controller)
+                            m_Unavailables.push_back(guild->ID);
+                    }
+
+                    if(Unavailable && m_Controller && Known)
+                        m_Controller->OnGuildUnavailable(guild);
+                    else if(!Unavailable && m_Controller)
+                        m_Controller->OnGuildLeave(guild);
+
+                    m_VoiceSockets->erase(guild->ID);
+                    m_MusicQueues->erase(guild->ID);
+                    m_RESTCache.Invalidate("/guilds/" + guild->ID);
+                    m_Cache.RemoveGuild(guild->ID);
+                    m_Messages.RemoveGuild(guild->ID);
+                    m_MemberIndex.RemoveGuild(guild->ID);
+                    m_Permissions.InvalidateGuild(guild->ID);
+                    m_Guilds.erase(guild->ID);
+
+                    //Unpins the users, which were only referenced by this guild.
+                    std::vector<snowflake> Candidates;
+                    auto Members = guild->Members.load();
+                    Candidates.reserve(Members->size());
+                    for (auto &&e : *Members)
+                        Candidates.push_back(e.first);
+
+                    Members = nullptr;
+                    guild = nullptr;
+                    RemoveOrphanUsers(&Candidates);
+                }
+
+                llog << linfo << "GUILD_DELETE" << lendl;
+            }break;
+
+            /*------------------------GUILDS Intent------------------------*/
+
+            /*------------------------CHANNEL Intent------------------------*/
+
+            case Adler32("CHANNEL_CREATE"):
+            {
+                Channel Tmp;
+                (Pay.D & m_Users) >> Tmp;
+
+                Guild guild = m_Guilds.get(Tmp->GuildID);
+                if(guild && (m_Cache.IsCached(CacheEntity::CHANNELS) || !IsEvictableChannel(Tmp)))
+                {
+                    Tmp = arena_make_shared<CChannel>(guild->Arena, *Tmp);
+                    guild->Channels.insert(Tmp->ID, Tmp);
+                    if(IsEvictableChannel(Tmp))
+                        m_Cache.Touch(CacheEntity::CHANNELS, SCacheKey(Tmp->GuildID, Tmp->ID), ApproxSize(Tmp));
+                }
+            }break;
+
+            case Adler32("CHANNEL_UPDATE"):
+            {
+                Channel Tmp;
+                (Pay.D & m_Users) >> Tmp;
+
+                Guild guild = m_Guilds.get(Tmp->GuildID);
+                if(guild && (m_Cache.IsCached(CacheEntity::CHANNELS) || !IsEvictableChannel(Tmp)))
+                {
+                    Tmp = arena_make_shared<CChannel>(guild->Arena, *Tmp);
+                    guild->Channels.set(Tmp->ID, Tmp);
+                    if(IsEvictableChannel(Tmp))
+                        m_Cache.Touch(CacheEntity::CHANNELS, SCacheKey(Tmp->GuildID, Tmp->ID), ApproxSize(Tmp));
+                }
+
+                m_Permissions.InvalidateChannel(Tmp->GuildID, Tmp->ID);
+                m_RESTCache.Invalidate("/channels/" + Tmp->ID);
+            }break;
+
+            case Adler32("CHANNEL_DELETE"):
+            {
+                Channel Tmp;
+                (Pay.D & m_Users) >> Tmp;
+
+                Guild guild = m_Guilds.get(Tmp->GuildID);
+                if(guild)
+                    guild->Channels.erase(Tmp->ID);
+
+                m_Cache.Remove(CacheEntity::CHANNELS, SCacheKey(Tmp->GuildID, Tmp->ID));
+                m_Permissions.InvalidateChannel(Tmp->GuildID, Tmp->ID);
+
+                auto Webhook = m_Webhooks->lower_bound(std::make_pair(Tmp->ID, std::string()));
+                while (Webhook != m_Webhooks->end() && Webhook->first.first == Tmp->ID)
+                    Webhook = m_Webhooks->erase(Webhook);
+
+                m_Messages.RemoveChannel(Tmp->ID);
+                m_RESTCache.Invalidate("/channels/" + Tmp->ID);
+            }break;
+
+            case Adler32("GUILD_ROLE_CREATE"):
+            case Adler32("GUILD_ROLE_UPDATE"):
+            {
+                json.ParseObject(Pay.D);
+                snowflake GuildID = snowflake(json.GetValue<std::string>("guild_id"));
+
+                Role Tmp;
+                json.GetValue<std::string>("role") >> Tmp;
+
+                Guild guild = m_Guilds.get(GuildID);
+                //Members only store the role ids, so replacing the object is enough.
+                if(guild)
+                    guild->Roles.set(Tmp->ID, arena_make_shared<CRole>(guild->Arena, *Tmp));
+
+                m_Permissions.InvalidateGuild(GuildID);
+                m_RESTCache.Invalidate("/guilds/" + GuildID + "/roles");
+            }break;
+
+            case Adler32("GUILD_ROLE_DELETE"):
+            {
+                json.ParseObject(Pay.D);
+                snowflake GuildID = snowflake(json.GetValue<std::string>("guild_id"));
+                snowflake RoleID = snowflake(json.GetValue<std::string>("role_id"));
+
+                Guild guild = m_Guilds.get(GuildID);
+                //Dangling role ids of the members are skipped by CGuild::GetRoles.
+                if(guild)
+                    guild->Roles.erase(RoleID);
+
+                m_Permissions.InvalidateGuild(GuildID);
+                m_RESTCache.Invalidate("/guilds/" + GuildID + "/roles");
+            }break;
+
+            /*------------------------CHANNEL Intent------------------------*/
+
+            /*------------------------GUILD_MEMBERS Intent------------------------*/
+            //ATTENTION: NEEDS "Server Members Intent" ACTIVATED TO WORK, OTHERWISE THE BOT FAIL TO CONNECT AND A ERROR IS WRITTEN TO THE CONSOLE!!!
+
+            case Adler32("GUILD_MEMBER_ADD"):
+            {
+                CJSON Member;
+                Member.ParseObject(Pay.D);
+
+                snowflake GuildID = snowflake(Member.GetValue<std::string>("guild_id"));
+
+                Guild guild = m_Guilds.get(GuildID);
+                if(guild)
+                {
+                    GuildMember Tmp = CreateMember(Member, guild);
+
+                    if(m_Controller)
+                        m_Controller->OnMemberAdd(guild, Tmp);
+                }
+                else
+                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
+            }break;
+
+            case Adler32("GUILD_MEMBER_UPDATE"):
+            {
+                json.ParseObject(Pay.D);
+                snowflake GuildID = snowflake(json.GetValue<std::string>("guild_id"));
+                int64_t Premium = ISO8601ToMillis(json.GetValue<std::string>("premium_since"));
+                std::string Nick = json.GetValue<std::string>("nick");
+                std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("roles");
+
+                //The member update also carries the changes of the user, e.g. a new username or avatar.
+                User user = UpdateUser(json.GetValue<std::string>("user"), Pay.S);
+                snowflake UserID = user->ID;
+
+                Guild guild = m_Guilds.get(GuildID);
+                if(guild)
+                {
+                    std::vector<snowflake> Roles;
+                    Roles.reserve(Array.size());
+                    for (auto &&e : Array)
+                    {
+                        snowflake RoleID(e);
+                        if(guild->Roles.contains(RoleID))
+                            Roles.push_back(RoleID);
+                    }
+
+                    //Copies the member under the write lock of the member cache, so a concurrent eviction or update isn't overwritten.
+                    GuildMember Old, member;
+                    guild->Members.update([&](persistent_map<snowflake, GuildMember> &Members)
+                    {
+                        auto IT = Members.find(UserID);
+                        if(IT == Members.end())
+                            return;
+
+                        auto Copy = arena_make_shared<CGuildMember>(guild->Arena, *IT->second);
+                        Copy->UserRef = user;
+                        Copy->Roles = std::move(Roles);
+                        Copy->Nick = Nick;
+                        Copy->PremiumSince = Premium;
+
+                        Old = IT->second;
+                        IT->second = Copy;
+                        member = Copy;
+                    });
+
+                    if(member)
+                    {
+                        m_Cache.Touch(CacheEntity::MEMBERS, SCacheKey(GuildID, UserID), ApproxSize(member));
+                        m_MemberIndex.Update(Old, member);
+
+                        if(m_Controller)
+                            m_Controller->OnMemberUpdate(guild, member);
+                    } 
+                }
+                else
+                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
+
+                m_Permissions.InvalidateMember(GuildID, UserID);
+                m_RESTCache.Invalidate("/guilds/" + GuildID + "/members/" + UserID);
+            }break;
+
+            case Adler32("GUILD_BAN_ADD"):
+            case Adler32("GUILD_MEMBER_REMOVE"):
+            {
+                json.ParseObject(Pay.D);
+                snowflake GuildID = snowflake(json.GetValue<std::string>("guild_id"));
+
+                json.ParseObject(json.GetValue<std::string>("user"));
+                snowflake UserID = snowflake(json.GetValue<std::string>("id"));
+
+                Guild guild = m_Guilds.get(GuildID);
+                if(guild)
+                {
+                    SCacheKey Key(GuildID, UserID);
+                    m_Cache.Remove(CacheEntity::MEMBERS, Key);
+                    m_Cache.Remove(CacheEntity::VOICE_STATES, Key);
+                    m_Permissions.InvalidateMember(GuildID, UserID);
+
+                    GuildMember member = guild->Members.get(UserID);
+                    if(member)
+                    {
+                        guild->Members.erase(UserID);
+                        m_MemberIndex.Remove(member);
+
+                        if(m_Controller)
+                            m_Controller->OnMemberRemove(guild, member);
+
+                        member = nullptr;
+                    }                                
+
+                    //The user is released with the last member, which references it. The sweeper removes the registry entry.
+                }
+                else
+                    llog << ldebug << "Invalid Guild ( " << GuildID << " ) " << lendl;
+
+                m_RESTCache.Invalidate("/guilds/" + GuildID + "/members/" + UserID);
+            }break;
+
+            /*------------------------GUILD_MEMBERS Intent------------------------*/
+
+            /*------------------------GUILD_PRESENCES Intent------------------------*/
+            //ATTENTION: NEEDS "Presence Intent" ACTIVATED TO WORK, OTHERWISE THE BOT FAIL TO CONNECT AND A ERROR IS WRITTEN TO THE CONSOLE!!!
+
+            case Adler32("PRESENCE_UPDATE"):
+            { 
+                json.ParseObject(Pay.D);
+                User user = m_Users | json.GetValue<std::string>("user");
+
+                std::string Status = json.GetValue<std::string>("status");
+                std::string ClientStatus = json.GetValue<std::string>("client_status");
+                std::vector<std::string> Acts = json.GetValue<std::vector<std::string>>("activities");
+
+                uint64_t Hash = FNV1a(ClientStatus, FNV1a(Status));
+                for (auto &&e : Acts)
+                    Hash = FNV1a(e, Hash);
+
+                //Discord sends the same presence once per shared guild. Drops it before the activities are parsed.
+                if(!m_Presences.IsChanged(user->ID, Hash, Pay.S))
+                    break;
+
+                SPresence Presence;
+                Presence.State = StrToOnlineState(Status);
+                Presence.Activities.reserve(Acts.size());
+                for (auto &&e : Acts)
+                {
+                    CJSON JAct;
+                    JAct.ParseObject(e);
+                    Presence.Activities.push_back(CreateActivity(JAct));
+                }
+
+                CJSON JClientState;
+                JClientState.ParseObject(ClientStatus); 
+
+                Presence.Desktop = StrToOnlineState(JClientState.GetValue<std::string>("desktop"));      
+                Presence.Mobile = StrToOnlineState(JClientState.GetValue<std::string>("mobile"));   
+                Presence.Web = StrToOnlineState(JClientState.GetValue<std::string>("web"));                      
+
+                size_t Bytes = ApproxSize(Presence);
+                if(!m_Presences.Set(user->ID, Hash, Pay.S, std::move(Presence)))
+                    break;
+
+                m_Cache.Touch(CacheEntity::PRESENCES, SCacheKey(snowflake(), user->ID), Bytes);
+
+                Guild guild = m_Guilds.get(snowflake(json.GetValue<std::string>("guild_id")));
+                if(guild && m_Controller)
+                {
+                    //Doesn't request missing members, presence updates are too frequent for this.
+                    GuildMember member = guild->Members.get(user->ID);
+                    if(!member)
+                    {
+                        auto Stub = std::make_shared<CGuildMember>();
+                        Stub->GuildID = guild->ID.load();
+                        Stub->UserRef = user;
+                        member = Stub;
+                    }
+
+                    m_Controller->OnPresenceUpdate(guild, member);
+                }
+
+                //The presence is only available during the callback, if presences aren't cached.
+                if(!m_Cache.IsCached(CacheEntity::PRESENCES) && user->ID != m_BotUser->ID)
+                    m_Presences.Erase(user->ID);
+            }break;
+
+            /*------------------------GUILD_PRESENCES Intent------------------------*/
+
+            /*------------------------GUILD_VOICE_STATES Intent------------------------*/
+
+            case Adler32("VOICE_STATE_UPDATE"):
+            {
+                json.ParseObject(Pay.D);
+
+                Guild G = m_Guilds.get(snowflake(json.GetValue<std::string>("guild_id")));
+                GuildMember M = G ? G->Members.get(snowflake(json.GetValue<std::string>("user_id"))) : nullptr;
+                Channel c;
+                if(M && M->State)
+                    c = M->State->ChannelRef;   //Saves the old channel.
+
+                VoiceState Tmp = CreateVoiceState(json, nullptr);
+
+                if (m_Controller && Tmp->GuildRef)
+                {
+                    if(Tmp->UserRef)
+                    {
+                        if(Tmp->UserRef->ID == m_BotUser->ID && !Tmp->ChannelRef)
+                        {
+                            m_VoiceSockets->erase(Tmp->GuildRef->ID);
+                            m_MusicQueues->erase(Tmp->GuildRef->ID);
+                        }
+
+                        GuildMember member = Tmp->GuildRef->Members.get(Tmp->UserRef->ID);
+                        if(member)
+                        {
+                            m_Controller->OnVoiceStateUpdate(Tmp->GuildRef, member);
+
+                            auto AIT = m_Admins->find(Tmp->GuildRef->ID);
+                            if(AIT != m_Admins->end())
+                            {
+                                auto Admin = std::dynamic_pointer_cast<CGuildAdmin>(AIT->second);
+
+                                if(!c)
+                                    c = Tmp->ChannelRef;
+
+                                if(c)
+                                    Admin->OnUserVoiceStateChanged(c, member);
+                            }
+                        }
+                    }
+                }   
+            }break;
+
+            /*------------------------GUILD_VOICE_STATES Intent------------------------*/
+
+            //Called if your bot joins a voice channel.
+            case Adler32("VOICE_SERVER_UPDATE"):
+            {
+                json.ParseObject(Pay.D);
+                Guild guild = m_Guilds.get(snowflake(json.GetValue<std::string>("guild_id")));
+                if (guild)
+                {
+                    GuildMember BotMember = guild->Members.get(m_BotUser->ID);
+                    if (BotMember)
+                    {
+                        VoiceSocket Socket = VoiceSocket(new CVoiceSocket(json, BotMember->State->SessionID, m_BotUser->ID.str()));
+                        Socket->SetOnSpeakFinish(std::bind(&CDiscordClient::OnSpeakFinish, this, std::placeholders::_1));
+                        m_VoiceSockets->insert({guild->ID, Socket});
+
+                        //Creates a music queue for the server.
+                        if(m_QueueFactory)
+                        {
+                            if(m_MusicQueues->find(guild->ID) == m_MusicQueues->end())
+                            {
+                                MusicQueue MQ = m_QueueFactory->Create();
+                                MQ->SetGuildID(guild->ID);
+                                MQ->SetOnWaitFinishCallback(std::bind(&CDiscordClient::OnQueueWaitFinish, this, std::placeholders::_1, std::placeholders::_2));
+                                m_MusicQueues->insert({guild->ID, MQ});
+                            }
+                        }
+
+                        //Plays the queued audiosource.
+                        AudioSources::iterator IT = m_AudioSources->find(guild->ID);
+                        if (IT != m_AudioSources->end())
+                        {
+                            Socket->StartSpeaking(IT->second);
+                            m_AudioSources->erase(IT);
+                        }
+                    }
+                }
+            }break;
+
+            /*------------------------GUILD_MESSAGES Intent------------------------*/
+
+            case Adler32("MESSAGE_CREATE"):
+            case Adler32("MESSAGE_UPDATE"):
+            case Adler32("MESSAGE_DELETE"):
+            {
+                json.ParseObject(Pay.D);
+                Message msg = CreateMessage(json);
+
+                std::shared_ptr<CGuildAdmin> Admin;
+                if(msg->GuildRef)
+                {
+                    auto AIT = m_Admins->find(msg->GuildRef->ID);
+                    if(AIT != m_Admins->end())
+                        Admin = std::dynamic_pointer_cast<CGuildAdmin>(AIT->second);
+                }
+
+                switch (Adler32(Pay.T.c_str()))
+                {
+                    case Adler32("MESSAGE_CREATE"):
+                    {
+                        m_Messages.Add(msg);
+
+                        if (m_Controller)
+                            m_Controller->OnMessage(msg);
+
+                        if(Admin)
+                            Admin->OnMessageEvent(ActionType::MESSAGE_CREATED, msg->ChannelRef, msg);
+                    }break;
+
+                    case Adler32("MESSAGE_UPDATE"):
+                    {
+                        //Applies the edit to a copy of the cached message, the cached object could be in use by the controller.
+                        Message Cached = m_Messages.Get(msg->ChannelRef->ID, msg->ID);
+                        if(Cached)
+                        {
+                            auto Copy = std::make_shared<CMessage>(*Cached);
+
+                            //Updates without an edit timestamp only add embeds and don't contain the content.
+                            if(!msg->EditedTimestamp.empty())
+                            {
+                                Copy->Content = msg->Content;
+                                Copy->EditedTimestamp = msg->EditedTimestamp;
+                                Copy->Mention = msg->Mention;
+                                Copy->Mentions = std::move(msg->Mentions);
+                                Copy->RoleMentions = std::move(msg->RoleMentions);
+                                Copy->ChannelMentions = std::move(msg->ChannelMentions);
+                            }
+
+                            m_Messages.Replace(Copy);
+                            msg = Copy;
+                        }
+
+                        if (m_Controller)
+                            m_Controller->OnMessageEdited(msg);
+
+                        if(Admin)
+                            Admin->OnMessageEvent(ActionType::MESSAGE_EDITED, msg->ChannelRef, msg);
+                    }break;
+
+                    case Adler32("MESSAGE_DELETE"):
+                    {
+                        Message Cached = m_Messages.Remove(msg->ChannelRef->ID, msg->ID);
+                        if(Cached)
+                            msg = Cached;
+
+                        if (m_Controller)
+                            m_Controller->OnMessageDeleted(msg);
+
+                        if(Admin)
+                            Admin->OnMessageEvent(ActionType::MESSAGE_DELETED, msg->ChannelRef, msg);
+                    }break;
+                }
+
+            }break;
+
+            /*------------------------GUILD_MESSAGES Intent------------------------*/
+
+            //Called if a session resumed.
+            case Adler32("RESUMED"):
+            {
+                llog << linfo << "Resumed" << lendl;
+
+                if (m_Controller)
+                    m_Controller->OnResume();
+            } break;
+        }
+    }
+
+    snowflake CDiscordClient::GetDispatchKey(size_t Event, const std::string &Data)
+    {
+        //Runs on the socket thread, so the payload is only scanned for the key and parsed by the worker.
+        if(Event == Adler32("GUILD_CREATE") || Event == Adler32("GUILD_DELETE"))
+            return snowflake(FindTopLevelString(Data, "id"));
+
+        //Events without a guild, e.g. direct messages, share one worker.
+        return snowflake(FindTopLevelString(Data, "guild_id"));
+    }
+
+    void CDiscordClient::Heartbeat()
+    {
+        while (!m_Terminate)
+        {
+            //The interval is measured from the start of the beat, so the time to send doesn't delay the next beat.
+            int64_t Beg = GetTimeMillis();
+
+            //Start a reconnect.
+            if (!m_HeartACKReceived)
+            {
+                m_Socket.stop();
+
+                // m_Users->clear();
+                // m_Guilds->clear();
+
+                m_VoiceSockets->clear();
+
+                if (m_Controller)
+                    m_Controller->OnDisconnect();
+
+                m_Terminate = true;
+                m_EVManger.PostMessage(RESUME, 0, 100);
+
+                break;
+            }
+
+            SendOP(OPCodes::HEARTBEAT, m_LastSeqNum != -1 ? std::to_string(m_LastSeqNum) : "");
+            m_HeartACKReceived = false;
+
+            // Terminateable timeout.
+            while (((GetTimeMillis() - Beg) < m_HeartbeatInterval) && !m_Terminate)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            // std::this_thread::sleep_for(std::chrono::milliseconds(m_HeartbeatInterval));
+        }
+    }
+
+    void CDiscordClient::SendOP(CDiscordClient::OPCodes OP, const std::string &D)
+    {
+        SPayload Pay;
+        Pay.OP = (uint32_t)OP;
+        Pay.D = D;
+
+        try
+        {
+            CJSON json;
+            std::string TT = json.Serialize(Pay);
+            m_Socket.send(json.Serialize(Pay));
+        }
+        catch (const CJSONException &e)
+        {
+            llog << lerror << "Failed to serialize the Payload object. Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
+        }
+    }
+
+    void CDiscordClient::SendIdentity()
+    {
+        SIdentify id;
+        id.Token = m_Token;
+        id.Properties["$os"] = "linux";
+        id.Properties["$browser"] = "libDiscordBot";
+        id.Properties["$device"] = "libDiscordBot";
+        id.Properties["presence"] = CreateUserInfoJSON();
+        id.Intents = m_Intents;
+
+        CJSON json;
+        SendOP(OPCodes::IDENTIFY, json.Serialize(id));
+    }
+
+    void CDiscordClient::SendResume()
+    {
+        SResume resume;
+        resume.Token = m_Token;
+        resume.SessionID = m_SessionID;
+        resume.Seq = m_LastSeqNum;
+
+        CJSON json;
+        SendOP(OPCodes::RESUME, json.Serialize(resume));
+    }
+
+    void CDiscordClient::OnSpeakFinish(snowflake Guild)
+    {
+        if(m_Controller)
+        {
+            m_EVManger.PostMessage(QUEUE_NEXT_SONG, Guild);
+
+            auto guild = m_Guilds.get(Guild);
+            if(guild)
+                m_Controller->OnEndSpeaking(guild);
+        }
+    }
+
+    ix::HttpResponsePtr CDiscordClient::Get(const std::string &URL, RequestPriority Priority)
+    {
+        //Cached responses don't cost any rate limit.
+        auto res = m_RESTCache.Get(URL);
+        if(res)
+            return res;
+
+        uint64_t Generation = m_RESTCache.Begin();
+        res = m_REST->Request("GET", URL, "", "application/json", Priority);
+        m_RESTCache.Put(URL, res, Generation);
+
+        return res;
+    }
+
+    ix::HttpResponsePtr CDiscordClient::Post(const std::string &URL, const std::string &Body, RequestPriority Priority)
+    {
+        //Invalidates after the write, so a read which ran in parallel isn't cached with the old state.
+        auto res = m_REST->Request("POST", URL, Body, "application/json", Priority);
+        m_RESTCache.InvalidateWrite(URL);
+
+        return res;
+    }
+
+    ix::HttpResponsePtr CDiscordClient::Put(const std::string &URL, const std::string &Body, RequestPriority Priority)
+    {
+        auto res = m_REST->Request("PUT", URL, Body, "application/json", Priority);
+        m_RESTCache.InvalidateWrite(URL);
+
+        return res;
+    }
+
+    ix::HttpResponsePtr CDiscordClient::Patch(const std::string &URL, const std::string &Body, RequestPriority Priority)
+    {
+        auto res = m_REST->Request("PATCH", URL, Body, "application/json", Priority);
+        m_RESTCache.InvalidateWrite(URL);
+
+        return res;
+    }
+
+    ix::HttpResponsePtr CDiscordClient::Delete(const std::string &URL, const std::string &Body, RequestPriority Priority)
+    {
+        auto res = m_REST->Request("DELETE", URL, Body, "application/json", Priority);
+        m_RESTCache.InvalidateWrite(URL);
+
+        return res;
+    }
+
+    void CDiscordClient::OnQueueWaitFinish(snowflake Guild, AudioSource Source)
+    {
+        if(!Source)
+        {
+            m_EVManger.PostMessage(QUEUE_NEXT_SONG, Guild);
+            return;
+        }
+
+        VoiceSockets::iterator IT = m_VoiceSockets->find(Guild);
+        if(IT != m_VoiceSockets->end())
+            IT->second->StartSpeaking(Source);
+    }
+
+    std::string CDiscordClient::OnlineStateToStr(OnlineState state)
+    {
+        switch(state)
+        {
+            case OnlineState::ONLINE:
+            {
+                return "online";
+            }break;
+
+            case OnlineState::DND:
+            {
+                return "dnd";
+            }break;
+
+            case OnlineState::IDLE:
+            {
+                return "idle";
+            }break;
+
+            case OnlineState::INVISIBLE:
+            {
+                return "invisible";
+            }break;
+            
+            case OnlineState::OFFLINE:
+            {
+                return "offline";
+            }break;
+
+            default:
+            {
+                return "offline";
+            }break;
+        }
+    }
+
+    OnlineState CDiscordClient::StrToOnlineState(const std::string &state)
+    {
+        switch(Adler32(state.c_str()))
+        {
+            case Adler32("online"):
+            {
+                return OnlineState::ONLINE;
+            }break;
+
+            case Adler32("dnd"):
+            {
+                return OnlineState::DND;
             }break;
 
-            case OnlineState::INVISIBLE:
+            case Adler32("idle"):
             {
-                return "invisible";
+                return OnlineState::IDLE;
             }break;
-            
-            case OnlineState::OFFLINE:
+
+            case Adler32("invisible"):
             {
-                return "offline";
+                return OnlineState::INVISIBLE;
+            }break;
+
+            case Adler32("offline"):
+            {
+                return OnlineState::OFFLINE;
             }break;
 
             default:
             {
-                return "offline";
+                return OnlineState::OFFLINE;
             }break;
         }
     }
 
-    OnlineState CDiscordClient::StrToOnlineState(const std::string &state)
+    GuildMember CDiscordClient::GetMember(Guild guild, snowflake UserID)
+    {
+        if(!guild)
+            return nullptr;
+
+        GuildMember Ret = guild->Members.get(UserID);
+
+        if(Ret)
+            m_Cache.Touch(CacheEntity::MEMBERS, SCacheKey(guild->ID, UserID), ApproxSize(Ret));
+        else
+        {
+            auto res = Get("/guilds/" + guild->ID + "/members/" + UserID);
+            if (res->statusCode != 200)
+                llog << lerror << "Failed to receive member " << UserID << " of guild " << guild->ID.load() << " HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
+            else
+            {
+                try
+                {    
+                    CJSON JOwner;
+                    JOwner.ParseObject(res->body);
+
+                    Ret = CreateMember(JOwner, guild);
+                }
+                catch (const CJSONException &e)
+                {
+                    llog << lerror << "Failed to parse member JSON Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
+                    return nullptr;
+                }
+            }
+        }
+
+        return Ret;
+    }
+
+    GuildMember CDiscordClient::CreateMember(CJSON &json, Guild guild, persistent_map<snowflake, GuildMember> *Batch)
+    {
+        auto Ret = arena_make_shared<CGuildMember>(guild->Arena);
+        std::string UserInfo = json.GetValue<std::string>("user");
+        User member;
+
+        //Gets the user which is associated with the member.
+        if (!UserInfo.empty())
+            member = m_Users | UserInfo;
+
+        Ret->GuildID = guild->ID.load();
+        Ret->UserRef = member;
+        Ret->Nick = json.GetValue<std::string>("nick");
+        Ret->JoinedAt = ISO8601ToMillis(json.GetValue<std::string>("joined_at"));
+        Ret->PremiumSince = ISO8601ToMillis(json.GetValue<std::string>("premium_since"));
+        Ret->Deaf = json.GetValue<bool>("deaf");
+        Ret->Mute = json.GetValue<bool>("mute");
+
+        //Adds the roles
+        auto Array = json.GetValue<std::vector<std::string>>("roles");
+        auto Roles = guild->Roles.load();
+        Ret->Roles.reserve(Array.size());
+        for (auto &&e : Array)
+        {
+            snowflake RoleID(e);
+            if(Roles->count(RoleID) != 0)
+                Ret->Roles.push_back(RoleID);
+        }
+
+        //The bot member is always cached.
+        if (Ret->UserRef && (m_Cache.IsCached(CacheEntity::MEMBERS) || Ret->UserRef->ID == m_BotUser->ID))
+        {
+            if(Batch)
+                Batch->insert({Ret->UserRef->ID, Ret});
+            else if(guild->Members.insert(Ret->UserRef->ID, Ret))
+            {
+                m_Permissions.InvalidateMember(Ret->GuildID, Ret->UserRef->ID);
+                m_MemberIndex.Add(Ret);
+            }
+
+            m_Cache.Touch(CacheEntity::MEMBERS, SCacheKey(Ret->GuildID, Ret->UserRef->ID), ApproxSize(GuildMember(Ret)));
+        }
+
+        return Ret;
+    }
+
+    VoiceState CDiscordClient::CreateVoiceState(CJSON &json, Guild guild)
+    {
+        if (!guild)
+            guild = m_Guilds.get(snowflake(json.GetValue<std::string>("guild_id")));
+
+        auto Ret = arena_make_shared<CVoiceState>(guild ? guild->Arena : nullptr);
+        Ret->GuildRef = guild;
+
+        Ret->UserRef = m_Users.get(snowflake(json.GetValue<std::string>("user_id")));
+        Ret->SessionID = json.GetValue<std::string>("session_id");
+        Ret->Deaf = json.GetValue<bool>("deaf");
+        Ret->Mute = json.GetValue<bool>("mute");
+        Ret->SelfDeaf = json.GetValue<bool>("self_deaf");
+        Ret->SelfMute = json.GetValue<bool>("self_mute");
+        Ret->SelfStream = json.GetValue<bool>("self_stream");
+        Ret->Supress = json.GetValue<bool>("suppress");
+
+        if (Ret->GuildRef)
+        {
+            Ret->ChannelRef = Ret->GuildRef->Channels.get(snowflake(json.GetValue<std::string>("channel_id")));
+
+            //Adds this voice state to the guild member.
+            GuildMember Member = Ret->GuildRef->Members.get(snowflake(json.GetValue<std::string>("user_id")));
+            if (!Member)
+            {
+                //Creates a new member.
+                try
+                {
+                    CJSON JMember;
+                    JMember.ParseObject(json.GetValue<std::string>("member"));
+
+                    Member = CreateMember(JMember, Ret->GuildRef);
+                }
+                catch (const CJSONException &e)
+                {
+                    llog << lerror << "Failed to parse JSON for VoiceState member Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
+                    return Ret;
+                }
+            }
+
+            //Replaces the member with a copy which holds the new state. The state is removed if the user isn't in a voice channel.
+            if (Member && Member->UserRef)
+            {
+                SCacheKey Key(Member->GuildID, Member->UserRef->ID);
+                bool Cached = Ret->ChannelRef && (m_Cache.IsCached(CacheEntity::VOICE_STATES) || Key.ID == m_BotUser->ID);
+                bool Found = false;
+
+                //Copies the current member under the write lock, so a concurrent eviction or update isn't overwritten.
+                Ret->GuildRef->Members.update([&](persistent_map<snowflake, GuildMember> &Members)
+                {
+                    auto IT = Members.find(Key.ID);
+                    if(IT == Members.end())
+                        return;
+
+                    auto Copy = arena_make_shared<CGuildMember>(Ret->GuildRef->Arena, *IT->second);
+                    Copy->State = Cached ? Ret : nullptr;
+                    IT->second = Copy;
+                    Found = true;
+                });
+
+                if (Found && Cached)
+                    m_Cache.Touch(CacheEntity::VOICE_STATES, Key, ApproxSize(VoiceState(Ret)));
+                else
+                    m_Cache.Remove(CacheEntity::VOICE_STATES, Key);
+            }
+        }
+
+        return Ret;
+    }
+
+    Message CDiscordClient::CreateMessage(CJSON &json)
+    {
+        Message Ret = Message(new CMessage());
+        Channel channel;
+
+        Ret->GuildRef = m_Guilds.get(snowflake(json.GetValue<std::string>("guild_id")));
+        if (Ret->GuildRef)
+        {
+            channel = Ret->GuildRef->Channels.get(snowflake(json.GetValue<std::string>("channel_id")));
+            if(channel)
+                m_Cache.Touch(CacheEntity::CHANNELS, SCacheKey(channel->GuildID, channel->ID), ApproxSize(channel));
+        }
+
+        //Creates a dummy object for DMs and evicted channels.
+        if (!channel)
+        {
+            auto Dummy = std::make_shared<CChannel>();
+            Dummy->ID = snowflake(json.GetValue<std::string>("channel_id"));
+            if(Ret->GuildRef)
+            {
+                Dummy->GuildID = Ret->GuildRef->ID.load();
+                Dummy->Type = ChannelTypes::GUILD_TEXT;
+            }
+            else
+                Dummy->Type = ChannelTypes::DM;
+
+            channel = Dummy;
+        }
+
+        Ret->ID = snowflake(json.GetValue<std::string>("id"));
+        Ret->ChannelRef = channel;
+
+        std::string UserJson = json.GetValue<std::string>("author");
+        if (!UserJson.empty())
+        {
+            User user = m_Users | UserJson;
+            Ret->Author = user;
+
+            //Gets the guild member, if this message is not a dm.
+            if (Ret->GuildRef)
+                Ret->Member = GetMember(Ret->GuildRef, Ret->Author->ID);
+        }
+
+        Ret->Content = json.GetValue<std::string>("content");
+        Ret->Timestamp = json.GetValue<std::string>("timestamp");
+        Ret->EditedTimestamp = json.GetValue<std::string>("edited_timestamp");
+        Ret->Mention = json.GetValue<bool>("mention_everyone");
+
+        std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("mentions");
+        for (auto &&e : Array)
+        {
+            User user = m_Users | e;
+            bool Found = false;
+
+            if (Ret->GuildRef)
+            {
+                GuildMember member = Ret->GuildRef->Members.get(user->ID);
+                if (member)
+                {
+                    Found = true;
+                    Ret->Mentions.push_back(member);
+                }
+            }
+
+            //Create a fake Guildmember for DMs.
+            if (!Found)
+            {
+                auto Dummy = std::make_shared<CGuildMember>();
+                Dummy->UserRef = user;
+                Ret->Mentions.push_back(Dummy);
+            }
+        }
+
+        if (Ret->GuildRef)
+        {
+            Array = json.GetValue<std::vector<std::string>>("mention_roles");
+            Ret->RoleMentions.reserve(Array.size());
+            for (auto &&e : Array)
+            {
+                Role role = Ret->GuildRef->Roles.get(snowflake(e));
+                if(role)
+                    Ret->RoleMentions.push_back(role);
+            }
+        }
+
+        //Only sent for crossposted messages, the channels may be part of another guild.
+        Array = json.GetValue<std::vector<std::string>>("mention_channels");
+        Ret->ChannelMentions.reserve(Array.size());
+        for (auto &&e : Array)
+        {
+            CJSON JChannel;
+            JChannel.ParseObject(e);
+
+            snowflake ChannelID(JChannel.GetValue<std::string>("id"));
+            snowflake GuildID(JChannel.GetValue<std::string>("guild_id"));
+
+            Guild guild = Ret->GuildRef && Ret->GuildRef->ID.load() == GuildID ? Ret->GuildRef : m_Guilds.get(GuildID);
+            Channel channel = guild ? guild->Channels.get(ChannelID) : nullptr;
+
+            //Creates a dummy object for channels which aren't cached.
+            if(!channel)
+            {
+                auto Dummy = std::make_shared<CChannel>();
+                Dummy->ID = ChannelID;
+                Dummy->GuildID = GuildID;
+                Dummy->Type = (ChannelTypes)JChannel.GetValue<int>("type");
+                Dummy->Name = JChannel.GetValue<std::string>("name");
+                channel = Dummy;
+            }
+
+            Ret->ChannelMentions.push_back(channel);
+        }
+
+        return Ret;
+    }
+
+    User CDiscordClient::UpdateUser(const std::string &UserJson, uint32_t Seq)
+    {
+        User Parsed = Deserialize<User>(UserJson);
+
+        //The check and the replacement must be atomic, otherwise an older user could be set last.
+        std::lock_guard<std::mutex> lock(m_UserSeqLock);
+        uint32_t &Last = m_UserSeqs[Parsed->ID];
+
+        User Cached = m_Users.get(Parsed->ID);
+        if(!Cached)
+        {
+            Last = Seq;
+            return m_Users.insert(Parsed->ID, Parsed);
+        }
+
+        if(Seq < Last)
+            return Cached;
+
+        Last = Seq;
+        if(Cached->Username == Parsed->Username && Cached->Discriminator == Parsed->Discriminator && Cached->Avatar == Parsed->Avatar && Cached->PublicFlags == Parsed->PublicFlags)
+            return Cached;
+
+        //Events only contain the public fields of a user, the others are kept.
+        auto Copy = std::make_shared<CUser>(*Cached);
+        Copy->Username = Parsed->Username;
+        Copy->Discriminator = Parsed->Discriminator;
+        Copy->Avatar = Parsed->Avatar;
+        Copy->PublicFlags = Parsed->PublicFlags;
+
+        m_Users.set(Copy->ID, Copy);
+        return Copy;
+    }
+
+    Activity CDiscordClient::CreateActivity(CJSON &json)
+    {
+        auto ret = std::make_shared<CActivity>();
+
+        ret->Name = json.GetValue<std::string>("name");
+        ret->Type = (ActivityType)json.GetValue<int>("type");
+        ret->URL = json.GetValue<std::string>("url");
+        ret->CreatedAt = json.GetValue<int64_t>("created_at");
+
+        CJSON Timestamps;
+        Timestamps.ParseObject(json.GetValue<std::string>("timestamps"));
+        ret->StartTime = Timestamps.GetValue<int64_t>("start");
+        ret->EndTime = Timestamps.GetValue<int64_t>("end");
+
+        ret->AppID = json.GetValue<std::string>("application_id");
+        ret->Details = json.GetValue<std::string>("details");
+
+        ret->State = json.GetValue<std::string>("state");
+
+        if(!json.GetValue<std::string>("party").empty())
+        {
+            CJSON JParty;
+            JParty.ParseObject(json.GetValue<std::string>("party"));
+
+            auto party = std::make_shared<CParty>();
+            party->ID = JParty.GetValue<std::string>("id");
+            party->Size = JParty.GetValue<std::vector<int>>("size");
+            ret->PartyObject = party;
+        }
+
+        if(!json.GetValue<std::string>("secrets").empty())
+        {
+            CJSON JSecret;
+            JSecret.ParseObject(json.GetValue<std::string>("secrets"));
+
+            auto secret = std::make_shared<CSecrets>();
+            secret->Join = JSecret.GetValue<std::string>("join");
+            secret->Spectate = JSecret.GetValue<std::string>("spectate");
+            secret->Match = JSecret.GetValue<std::string>("match");
+            ret->Secret = secret;
+        }
+
+        ret->Instance = json.GetValue<bool>("instance");
+        ret->Flags = (ActivityFlags)json.GetValue<int>("flags");
+
+        return ret;
+    }
+
+    void CDiscordClient::SetCachePolicy(CacheEntity Entity, const SCachePolicy &Policy)
+    {
+        m_Cache.SetPolicy(Entity, Policy);
+
+        //The user cache keeps users alive by pinning them in the registry.
+        if(Entity == CacheEntity::USERS && Policy.Mode != CacheMode::NONE)
+            m_Users.set_pinning(true);
+
+        //Users are added by many events. The registry records the new users, which are checked by the next sweep.
+        if(Entity == CacheEntity::USERS)
+            m_Users.set_journaling(Policy.Mode == CacheMode::LRU);
+
+        if(Policy.Mode == CacheMode::NONE)
+            EvictAll(Entity);
+        else if(Policy.Mode == CacheMode::LRU)
+        {
+            //Starts the tracking of the already cached entries.
+            if(Entity == CacheEntity::USERS)
+                TrackUsers(nullptr);
+            else if(Entity == CacheEntity::PRESENCES)
+            {
+                auto IDs = m_Presences.GetUserIDs();
+                for (auto &&e : IDs)
+                {
+                    SPresence Presence;
+                    if(m_Presences.Get(e, Presence))
+                        m_Cache.Touch(Entity, SCacheKey(snowflake(), e), ApproxSize(Presence));
+                }
+            }
+
+            auto Guilds = m_Guilds.load();
+            for (auto &&g : *Guilds)
+            {
+                if(Entity == CacheEntity::CHANNELS)
+                {
+                    auto Channels = g.second->Channels.load();
+                    for (auto &&c : *Channels)
+                    {
+                        if(IsEvictableChannel(c.second))
+                            m_Cache.Touch(Entity, SCacheKey(g.first, c.first), ApproxSize(c.second));
+                    }
+                }
+                else if(Entity == CacheEntity::MEMBERS || Entity == CacheEntity::VOICE_STATES)
+                {
+                    auto Members = g.second->Members.load();
+                    for (auto &&m : *Members)
+                    {
+                        SCacheKey Key(g.first, m.first);
+                        if(Entity == CacheEntity::MEMBERS)
+                            m_Cache.Touch(Entity, Key, ApproxSize(m.second));
+                        else if(m.second->State)
+                            m_Cache.Touch(Entity, Key, ApproxSize(m.second->State));
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<GuildMember> CDiscordClient::FindMembers(Guild guild, const std::string &Prefix, size_t Limit)
     {
-        switch(Adler32(state.c_str()))
+        std::vector<GuildMember> Ret;
+        if(!guild)
+            return Ret;
+
+        auto IDs = m_MemberIndex.Find(guild->ID, Prefix, Limit);
+        Ret.reserve(IDs.size());
+
+        auto Members = guild->Members.load();
+        for (auto &&e : IDs)
         {
-            case Adler32("online"):
-            {
-                return OnlineState::ONLINE;
-            }break;
+            auto IT = Members->find(e);
+            if(IT != Members->end())
+                Ret.push_back(IT->second);
+        }
 
-            case Adler32("dnd"):
-            {
-                return OnlineState::DND;
-            }break;
+        return Ret;
+    }
 
-            case Adler32("idle"):
-            {
-                return OnlineState::IDLE;
-            }break;
+    bool CDiscordClient::SaveCacheSnapshot(const std::string &Path)
+    {
+        return CCacheSnapshot::Save(Path, *m_Guilds.load(), m_Users);
+    }
 
-            case Adler32("invisible"):
-            {
-                return OnlineState::INVISIBLE;
-            }break;
+    void CDiscordClient::LoadCacheSnapshot()
+    {
+        Guilds LoadedGuilds;
+        Users LoadedUsers;
+        if(!CCacheSnapshot::Load(m_SnapshotFile, LoadedGuilds, LoadedUsers))
+            return;
 
-            case Adler32("offline"):
-            {
-                return OnlineState::OFFLINE;
-            }break;
+        m_Users.insert(LoadedUsers.begin(), LoadedUsers.end(), false);
 
-            default:
+        m_Guilds.update([this, &LoadedGuilds](Guilds &guilds)
+        {
+            guilds.reserve(guilds.size() + LoadedGuilds.size());
+            for (auto &&e : LoadedGuilds)
             {
-                return OnlineState::OFFLINE;
-            }break;
-        }
+                guilds.insert(e);
+                m_SnapshotGuilds.push_back(e.first);
+            }
+        });
+
+        for (auto &&e : LoadedGuilds)
+            m_MemberIndex.Build(e.first, *e.second->Members.load());
+
+        //Applies the cache policies, which were set before Run().
+        const CacheEntity Entities[] = {CacheEntity::MEMBERS, CacheEntity::USERS, CacheEntity::CHANNELS};
+        for (auto &&e : Entities)
+            SetCachePolicy(e, m_Cache.GetPolicy(e));
+
+        llog << linfo << "Loaded " << LoadedGuilds.size() << " guilds and " << LoadedUsers.size() << " users from the cache snapshot " << m_SnapshotFile << lendl;
     }
 
-    GuildMember CDiscordClient::GetMember(Guild guild, const std::string &UserID)
+    SCacheStatistics CDiscordClient::GetCacheStatistics()
     {
-        auto UserIT = guild->Members->find(UserID);
-        GuildMember Ret;
+        SCacheStatistics Ret;
 
-        if(UserIT != guild->Members->end())
-            Ret = UserIT->second;
-        else
+        Ret.Users.Bytes = m_Users.memory_usage();
+        m_Users.for_each([&Ret](const Users::value_type &e)
         {
-            auto res = Get("/guilds/" + guild->ID + "/members/" + UserID);
-            if (res->statusCode != 200)
-                llog << lerror << "Failed to receive owner info HTTP: " << res->statusCode << " MSG: " << res->errorMsg << lendl;
-            else
-            {
-                try
-                {    
-                    CJSON JOwner;
-                    JOwner.ParseObject(res->body);
+            Ret.Users.Count++;
+            Ret.Users.Bytes += ApproxSize(e.second);
+            return true;
+        });
 
-                    Ret = CreateMember(JOwner, guild);
-                }
-                catch (const CJSONException &e)
+        Ret.Presences.Count = m_Presences.Size();
+        Ret.Presences.Bytes = m_Presences.MemoryUsage();
+
+        Ret.Messages.Count = m_Messages.Size();
+        Ret.Messages.Bytes = m_Messages.MemoryUsage();
+
+        Ret.MemberIndex.Bytes = m_MemberIndex.MemoryUsage();
+
+        auto Queues = m_MusicQueues.load();
+        Ret.MusicQueues.Count = Queues.size();
+        Ret.MusicQueues.Bytes = Queues.memory_usage();
+        for (auto &&e : Queues)
+            Ret.MusicQueues.Bytes += e.second->MemoryUsage();
+
+        auto Config = m_Controller ? m_Controller->GetCmdConfig() : CommandsConfig();
+        if(Config)
+        {
+            Ret.Config.Count = 1;
+            Ret.Config.Bytes = Config->MemoryUsage();
+        }
+
+        Ret.InternedStrings.Count = string_pool::instance().size();
+        Ret.InternedStrings.Bytes = string_pool::instance().memory_usage();
+
+        auto Guilds = m_Guilds.load();
+        Ret.Guilds.reserve(Guilds->size());
+        for (auto &&g : *Guilds)
+        {
+            SGuildCacheStatistics Stats;
+            Stats.GuildID = g.first;
+
+            auto Members = g.second->Members.load();
+            Stats.Members.Count = Members->size();
+            Stats.Members.Bytes = Members->memory_usage();
+            for (auto &&e : *Members)
+            {
+                Stats.Members.Bytes += ApproxSize(e.second);
+                if(e.second->State)
                 {
-                    llog << lerror << "Failed to parse owner JSON Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
-                    return nullptr;
+                    Stats.VoiceStates.Count++;
+                    Stats.VoiceStates.Bytes += ApproxSize(e.second->State);
                 }
             }
+
+            auto Channels = g.second->Channels.load();
+            Stats.Channels.Count = Channels->size();
+            Stats.Channels.Bytes = Channels->memory_usage();
+            for (auto &&e : *Channels)
+                Stats.Channels.Bytes += ApproxSize(e.second);
+
+            auto Roles = g.second->Roles.load();
+            Stats.Roles.Count = Roles->size();
+            Stats.Roles.Bytes = Roles->memory_usage();
+            for (auto &&e : *Roles)
+                Stats.Roles.Bytes += ApproxSize(e.second);
+
+            if(g.second->Arena)
+                Stats.Arena = g.second->Arena->statistics();
+
+            Ret.Guilds.push_back(Stats);
         }
 
+        std::sort(Ret.Guilds.begin(), Ret.Guilds.end(), [](const SGuildCacheStatistics &lhs, const SGuildCacheStatistics &rhs) {
+            return lhs.Bytes() > rhs.Bytes();
+        });
+
         return Ret;
     }
 
-    GuildMember CDiscordClient::CreateMember(CJSON &json, Guild guild)
+    void CDiscordClient::DumpCacheStatistics(size_t TopGuilds)
     {
-        GuildMember Ret = GuildMember(new CGuildMember());
-        std::string UserInfo = json.GetValue<std::string>("user");
-        User member;
+        auto Stats = GetCacheStatistics();
+
+        llog << linfo << "Cache usage: " << Stats.Bytes() << " bytes in " << Stats.Guilds.size() << " guilds" << lendl;
+        llog << linfo << "  Users: " << Stats.Users.Count << " entries, " << Stats.Users.Bytes << " bytes" << lendl;
+        llog << linfo << "  Presences: " << Stats.Presences.Count << " entries, " << Stats.Presences.Bytes << " bytes" << lendl;
+        llog << linfo << "  Messages: " << Stats.Messages.Count << " entries, " << Stats.Messages.Bytes << " bytes" << lendl;
+        llog << linfo << "  Member name index: " << Stats.MemberIndex.Bytes << " bytes" << lendl;
+        llog << linfo << "  Music queues: " << Stats.MusicQueues.Count << " entries, " << Stats.MusicQueues.Bytes << " bytes" << lendl;
+        llog << linfo << "  Config: " << Stats.Config.Bytes << " bytes" << lendl;
+        llog << linfo << "  Interned strings: " << Stats.InternedStrings.Count << " entries, " << Stats.InternedStrings.Bytes << " bytes" << lendl;
+
+        SGuildCacheStatistics Rest;
+        size_t RestGuilds = 0;
+        for (size_t i = 0; i < Stats.Guilds.size(); i++)
+        {
+            auto &e = Stats.Guilds[i];
+            if(i < TopGuilds)
+            {
+                llog << linfo << "  Guild " << e.GuildID.str() << ": " << e.Bytes() << " bytes, " 
+                     << e.Members.Count << " members (" << e.Members.Bytes << "), " 
+                     << e.Channels.Count << " channels (" << e.Channels.Bytes << "), " 
+                     << e.Roles.Count << " roles (" << e.Roles.Bytes << "), " 
+                     << e.VoiceStates.Count << " voice states (" << e.VoiceStates.Bytes << "), "
+                     << "arena " << e.Arena.used << " of " << e.Arena.reserved << " bytes in " << e.Arena.chunks << " chunks" << lendl;
+                continue;
+            }
 
-        //Gets the user which is associated with the member.
-        if (!UserInfo.empty())
-            member = m_Users | UserInfo;
+            RestGuilds++;
+            Rest.Members.Count += e.Members.Count;
+            Rest.Members.Bytes += e.Members.Bytes;
+            Rest.Channels.Count += e.Channels.Count;
+            Rest.Channels.Bytes += e.Channels.Bytes;
+            Rest.Roles.Count += e.Roles.Count;
+            Rest.Roles.Bytes += e.Roles.Bytes;
+            Rest.VoiceStates.Count += e.VoiceStates.Count;
+            Rest.VoiceStates.Bytes += e.VoiceStates.Bytes;
+            Rest.Arena.chunks += e.Arena.chunks;
+            Rest.Arena.reserved += e.Arena.reserved;
+            Rest.Arena.used += e.Arena.used;
+            Rest.Arena.allocations += e.Arena.allocations;
+        }
 
-        Ret->GuildID = guild->ID;
-        Ret->UserRef = member;
-        Ret->Nick = json.GetValue<std::string>("nick");
-        Ret->JoinedAt = json.GetValue<std::string>("joined_at");
-        Ret->PremiumSince = json.GetValue<std::string>("premium_since");
-        Ret->Deaf = json.GetValue<bool>("deaf");
-        Ret->Mute = json.GetValue<bool>("mute");
+        if(RestGuilds != 0)
+            llog << linfo << "  " << RestGuilds << " other guilds: " << Rest.Bytes() << " bytes, " << Rest.Members.Count << " members, " << Rest.Channels.Count << " channels, " << Rest.Roles.Count << " roles, " << Rest.VoiceStates.Count << " voice states, arena " << Rest.Arena.used << " of " << Rest.Arena.reserved << " bytes" << lendl;
+    }
 
-        //Adds the roles
-        auto Array = json.GetValue<std::vector<std::string>>("roles");
-        for (auto &&e : Array)
+    bool CDiscordClient::IsEvictableChannel(const Channel &channel)
+    {
+        return channel && (channel->Type == ChannelTypes::GUILD_TEXT || channel->Type == ChannelTypes::GUILD_NEWS || channel->Type == ChannelTypes::GUILD_STORE);
+    }
+
+    flat_map<snowflake, bool> CDiscordClient::GetMemberUserIDs()
+    {
+        flat_map<snowflake, bool> Ret;
+
+        auto Guilds = m_Guilds.load();
+        for (auto &&g : *Guilds)
         {
-            auto RIT = guild->Roles->find(e);
-            if(RIT != guild->Roles->end())
-                Ret->Roles->push_back(RIT->second);
-        }
+            auto Members = g.second->Members.load();
+            Ret.reserve(Ret.size() + Members->size());
 
-        if (Ret->UserRef)
-            guild->Members->insert({Ret->UserRef->ID, Ret});
+            for (auto &&m : *Members)
+                Ret.insert({m.first, true});
+        }
 
         return Ret;
     }
 
-    VoiceState CDiscordClient::CreateVoiceState(CJSON &json, Guild guild)
+    void CDiscordClient::RemoveOrphanUsers(const std::vector<snowflake> *Candidates)
     {
-        VoiceState Ret = VoiceState(new CVoiceState());
+        //Without pins the users are released with their last member and the sweep removes their entries.
+        if(!m_Users.pinning())
+            return;
 
-        if (!guild)
+        snowflake BotID = m_BotUser ? m_BotUser->ID : snowflake();
+        auto Guilds = m_Guilds.load();
+
+        std::vector<snowflake> IDs;
+        if(Candidates)
         {
-            Guilds::iterator IT = m_Guilds->find(json.GetValue<std::string>("guild_id"));
-            if (IT != m_Guilds->end())
-                Ret->GuildRef = IT->second;
+            IDs = *Candidates;
+            std::sort(IDs.begin(), IDs.end());
+            IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
         }
-        else
-            Ret->GuildRef = guild;
 
-        auto IT = m_Users->find(json.GetValue<std::string>("user_id"));
-        if (IT != m_Users->end())
-            Ret->UserRef = IT->second;
+        //Looks the candidates up in every guild, unless one set of all member users is cheaper. @see TrackUsers
+        size_t Members = 0;
+        for (auto &&g : *Guilds)
+            Members += g.second->Members.size();
 
-        if (Ret->GuildRef)
+        bool All = !Candidates || IDs.size() * Guilds->size() > Members;
+        flat_map<snowflake, bool> Referenced;
+        if(All)
+            Referenced = GetMemberUserIDs();
+
+        auto IsOrphan = [&Guilds, &Referenced, All, BotID](snowflake ID)
         {
-            auto CIT = Ret->GuildRef->Channels->find(json.GetValue<std::string>("channel_id"));
-            if (CIT != Ret->GuildRef->Channels->end())
-                Ret->ChannelRef = CIT->second;
+            if(ID == BotID)
+                return false;
 
-            GuildMember Member;
+            if(All)
+                return Referenced.count(ID) == 0;
 
-            //Adds this voice state to the guild member.
-            auto MIT = Ret->GuildRef->Members->find(json.GetValue<std::string>("user_id"));
-            if (MIT != Ret->GuildRef->Members->end())
-                Member = MIT->second;
-            else
+            for (auto &&g : *Guilds)
             {
-                //Creates a new member.
-                try
-                {
-                    CJSON JMember;
-                    JMember.ParseObject(json.GetValue<std::string>("member"));
-
-                    Member = CreateMember(JMember, Ret->GuildRef);
-                }
-                catch (const CJSONException &e)
-                {
-                    llog << lerror << "Failed to parse JSON for VoiceState member Enumtype: " << GetEnumName(e.GetErrType()) << " what(): " << e.what() << lendl;
-                    return Ret;
-                }
+                if(g.second->Members.contains(ID))
+                    return false;
             }
 
-            //Removes the voice state if the user isn't in a voice channel.
-            if (!Ret->ChannelRef && Member)
+            return true;
+        };
+
+        std::vector<snowflake> Orphans;
+        if(Candidates)
+        {
+            for (auto &&e : IDs)
             {
-                Member->State = nullptr;
-                return Ret;
+                if(IsOrphan(e))
+                    Orphans.push_back(e);
             }
-            else if(Member)
-                Member->State = Ret;
         }
+        else
+        {
+            m_Users.for_each([&Orphans, &IsOrphan](const Users::value_type &e)
+            {
+                if(IsOrphan(e.first))
+                    Orphans.push_back(e.first);
 
-        Ret->SessionID = json.GetValue<std::string>("session_id");
-        Ret->Deaf = json.GetValue<bool>("deaf");
-        Ret->Mute = json.GetValue<bool>("mute");
-        Ret->SelfDeaf = json.GetValue<bool>("self_deaf");
-        Ret->SelfMute = json.GetValue<bool>("self_mute");
-        Ret->SelfStream = json.GetValue<bool>("self_stream");
-        Ret->Supress = json.GetValue<bool>("suppress");
+                return true;
+            });
+        }
 
-        return Ret;
+        if(Orphans.empty())
+            return;
+
+        m_Users.unpin(Orphans.begin(), Orphans.end());
+
+        for (auto &&e : Orphans)
+        {
+            SCacheKey Key(snowflake(), e);
+            m_Cache.Remove(CacheEntity::USERS, Key);
+            m_Cache.Remove(CacheEntity::PRESENCES, Key);
+            m_Presences.Erase(e);
+        }
     }
 
-    Message CDiscordClient::CreateMessage(CJSON &json)
+    void CDiscordClient::Evict(CacheEntity Entity, const std::vector<SCacheKey> &Keys)
     {
-        Message Ret = Message(new CMessage());
-        Channel channel;
+        if(Keys.empty())
+            return;
 
-        Guilds::iterator IT = m_Guilds->find(json.GetValue<std::string>("guild_id"));
-        if (IT != m_Guilds->end())
+        if(Entity == CacheEntity::USERS)
         {
-            Ret->GuildRef = IT->second;
-            std::map<std::string, Channel>::iterator CIT = Ret->GuildRef->Channels->find(json.GetValue<std::string>("channel_id"));
-            if (CIT != Ret->GuildRef->Channels->end())
-                channel = CIT->second;
-        }
+            std::vector<snowflake> Candidates;
+            Candidates.reserve(Keys.size());
+            for (auto &&e : Keys)
+                Candidates.push_back(e.ID);
 
-        //Creates a dummy object for DMs.
-        if (!channel)
+            RemoveOrphanUsers(&Candidates);
+            return;
+        }
+        else if(Entity == CacheEntity::PRESENCES)
         {
-            channel = Channel(new CChannel());
-            channel->ID = json.GetValue<std::string>("channel_id");
-            channel->Type = ChannelTypes::DM;
+            snowflake BotID = m_BotUser ? m_BotUser->ID : snowflake();
+            for (auto &&e : Keys)
+            {
+                if(e.ID != BotID)
+                    m_Presences.Erase(e.ID);
+            }
+
+            return;
         }
 
-        Ret->ID = json.GetValue<std::string>("id");
-        Ret->ChannelRef = channel;
+        snowflake BotID = m_BotUser ? m_BotUser->ID : snowflake();
 
-        std::string UserJson = json.GetValue<std::string>("author");
-        if (!UserJson.empty())
+        //Groups the keys by guild, so each map is copied once.
+        flat_map<snowflake, std::vector<snowflake>> ByGuild;
+        for (auto &&e : Keys)
         {
-            User user = m_Users | UserJson;
-            Ret->Author = user;
+            if(e.ID != BotID || Entity == CacheEntity::CHANNELS)
+                ByGuild[e.Guild].push_back(e.ID);
+        }
 
-            //Gets the guild member, if this message is not a dm.
-            if (Ret->GuildRef)
+        for (auto &&e : ByGuild)
+        {
+            for (auto &&ID : e.second)
             {
-                auto MIT = Ret->GuildRef->Members->find(Ret->Author->ID);
-                if (MIT != Ret->GuildRef->Members->end())
-                    Ret->Member = MIT->second;
-                else
-                    Ret->Member = GetMember(Ret->GuildRef, Ret->Author->ID);
+                if(Entity == CacheEntity::MEMBERS)
+                    m_Permissions.InvalidateMember(e.first, ID);
+                else if(Entity == CacheEntity::CHANNELS)
+                    m_Permissions.InvalidateChannel(e.first, ID);
             }
-        }
-
-        Ret->Content = json.GetValue<std::string>("content");
-        Ret->Timestamp = json.GetValue<std::string>("timestamp");
-        Ret->EditedTimestamp = json.GetValue<std::string>("edited_timestamp");
-        Ret->Mention = json.GetValue<bool>("mention_everyone");
 
-        std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("mentions");
-        for (auto &&e : Array)
-        {
-            User user = m_Users | e;
-            bool Found = false;
+            Guild guild = m_Guilds.get(e.first);
+            if(!guild)
+                continue;
 
-            if (Ret->GuildRef)
+            const std::vector<snowflake> &IDs = e.second;
+            switch (Entity)
             {
-                auto MIT = Ret->GuildRef->Members->find(Ret->Author->ID);
-                if (MIT != Ret->GuildRef->Members->end())
+                case CacheEntity::MEMBERS:
                 {
-                    Found = true;
-                    Ret->Mentions.push_back(MIT->second);
-                }
+                    std::vector<GuildMember> Removed;
+                    guild->Members.update([&IDs, &Removed](persistent_map<snowflake, GuildMember> &Members)
+                    {
+                        for (auto &&id : IDs)
+                        {
+                            auto IT = Members.find(id);
+                            if(IT == Members.end())
+                                continue;
+
+                            Removed.push_back(IT->second);
+                            Members.erase(IT);
+                        }
+                    });
+
+                    for (auto &&m : Removed)
+                        m_MemberIndex.Remove(m);
+                }break;
+
+                case CacheEntity::VOICE_STATES:
+                {
+                    guild->Members.update([&IDs, &guild](persistent_map<snowflake, GuildMember> &Members)
+                    {
+                        for (auto &&id : IDs)
+                        {
+                            auto IT = Members.find(id);
+                            if(IT == Members.end() || !IT->second->State)
+                                continue;
+
+                            auto member = arena_make_shared<CGuildMember>(guild->Arena, *IT->second);
+                            member->State = nullptr;
+                            IT->second = member;
+                        }
+                    });
+                }break;
+
+                case CacheEntity::CHANNELS:
+                {
+                    guild->Channels.update([&IDs](persistent_map<snowflake, Channel> &Channels)
+                    {
+                        for (auto &&id : IDs)
+                        {
+                            auto IT = Channels.find(id);
+                            if(IT != Channels.end() && IsEvictableChannel(IT->second))
+                                Channels.erase(id);
+                        }
+                    });
+                }break;
+
+                default:
+                    break;
             }
+        }
+    }
 
-            //Create a fake Guildmember for DMs.
-            if (!Found)
+    void CDiscordClient::EvictAll(CacheEntity Entity)
+    {
+        if(Entity == CacheEntity::USERS)
+        {
+            m_Users.set_pinning(false);
+            return;
+        }
+        else if(Entity == CacheEntity::PRESENCES)
+        {
+            std::vector<SCacheKey> Keys;
+            for (auto &&e : m_Presences.GetUserIDs())
+                Keys.push_back(SCacheKey(snowflake(), e));
+
+            Evict(Entity, Keys);
+            return;
+        }
+
+        std::vector<SCacheKey> Keys;
+        auto Guilds = m_Guilds.load();
+        for (auto &&g : *Guilds)
+        {
+            if(Entity == CacheEntity::CHANNELS)
+            {
+                auto Channels = g.second->Channels.load();
+                for (auto &&c : *Channels)
+                    Keys.push_back(SCacheKey(g.first, c.first));
+            }
+            else
             {
-                Ret->Mentions.push_back(GuildMember(new CGuildMember()));
-                Ret->Mentions.back()->UserRef = user;
+                auto Members = g.second->Members.load();
+                for (auto &&m : *Members)
+                    Keys.push_back(SCacheKey(g.first, m.first));
             }
         }
 
-        return Ret;
+        Evict(Entity, Keys);
     }
 
-    Activity CDiscordClient::CreateActivity(CJSON &json)
+    void CDiscordClient::TrackUsers(const std::vector<snowflake> *Candidates)
     {
-        Activity ret = Activity(new CActivity());
+        snowflake BotID = m_BotUser ? m_BotUser->ID : snowflake();
+        auto Guilds = m_Guilds.load();
 
-        ret->Name = json.GetValue<std::string>("name");
-        ret->Type = (ActivityType)json.GetValue<int>("type");
-        ret->URL = json.GetValue<std::string>("url");
-        ret->CreatedAt = json.GetValue<int>("created_at");
+        std::vector<snowflake> IDs;
+        if(Candidates)
+        {
+            IDs = *Candidates;
+            std::sort(IDs.begin(), IDs.end());
+            IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
+        }
 
-        CJSON Timestamps;
-        Timestamps.ParseObject(json.GetValue<std::string>("timestamps"));
-        ret->StartTime = Timestamps.GetValue<int>("start");
-        ret->EndTime = Timestamps.GetValue<int>("end");
+        //Looks the candidates up in every guild, unless one set of all member users is cheaper.
+        size_t Members = 0;
+        for (auto &&g : *Guilds)
+            Members += g.second->Members.size();
 
-        ret->AppID = json.GetValue<std::string>("application_id");
-        ret->Details = json.GetValue<std::string>("details");
+        bool All = !Candidates || IDs.size() * Guilds->size() > Members;
+        flat_map<snowflake, bool> Referenced;
+        if(All)
+            Referenced = GetMemberUserIDs();
 
-        ret->State = json.GetValue<std::string>("state");
+        auto Track = [this, &Guilds, &Referenced, All, BotID](snowflake ID, const User &Usr)
+        {
+            bool IsReferenced = ID == BotID || (All && Referenced.count(ID) != 0);
+            for (auto IT = Guilds->begin(); !All && !IsReferenced && IT != Guilds->end(); ++IT)
+                IsReferenced = IT->second->Members.contains(ID);
 
-        if(!json.GetValue<std::string>("party").empty())
+            SCacheKey Key(snowflake(), ID);
+            if(IsReferenced)
+                m_Cache.Remove(CacheEntity::USERS, Key);
+            else
+                m_Cache.Track(CacheEntity::USERS, Key, ApproxSize(Usr));
+        };
+
+        if(Candidates)
         {
-            CJSON JParty;
-            JParty.ParseObject(json.GetValue<std::string>("party"));
+            for (auto &&e : IDs)
+            {
+                User Usr = m_Users.get(e);
+                if(Usr)
+                    Track(e, Usr);
+            }
+        }
+        else
+        {
+            m_Users.for_each([&Track](const Users::value_type &e)
+            {
+                Track(e.first, e.second);
+                return true;
+            });
+        }
+    }
+
+    void CDiscordClient::SweepCaches()
+    {
+        int64_t Now = GetTimeMillis();
 
-            ret->PartyObject = Party(new CParty());
-            ret->PartyObject->ID = JParty.GetValue<std::string>("id");
-            ret->PartyObject->Size = JParty.GetValue<std::vector<int>>("size");
+        //Removes the registry entries of released users in small steps and drops their presences.
+        std::vector<snowflake> Reclaimed;
+        m_Users.sweep(std::chrono::microseconds(USER_SWEEP_BUDGET), USER_SWEEP_STEP, &Reclaimed);
+        for (auto &&e : Reclaimed)
+        {
+            SCacheKey Key(snowflake(), e);
+            m_Cache.Remove(CacheEntity::USERS, Key);
+            m_Cache.Remove(CacheEntity::PRESENCES, Key);
+            m_Presences.Erase(e);
         }
 
-        if(!json.GetValue<std::string>("secrets").empty())
+        if(!Reclaimed.empty())
         {
-            CJSON JSecret;
-            JSecret.ParseObject(json.GetValue<std::string>("secrets"));
+            std::lock_guard<std::mutex> lock(m_UserSeqLock);
+            for (auto &&e : Reclaimed)
+                m_UserSeqs.erase(e);
+        }
 
-            ret->Secret = Secrets(new CSecrets());
-            ret->Secret->Join = JSecret.GetValue<std::string>("join");
-            ret->Secret->Spectate = JSecret.GetValue<std::string>("spectate");
-            ret->Secret->Match = JSecret.GetValue<std::string>("match");
+        //Only the users which were added since the last sweep are checked.
+        if(m_Cache.GetPolicy(CacheEntity::USERS).Mode == CacheMode::LRU)
+        {
+            auto Added = m_Users.take_added();
+            if(!Added.empty())
+                TrackUsers(&Added);
         }
 
-        ret->Instance = json.GetValue<bool>("instance");
-        ret->Flags = (ActivityFlags)json.GetValue<int>("flags");
+        const CacheEntity Entities[] = {CacheEntity::MEMBERS, CacheEntity::USERS, CacheEntity::PRESENCES, CacheEntity::VOICE_STATES, CacheEntity::CHANNELS};
+        for (auto &&e : Entities)
+            Evict(e, m_Cache.Sweep(e, Now));
+    }
 
-        return ret;
+    void CDiscordClient::CacheSweeper()
+    {
+        while (!m_Quit)
+        {
+            int64_t Beg = GetTimeMillis();
+            SweepCaches();
+
+            while (((GetTimeMillis() - Beg) < CACHE_SWEEP_INTERVAL) && !m_Quit)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
 } // namespace DiscordBot
@@ -34,6 +34,7 @@
 #include <ixwebsocket/IXHttpClient.h>
 #include <thread>
 #include <map>
+#include <models/flat_map.hpp>
 #include <models/User.hpp>
 #include <models/Guild.hpp>
 #include <models/Role.hpp>
@@ -43,8 +44,18 @@
 #include "../models/Payload.hpp"
 #include "VoiceSocket.hpp"
 #include <models/atomic.hpp>
+#include <models/snapshot_map.hpp>
 #include "GuildAdmin.hpp"
 #include "../helpers/JSONHelpers.hpp"
+#include "RESTClient.hpp"
+#include "MultipartBody.hpp"
+#include "RESTCache.hpp"
+#include "CacheTracker.hpp"
+#include "PresenceStore.hpp"
+#include "EventDispatcher.hpp"
+#include "PermissionEngine.hpp"
+#include "MessageCache.hpp"
+#include "MemberIndex.hpp"
 
 #undef SendMessage
 
@@ -253,6 +264,21 @@ namespace DiscordBot
              */
             void SendMessage(User user, const std::string Text, Embed embed = nullptr, bool TTS = false) override;
 
+            /**
+             * @brief Sends files with an optional message to a given channel.
+             */
+            void SendFiles(Channel channel, const std::vector<std::string> &Files, const std::string Text = "", Embed embed = nullptr) override;
+
+            /**
+             * @brief Gets the webhook of the bot for a text channel.
+             */
+            Webhook GetWebhook(Channel channel, const std::string &Name = "libDiscordBot") override;
+
+            /**
+             * @brief Sends a message through a webhook.
+             */
+            void ExecuteWebhook(Webhook webhook, const std::string &Text, Embed embed = nullptr, const std::string &Username = "", const std::string &AvatarURL = "", bool TTS = false) override;
+
             /**
              * @return Returns the audio source for the given guild. Null if there is no audio source available.
              */
@@ -296,15 +322,25 @@ namespace DiscordBot
              */
             GuildMember GetBotMember(Guild guild) override
             {
-                GuildMember ret;
-                if(guild)
-                {
-                    auto IT = guild->Members->find(m_BotUser->ID);
-                    if(IT != guild->Members->end())
-                        ret = IT->second;
-                }
+                if(!guild)
+                    return nullptr;
+
+                return guild->Members.get(m_BotUser->ID);
+            }
+
+            /**
+             * @return Gets a member from the cache or from discord.
+             */
+            GuildMember GetMember(Guild guild, snowflake UserID) override;
 
-                return ret;
+            /**
+             * @return Gets the presence of a user.
+             */
+            SPresence GetPresence(snowflake UserID) override
+            {
+                SPresence Ret;
+                m_Presences.Get(UserID, Ret);
+                return Ret;
             }
 
             /**
@@ -315,21 +351,50 @@ namespace DiscordBot
                 return m_Guilds;
             }
 
+            GuildsSnapshot GetGuildsSnapshot() override
+            {
+                return m_Guilds.load();
+            }
+
+            void ForEachGuild(const GuildVisitor &Visitor) override
+            {
+                auto Snapshot = m_Guilds.load();
+                for (auto &&e : *Snapshot)
+                {
+                    if(!Visitor(e.second))
+                        break;
+                }
+            }
+
+            void ForEachMember(Guild guild, const MemberVisitor &Visitor) override
+            {
+                if(!guild)
+                    return;
+
+                auto Snapshot = guild->Members.load();
+                for (auto &&e : *Snapshot)
+                {
+                    if(!Visitor(e.second))
+                        break;
+                }
+            }
+
+            size_t CountMembers(Guild guild) override
+            {
+                return guild ? guild->Members.size() : 0;
+            }
+
             /**
              * @return Gets a guild object by its id or null.
              */
-            Guild GetGuild(const std::string &GID) override
+            Guild GetGuild(snowflake GID) override
             {
-                auto IT = m_Guilds->find(GID);
-                if(IT != m_Guilds->end())
-                    return IT->second;
-
-                return nullptr;
+                return m_Guilds.get(GID);
             }
 
             GuildAdmin GetAdminInterface(Guild g) override
             {
-                if(!g || g->ID == "")
+                if(!g || g->ID.load().empty())
                     return nullptr;
 
                 auto IT = m_Admins->find(g->ID);
@@ -352,20 +417,125 @@ namespace DiscordBot
                 return m_Users;
             }
 
+            UsersSnapshot GetUsersSnapshot() override
+            {
+                return std::make_shared<const weak_registry<snowflake, const CUser>::snapshot>(m_Users.load());
+            }
+
+            void ForEachUser(const UserVisitor &Visitor) override
+            {
+                m_Users.for_each([&Visitor](const Users::value_type &e)
+                {
+                    return Visitor(e.second);
+                });
+            }
+
+            /**
+             * @brief Sets the retry policy for all REST requests.
+             */
+            void SetRetryPolicy(const SRetryPolicy &Policy) override
+            {
+                m_REST->SetRetryPolicy(Policy);
+                m_WebhookREST->SetRetryPolicy(Policy);
+            }
+
+            /**
+             * @brief Changes the url of the discord REST api.
+             */
+            void SetBaseURL(const std::string &URL) override
+            {
+                m_REST->SetBaseURL(URL);
+            }
+
+            /**
+             * @brief Sets the time to live of cached GET responses of a route.
+             */
+            void SetRESTCacheTTL(const std::string &Route, uint32_t TTL) override
+            {
+                m_RESTCache.SetTTL(Route, TTL);
+            }
+
+            /**
+             * @return Gets the latency statistics of the REST requests per priority class.
+             */
+            SRESTStatistics GetRESTStatistics() override
+            {
+                return m_REST->GetStatistics();
+            }
+
+            /**
+             * @brief Sets how long an entity is cached.
+             */
+            void SetCachePolicy(CacheEntity Entity, const SCachePolicy &Policy) override;
+
+            SCachePolicy GetCachePolicy(CacheEntity Entity) override
+            {
+                return m_Cache.GetPolicy(Entity);
+            }
+
+            SCacheStatistics GetCacheStatistics() override;
+            void DumpCacheStatistics(size_t TopGuilds) override;
+
+            void SetCacheSnapshotFile(const std::string &Path) override
+            {
+                m_SnapshotFile = Path;
+            }
+
+            bool SaveCacheSnapshot(const std::string &Path) override;
+
+            void SetEventWorkers(size_t Count) override
+            {
+                m_EventWorkers = Count;
+            }
+
+            Permission GetPermissions(Guild guild, GuildMember member, Channel channel = nullptr) override
+            {
+                return m_Permissions.Get(guild, member, channel);
+            }
+
+            bool HasPermission(Guild guild, GuildMember member, Permission perm, Channel channel = nullptr) override
+            {
+                return (m_Permissions.Get(guild, member, channel) & perm) == perm;
+            }
+
+            void SetMessageCache(size_t Depth, size_t MaxBytes = 0) override
+            {
+                m_Messages.SetLimits(Depth, MaxBytes);
+            }
+
+            Message GetCachedMessage(snowflake ChannelID, snowflake MessageID) override
+            {
+                return m_Messages.Get(ChannelID, MessageID);
+            }
+
+            std::vector<Message> GetCachedMessages(snowflake ChannelID) override
+            {
+                return m_Messages.GetMessages(ChannelID);
+            }
+
+            std::vector<GuildMember> FindMembers(Guild guild, const std::string &Prefix, size_t Limit = 10) override;
+
             ~CDiscordClient() {}
 
 
-            ix::HttpResponsePtr Get(const std::string &URL);
-            ix::HttpResponsePtr Post(const std::string &URL, const std::string &Body);
-            ix::HttpResponsePtr Put(const std::string &URL, const std::string &Body);
-            ix::HttpResponsePtr Patch(const std::string &URL, const std::string &Body);
-            ix::HttpResponsePtr Delete(const std::string &URL, const std::string &Body = "");
+            ix::HttpResponsePtr Get(const std::string &URL, RequestPriority Priority = RequestPriority::NORMAL);
+            ix::HttpResponsePtr Post(const std::string &URL, const std::string &Body, RequestPriority Priority = RequestPriority::NORMAL);
+            ix::HttpResponsePtr Put(const std::string &URL, const std::string &Body, RequestPriority Priority = RequestPriority::NORMAL);
+            ix::HttpResponsePtr Patch(const std::string &URL, const std::string &Body, RequestPriority Priority = RequestPriority::NORMAL);
+            ix::HttpResponsePtr Delete(const std::string &URL, const std::string &Body = "", RequestPriority Priority = RequestPriority::NORMAL);
 
-            GuildMember GetMember(Guild guild, const std::string &UserID);
             User GetUserOrAdd(const std::string &js)
             {
                 return m_Users | js;
             }
+
+            /**
+             * @return Returns the cached user with the id of the given user. The user is added, if the id has no living user.
+             */
+            User GetUserOrAdd(const User &user)
+            {
+                return m_Users.insert(user->ID, user);
+            }
         private:
             enum
             {
@@ -376,12 +546,16 @@ namespace DiscordBot
             };
 
             const char *BASE_URL = "https://discord.com/api";
-            std::string USER_AGENT;
+            static const size_t MAX_FILES = 10;  //!< Maximum attachments per message.
+            static const int64_t USER_SWEEP_BUDGET = 2000;  //!< Microseconds per sweep to remove the registry entries of released users.
+            static const size_t USER_SWEEP_STEP = 1024;  //!< Registry entries which are checked per sweep step.
+            static const int64_t CACHE_SWEEP_INTERVAL = 10000;  //!< Milliseconds between two cache sweeps.
 
-            using VoiceSockets = std::map<std::string, VoiceSocket>;
-            using AudioSources = std::map<std::string, AudioSource>;
-            using MusicQueues = std::map<std::string, MusicQueue>;
-            using AdminInterfaces = std::map<std::string, GuildAdmin>;
+            using VoiceSockets = flat_map<snowflake, VoiceSocket>;
+            using AudioSources = flat_map<snowflake, AudioSource>;
+            using MusicQueues = flat_map<snowflake, MusicQueue>;
+            using AdminInterfaces = flat_map<snowflake, GuildAdmin>;
+            using Webhooks = std::map<std::pair<snowflake, std::string>, Webhook>;   //!< (Channel, name) -> Webhook
 
             CMessageManager m_EVManger;
             Intent m_Intents;
@@ -389,9 +563,16 @@ namespace DiscordBot
             std::string m_Token;
             std::shared_ptr<SGateway> m_Gateway;
             ix::WebSocket m_Socket;
-            ix::HttpClient m_HTTPClient;
+            std::shared_ptr<CRESTClient> m_REST;
+
+            //Webhooks don't need the bot token and have their own rate limits.
+            std::shared_ptr<CRESTClient> m_WebhookREST;
+
+            //GET responses, invalidated by gateway events.
+            CRESTCache m_RESTCache;
 
             std::thread m_Heartbeat;
+            std::thread m_Sweeper;
             std::atomic<bool> m_Terminate;
             std::atomic<bool> m_HeartACKReceived;
             std::atomic<bool> m_Quit;
@@ -401,16 +582,50 @@ namespace DiscordBot
             User m_BotUser;
 
             // Unavailable guild IDs.
-            std::vector<std::string> m_Unavailables;
+            std::vector<snowflake> m_Unavailables;
+
+            std::string m_SnapshotFile;
+
+            // Guilds of the cache snapshot, which didn't receive their GUILD_CREATE yet.
+            std::vector<snowflake> m_SnapshotGuilds;
+
+            // Guards m_Unavailables and m_SnapshotGuilds, the guild events of different guilds can run in parallel.
+            std::mutex m_GuildListLock;
+
+            size_t m_EventWorkers;
+            CEventDispatcher m_Dispatcher;
+
+            //Registry of all users in different servers. Holds weak references, the users are owned by the members, the application or the pins of the user cache policy. Sharded, so member events of different guilds don't copy and lock the same map.
+            weak_registry<snowflake, const CUser> m_Users;
+
+            //Gateway sequence of the last user update per user. Guards the replacement of users, the member events of different guilds run in parallel.
+            flat_map<snowflake, uint32_t> m_UserSeqs;
+            std::mutex m_UserSeqLock;
 
-            //Map of all users in different servers.
-            atomic<Users> m_Users;
+            //Cache policies and the access order of the LRU cached entities.
+            CCacheTracker m_Cache;
+
+            //Online states and activities of the users.
+            CPresenceStore m_Presences;
+
+            //Effective permissions per guild, member and channel.
+            CPermissionEngine m_Permissions;
+
+            //Recent messages per channel, disabled by default.
+            CMessageCache m_Messages;
+
+            //Lower case member names per guild for FindMembers.
+            CMemberIndex m_MemberIndex;
 
             //All Guilds where the bot is in.
-            atomic<Guilds> m_Guilds;
+            snapshot_map<snowflake, Guild> m_Guilds;
 
             atomic<AdminInterfaces> m_Admins;
 
+            //Webhooks of the bot per channel and name.
+            atomic<Webhooks> m_Webhooks;
+            std::mutex m_WebhookLock;
+
             //All open voice connections.
             atomic<VoiceSockets> m_VoiceSockets;
 
@@ -436,7 +651,7 @@ namespace DiscordBot
             /**
              * @brief Joins or leaves a voice channel.
              */
-            void ChangeVoiceState(const std::string &Guild, const std::string &Channel = "");
+            void ChangeVoiceState(snowflake Guild, snowflake Channel = snowflake());
 
             /**
              * @brief Handles async. Messages.
@@ -448,6 +663,16 @@ namespace DiscordBot
              */
             void OnWebsocketEvent(const ix::WebSocketMessagePtr& msg);
 
+            /**
+             * @brief Handles a gateway event. Called from the socket thread or from the worker of the guild. @see SetEventWorkers
+             */
+            void OnDispatch(const SPayload &Pay);
+
+            /**
+             * @return Gets the guild id of an event or an empty id for events without a guild.
+             */
+            snowflake GetDispatchKey(size_t Event, const std::string &Data);
+
             /**
              * @brief Sends a heartbeat.
              */
@@ -471,17 +696,79 @@ namespace DiscordBot
             /**
              * @brief Called from voice socket if a audio source finished.
              */
-            void OnSpeakFinish(const std::string &Guild);
+            void OnSpeakFinish(snowflake Guild);
 
-            void OnQueueWaitFinish(const std::string &Guild, AudioSource Source);
+            void OnQueueWaitFinish(snowflake Guild, AudioSource Source);
 
             std::string OnlineStateToStr(OnlineState state);
             OnlineState StrToOnlineState(const std::string &state);
 
-            GuildMember CreateMember(CJSON &json, Guild guild);
+            /**
+             * @param Batch: If set, the member is added to this map instead of the guild. Use this to publish many members with one copy of the member map.
+             */
+            GuildMember CreateMember(CJSON &json, Guild guild, persistent_map<snowflake, GuildMember> *Batch = nullptr);
             VoiceState CreateVoiceState(CJSON &json, Guild guild);
             Message CreateMessage(CJSON &json);
             Activity CreateActivity(CJSON &json);
+
+            /**
+             * @brief Applies the user object of an event to the user registry. Users are immutable, so a changed user is replaced by a copy.
+             * 
+             * @param Seq: Gateway sequence of the event. The user isn't replaced, if a newer event of another guild was applied first.
+             * 
+             * @return Returns the user of the registry.
+             */
+            User UpdateUser(const std::string &UserJson, uint32_t Seq);
+
+            /**
+             * @return Returns true if the channel type can be evicted. Voice channels and categories are always cached.
+             */
+            static bool IsEvictableChannel(const Channel &channel);
+
+            /**
+             * @return Returns the ids of all users which are referenced by a cached member.
+             */
+            flat_map<snowflake, bool> GetMemberUserIDs();
+
+            /**
+             * @brief Unpins all users, which aren't referenced by a cached member, and removes their presences. The users are released, if the application doesn't reference them.
+             * Does nothing if the users aren't pinned, then the sweep removes the released users.
+             * 
+             * @param Candidates: Only these users are checked. Null to check all users.
+             */
+            void RemoveOrphanUsers(const std::vector<snowflake> *Candidates);
+
+            /**
+             * @brief Removes the given entries from the caches.
+             */
+            void Evict(CacheEntity Entity, const std::vector<SCacheKey> &Keys);
+
+            /**
+             * @brief Removes all entries of an entity, which aren't needed by the bot itself.
+             */
+            void EvictAll(CacheEntity Entity);
+
+            /**
+             * @brief Starts the tracking of users, which aren't referenced by a cached member, and stops the tracking of referenced users.
+             * 
+             * @param Candidates: Only these users are checked. Null to check all users.
+             */
+            void TrackUsers(const std::vector<snowflake> *Candidates);
+
+            /**
+             * @brief Evicts the expired entries of all LRU caches. Called by the sweeper thread every CACHE_SWEEP_INTERVAL milliseconds.
+             */
+            void SweepCaches();
+
+            /**
+             * @brief Thread of the cache sweeps, so a long sweep doesn't delay the heartbeats. Runs until the bot quits.
+             */
+            void CacheSweeper();
+
+            /**
+             * @brief Loads the cache snapshot file into the empty caches.
+             */
+            void LoadCacheSnapshot();
     };
 } // namespace DiscordBot
 
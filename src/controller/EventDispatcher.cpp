@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "EventDispatcher.hpp"
+#include <exception>
+#include <Log.hpp>
+
+namespace DiscordBot
+{
+    void CEventDispatcher::Start(size_t Workers, Handler Callback)
+    {
+        if(IsRunning() || Workers == 0)
+            return;
+
+        m_Callback = Callback;
+        m_Workers.reserve(Workers);
+        for (size_t i = 0; i < Workers; i++)
+        {
+            m_Workers.emplace_back(new SWorker());
+            m_Workers.back()->Thread = std::thread(&CEventDispatcher::Run, this, m_Workers.back().get());
+        }
+    }
+
+    void CEventDispatcher::Stop()
+    {
+        for (auto &&e : m_Workers)
+        {
+            std::lock_guard<std::mutex> lock(e->Lock);
+            e->Stop = true;
+            e->Signal.notify_one();
+        }
+
+        for (auto &&e : m_Workers)
+        {
+            if(e->Thread.joinable())
+                e->Thread.join();
+        }
+
+        m_Workers.clear();
+    }
+
+    void CEventDispatcher::Post(snowflake Key, SPayload Pay)
+    {
+        SWorker *Worker = m_Workers[std::hash<snowflake>()(Key) % m_Workers.size()].get();
+
+        std::lock_guard<std::mutex> lock(Worker->Lock);
+        Worker->Queue.push_back(std::move(Pay));
+        Worker->Signal.notify_one();
+    }
+
+    void CEventDispatcher::Wait()
+    {
+        for (auto &&e : m_Workers)
+        {
+            SWorker *Worker = e.get();
+            std::unique_lock<std::mutex> lock(Worker->Lock);
+            Worker->Idle.wait(lock, [Worker]() { return Worker->Queue.empty() && !Worker->Busy; });
+        }
+    }
+
+    void CEventDispatcher::Run(SWorker *Worker)
+    {
+        while (true)
+        {
+            SPayload Pay;
+
+            {
+                std::unique_lock<std::mutex> lock(Worker->Lock);
+                Worker->Busy = false;
+                if(Worker->Queue.empty())
+                    Worker->Idle.notify_all();
+
+                Worker->Signal.wait(lock, [Worker]() { return Worker->Stop || !Worker->Queue.empty(); });
+
+                //The queue is handled completely before the worker stops.
+                if(Worker->Queue.empty())
+                    return;
+
+                Pay = std::move(Worker->Queue.front());
+                Worker->Queue.pop_front();
+                Worker->Busy = true;
+            }
+
+            try
+            {
+                m_Callback(Pay);
+            }
+            catch(const std::exception &e)
+            {
+                llog << lerror << "Failed to handle " << Pay.T << " what(): " << e.what() << lendl;
+            }
+        }
+    }
+} // namespace DiscordBot
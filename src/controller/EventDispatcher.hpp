@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef EVENTDISPATCHER_HPP
+#define EVENTDISPATCHER_HPP
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <models/snowflake.hpp>
+#include "../models/Payload.hpp"
+
+namespace DiscordBot
+{
+    /**
+     * @brief Runs gateway events on a fixed pool of worker threads. Events with the same key always run on the same worker in the order they were posted.
+     * The client uses the guild id as key, so the events of one guild keep their order and different guilds are handled in parallel.
+     */
+    class CEventDispatcher
+    {
+        public:
+            using Handler = std::function<void(const SPayload &Pay)>;
+
+            CEventDispatcher() {}
+
+            /**
+             * @brief Starts the worker threads. Does nothing if the workers are already running.
+             */
+            void Start(size_t Workers, Handler Callback);
+
+            /**
+             * @brief Handles the queued events and stops the workers.
+             */
+            void Stop();
+
+            /**
+             * @brief Queues an event for the worker of the key.
+             */
+            void Post(snowflake Key, SPayload Pay);
+
+            /**
+             * @brief Waits until all queued events are handled.
+             */
+            void Wait();
+
+            inline bool IsRunning() const
+            {
+                return !m_Workers.empty();
+            }
+
+            ~CEventDispatcher()
+            {
+                Stop();
+            }
+
+        private:
+            struct SWorker
+            {
+                SWorker() : Busy(false), Stop(false) {}
+
+                std::thread Thread;
+                std::mutex Lock;
+                std::condition_variable Signal;     //!< Notified on new events and on stop.
+                std::condition_variable Idle;       //!< Notified if the queue is empty and the worker waits.
+                std::deque<SPayload> Queue;
+                bool Busy;
+                bool Stop;
+            };
+
+            void Run(SWorker *Worker);
+
+            std::vector<std::unique_ptr<SWorker>> m_Workers;
+            Handler m_Callback;
+    };
+} // namespace DiscordBot
+
+
+#endif //EVENTDISPATCHER_HPP
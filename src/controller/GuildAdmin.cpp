@@ -24,6 +24,7 @@
 
 #include "GuildAdmin.hpp"
 #include "DiscordClient.hpp"
+#include "BanPager.hpp"
 #include <models/DiscordException.hpp>
 #include <vector>
 #include "../helpers/Helper.hpp"
@@ -49,7 +50,7 @@ namespace DiscordBot
         if(values.empty() && !HasRoles)    //Nothing to do here.
             return;
 
-        GuildMember member = m_Client->GetMember(m_Guild, mod.GetUserRef()->ID);
+        //The member isn't fetched. The hierarchy is checked with the cache and discord checks the rest.
         GuildMember Bot;
 
         CJSON js;
@@ -72,6 +73,9 @@ namespace DiscordBot
                 continue;
             }
 
+            if(Adler == Adler32("nick"))
+                CheckHierarchy(Bot, mod.GetUserRef()->ID, "Missing right to modify user: The member has a higher role than the bot");
+
             if(Adler == Adler32("nick") || (Adler == Adler32("channel_id") && e.second != "null"))
                 js.AddPair(e.first, e.second);
             else
@@ -83,11 +87,16 @@ namespace DiscordBot
             auto Perm = MOD_PERMS.at(Adler32("roles"));
             Bot = CheckBotPermissions(Perm.first, "Missing right to modify user: '" + Perm.second + "'");
 
+            CheckHierarchy(Bot, mod.GetUserRef()->ID, "Missing right to modify user: The member has a higher role than the bot");
+
             std::vector<std::string> IDs;
             auto Roles = mod.GetRoles();
             
             for (auto &&e : Roles)
-                IDs.push_back(e->ID);
+            {
+                CheckRoleHierarchy(Bot, e);
+                IDs.push_back(e->ID.str());
+            }
 
             js.AddPair("roles", IDs);         
         }
@@ -101,6 +110,16 @@ namespace DiscordBot
             throw CDiscordClientException("Error during member modification. Error: " + res->body + " HTTP Code: " + std::to_string(res->statusCode), DiscordClientErrorType::HTTP_ERROR);
     }
 
+    void CGuildAdmin::AddMemberRole(User member, Role role)
+    {
+        ChangeMemberRole("PUT", member, role);
+    }
+
+    void CGuildAdmin::RemoveMemberRole(User member, Role role)
+    {
+        ChangeMemberRole("DELETE", member, role);
+    }
+
     void CGuildAdmin::BanMember(User member, const std::string &Reason, int DeleteMsgDays)
     {
         CheckBotPermissions(Permission::BAN_MEMBERS, "Missing right to ban users: 'BAN_MEMBERS'");
@@ -127,27 +146,24 @@ namespace DiscordBot
     std::vector<std::pair<std::string, User>> CGuildAdmin::GetGuildBans()    
     {
         std::vector<std::pair<std::string, User>> ret;
+        auto Pager = GetGuildBans(CBanPager::MAX_LIMIT, snowflake(), snowflake(), true);
 
-        CheckBotPermissions(Permission::BAN_MEMBERS, "Missing right to see the ban list: 'BAN_MEMBERS'");
-        auto res = m_Client->Get("/guilds/" + m_Guild->ID + "/bans");
-
-        if(res->statusCode != 200)
-            throw CDiscordClientException("Unable to get ban list. Error: " + res->body + " HTTP Code: " + std::to_string(res->statusCode), DiscordClientErrorType::HTTP_ERROR);
-
-        CJSON js;
-        auto list = js.Deserialize<std::vector<std::string>>(res->body);
-
-        for (auto e : list)
+        while (Pager->HasNext())
         {
-            js.ParseObject(e);
-
-            User user = m_Client->GetUserOrAdd(js.GetValue<std::string>("user"));
-            ret.push_back({js.GetValue<std::string>("reason"), user});
+            auto Page = Pager->Next();
+            for (auto &&e : Page)
+                ret.push_back({e.Reason, e.UserRef});
         }
 
         return ret;        
     }
 
+    BanPager CGuildAdmin::GetGuildBans(size_t Limit, snowflake After, snowflake Before, bool CacheUsers)
+    {
+        CheckBotPermissions(Permission::BAN_MEMBERS, "Missing right to see the ban list: 'BAN_MEMBERS'");
+        return BanPager(new CBanPager(m_Client, m_Guild->ID, Limit, After, Before, CacheUsers));
+    }
+
     void CGuildAdmin::KickMember(User member)    
     {
         CheckBotPermissions(Permission::KICK_MEMBERS, "Missing right to kick a user: 'KICK_MEMBERS'");
@@ -193,7 +209,7 @@ namespace DiscordBot
     void CGuildAdmin::AddChannelAction(Channel channel, Action action)
     {
         std::lock_guard<std::mutex> lock(m_Lock);
-        std::string ID;
+        snowflake ID;
         if(channel)
             ID = channel->ID;
 
@@ -221,7 +237,7 @@ namespace DiscordBot
     void CGuildAdmin::RemoveChannelAction(Channel channel, ActionType types) 
     {
         std::lock_guard<std::mutex> lock(m_Lock);
-        std::string ID;
+        snowflake ID;
         if(channel)
             ID = channel->ID;
 
@@ -237,8 +253,8 @@ namespace DiscordBot
     void CGuildAdmin::OnUserVoiceStateChanged(Channel c, GuildMember m)
     {
         std::lock_guard<std::mutex> lock(m_Lock);
-        std::vector<std::string> IDs = {
-            "",
+        std::vector<snowflake> IDs = {
+            snowflake(),
             c->ID
         };
 
@@ -263,8 +279,8 @@ namespace DiscordBot
     void CGuildAdmin::OnMessageEvent(ActionType Type, Channel c, Message m)
     {
         std::lock_guard<std::mutex> lock(m_Lock);
-        std::vector<std::string> IDs = {
-            "",
+        std::vector<snowflake> IDs = {
+            snowflake(),
             c->ID
         };
 
@@ -293,19 +309,59 @@ namespace DiscordBot
 
     bool CGuildAdmin::HasPermission(GuildMember member, Permission perm)
     {
-        bool ret = false;
-        for (auto e : member->Roles.load())
-        {
-            if((e->Permissions & perm) == perm)
-            {
-                ret = true;
-                break;
-            }
-        }
-        
+        return m_Client->HasPermission(m_Guild, member, perm);
+    }
+
+    int CGuildAdmin::GetHighestPosition(GuildMember member)
+    {
+        int ret = 0;
+        for (auto e : m_Guild->GetRoles(member))
+            ret = std::max<int>(ret, e->Position);
+
         return ret;
     }
 
+    void CGuildAdmin::CheckHierarchy(GuildMember Bot, snowflake UserID, const std::string &errMsg)
+    {
+        //The owner is above everyone.
+        if(m_Guild->Owner && m_Guild->Owner->UserRef && m_Guild->Owner->UserRef->ID == Bot->UserRef->ID)
+            return;
+
+        //Only checks cached members, discord rejects the request anyway if the member is higher.
+        GuildMember member = m_Guild->Members.get(UserID);
+        if(!member || !member->UserRef || member->UserRef->ID == Bot->UserRef->ID)
+            return;
+
+        if((m_Guild->Owner && m_Guild->Owner->UserRef && m_Guild->Owner->UserRef->ID == UserID) || GetHighestPosition(member) >= GetHighestPosition(Bot))
+            throw CDiscordClientException(errMsg, DiscordClientErrorType::MISSING_PERMISSION);
+    }
+
+    void CGuildAdmin::CheckRoleHierarchy(GuildMember Bot, Role role)
+    {
+        if(m_Guild->Owner && m_Guild->Owner->UserRef && m_Guild->Owner->UserRef->ID == Bot->UserRef->ID)
+            return;
+
+        if(role->Position >= GetHighestPosition(Bot))
+            throw CDiscordClientException("Missing right to assign role: '" + role->Name + "' is higher than the roles of the bot", DiscordClientErrorType::MISSING_PERMISSION);
+    }
+
+    void CGuildAdmin::ChangeMemberRole(const std::string &Method, User member, Role role)
+    {
+        if(!member)
+            throw CDiscordClientException("Error: A null user can't be modified", DiscordClientErrorType::MISSING_USER_REF);
+
+        if(!role)
+            throw CDiscordClientException("Error: role is null", DiscordClientErrorType::PARAMETER_IS_NULL);
+
+        auto Bot = CheckBotPermissions(Permission::MANAGE_ROLES, "Missing right to modify user: 'MANAGE_ROLES'");
+        CheckRoleHierarchy(Bot, role);
+
+        std::string URL = "/guilds/" + m_Guild->ID + "/members/" + member->ID + "/roles/" + role->ID;
+        auto res = Method == "PUT" ? m_Client->Put(URL, "") : m_Client->Delete(URL);
+        if(res->statusCode != 204)
+            throw CDiscordClientException("Error during member modification. Error: " + res->body + " HTTP Code: " + std::to_string(res->statusCode), DiscordClientErrorType::HTTP_ERROR);
+    }
+
     void CGuildAdmin::RenameSelf(const std::string &js)
     {
         auto res = m_Client->Patch("/guilds/" + m_Guild->ID + "/members/@me/nick", js);
@@ -342,8 +398,8 @@ namespace DiscordBot
             for (auto &&e : overwrites)
             {
                 CJSON tmp;
-                tmp.AddPair("id", e->ID.load());
-                tmp.AddPair("type", e->Type.load());
+                tmp.AddPair("id", e->ID.str());
+                tmp.AddPair("type", e->Type.str());
                 tmp.AddPair("allow", std::to_string((int)e->Allow));
                 tmp.AddPair("deny", std::to_string((int)e->Deny));
 
@@ -29,6 +29,7 @@
 #include <models/Message.hpp>
 #include <mutex>
 #include <map>
+#include <models/flat_map.hpp>
 
 namespace DiscordBot
 {
@@ -40,9 +41,12 @@ namespace DiscordBot
             CGuildAdmin(CDiscordClient *client, Guild guild) : m_Client(client), m_Guild(guild) {}
 
             void ModifyMember(const CModifyMember &mod) override;
+            void AddMemberRole(User member, Role role) override;
+            void RemoveMemberRole(User member, Role role) override;
             void BanMember(User member, const std::string &Reason = "", int DeleteMsgDays = -1) override;
             void UnbanMember(User user) override;
             std::vector<std::pair<std::string, User>> GetGuildBans() override;
+            BanPager GetGuildBans(size_t Limit, snowflake After = snowflake(), snowflake Before = snowflake(), bool CacheUsers = false) override;
             void KickMember(User member) override;
 
             void CreateChannel(const CModifyChannel &channel) override;
@@ -73,6 +77,23 @@ namespace DiscordBot
              * @brief Checks if a member has a given right.
              */
             bool HasPermission(GuildMember member, Permission perm);
+
+            /**
+             * @return Gets the position of the highest role of a member.
+             */
+            int GetHighestPosition(GuildMember member);
+
+            /**
+             * @brief Checks with the cached member, if the bot is above the member in the role hierarchy. Uncached members are checked by discord.
+             */
+            void CheckHierarchy(GuildMember Bot, snowflake UserID, const std::string &errMsg);
+
+            /**
+             * @brief Checks if the bot can assign the role.
+             */
+            void CheckRoleHierarchy(GuildMember Bot, Role role);
+
+            void ChangeMemberRole(const std::string &Method, User member, Role role);
             void RenameSelf(const std::string &js);
             std::string ModifyChannelToJS(const CModifyChannel &channel);
 
@@ -80,7 +101,7 @@ namespace DiscordBot
 
             CDiscordClient *m_Client;
             Guild m_Guild;
-            std::map<std::string, std::map<ActionType, Action>> m_Actions;
+            flat_map<snowflake, std::map<ActionType, Action>> m_Actions;
     };
 } // namespace DiscordBot
 
@@ -0,0 +1,99 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HTTPCLIENTPOOL_HPP
+#define HTTPCLIENTPOOL_HPP
+
+#include <ixwebsocket/IXHttpClient.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Pool of http clients. A ix::HttpClient can only handle one request at the same time, so every concurrent request needs its own client.
+     */
+    class CHTTPClientPool : public std::enable_shared_from_this<CHTTPClientPool>
+    {
+        public:
+            using HttpClient = std::shared_ptr<ix::HttpClient>;
+
+            CHTTPClientPool(const ix::SocketTLSOptions &Options) : m_Options(Options) {}
+
+            /**
+             * @return Gets an idle client or creates a new one. The client returns to the pool if the last reference is released.
+             */
+            HttpClient Acquire()
+            {
+                ix::HttpClient *Client = nullptr;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_Lock);
+                    if(!m_Idle.empty())
+                    {
+                        Client = m_Idle.back().release();
+                        m_Idle.pop_back();
+                    }
+                }
+
+                if(!Client)
+                {
+                    Client = new ix::HttpClient();
+                    Client->setTLSOptions(m_Options);
+                }
+
+                std::weak_ptr<CHTTPClientPool> Pool = shared_from_this();
+                return HttpClient(Client, [Pool](ix::HttpClient *c)
+                {
+                    auto Owner = Pool.lock();
+                    if(Owner)
+                        Owner->Release(c);
+                    else
+                        delete c;
+                });
+            }
+
+            ~CHTTPClientPool() {}
+
+        private:
+            static const size_t MAX_IDLE = 8;  //!< Maximum count of idle clients which are kept.
+
+            void Release(ix::HttpClient *Client)
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                if(m_Idle.size() < MAX_IDLE)
+                    m_Idle.push_back(std::unique_ptr<ix::HttpClient>(Client));
+                else
+                    delete Client;
+            }
+
+            ix::SocketTLSOptions m_Options;
+            std::mutex m_Lock;
+            std::vector<std::unique_ptr<ix::HttpClient>> m_Idle;
+    };
+} // namespace DiscordBot
+
+
+#endif //HTTPCLIENTPOOL_HPP
@@ -106,7 +106,7 @@ namespace DiscordBot
 
     std::string IController::GetPrefix(Guild g)
     {
-        return CmdsConfig->GetPrefix(g->ID, Prefix);
+        return CmdsConfig->GetPrefix(g->ID.load().str(), Prefix);
     }
 
     /**
@@ -119,22 +119,20 @@ namespace DiscordBot
         if(!guild)
             return m_CommandDescs[Cmd].Mode == AccessMode::EVERYBODY;
 
-        if (guild->Owner->UserRef->ID == member->UserRef->ID)
+        //The owner member isn't cached, if the member cache is disabled.
+        GuildMember Owner = guild->Owner;
+        if (Owner && Owner->UserRef && member && member->UserRef && Owner->UserRef->ID == member->UserRef->ID)
             return true;        
 
-        std::vector<std::string> RoleIDs = CmdsConfig->GetRoles(guild->ID, Cmd);
+        std::vector<std::string> RoleIDs = CmdsConfig->GetRoles(guild->ID.load().str(), Cmd);
         if(RoleIDs.empty())
             return m_CommandDescs[Cmd].Mode == AccessMode::EVERYBODY;
         else
         {
             for (auto &&Id : RoleIDs)
             {
-                auto IT = std::find_if(member->Roles->begin(), member->Roles->end(), [Id](Role r)
-                {
-                    return Id == r->ID;
-                });
-
-                if(IT != member->Roles->end())
+                auto IT = std::find(member->Roles.begin(), member->Roles.end(), snowflake(Id));
+                if(IT != member->Roles.end())
                     return true;
             }
         }
@@ -25,6 +25,7 @@
 #include <controller/IMusicQueue.hpp>
 #include <algorithm>
 #include "../helpers/Helper.hpp"
+#include "../helpers/MemoryUsage.hpp"
 
 namespace DiscordBot
 {
@@ -133,6 +134,22 @@ namespace DiscordBot
         return m_QueueIndex < m_Queue.size();
     }
 
+    /**
+     * @return Returns the approximated heap usage of the queued songs in bytes.
+     */
+    size_t IMusicQueue::MemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(m_QueueLock);
+        size_t Ret = m_Queue.capacity() * sizeof(SongInfo);
+        for (auto &&e : m_Queue)
+        {
+            if(e)
+                Ret += sizeof(CSongInfo) + HeapSize(e->Name) + HeapSize(e->Path) + HeapSize(e->Duration);
+        }
+
+        return Ret;
+    }
+
     /**
      * @return Gets the song at a given index. Returns null if the index is out of bounds.
      */
@@ -24,6 +24,7 @@
 
 #include "JSONCmdsConfig.hpp"
 #include <fstream>
+#include "../helpers/MemoryUsage.hpp"
 
 namespace DiscordBot
 {
@@ -139,6 +140,29 @@ namespace DiscordBot
         return Ret;
     }
 
+    size_t CJSONCmdsConfig::MemoryUsage()
+    {
+        //Red-black tree node header of libstdc++ and libc++.
+        static const size_t NODE = 4 * sizeof(void*);
+
+        size_t Ret = 0;
+        for (auto &&g : m_CmdDatabase)
+        {
+            Ret += NODE + sizeof(CmdDatabase::value_type) + HeapSize(g.first);
+            for (auto &&c : g.second)
+            {
+                Ret += NODE + sizeof(CmdDatabase::mapped_type::value_type) + HeapSize(c.first) + c.second.capacity() * sizeof(std::string);
+                for (auto &&r : c.second)
+                    Ret += HeapSize(r);
+            }
+        }
+
+        for (auto &&e : m_PrefixDatabase)
+            Ret += NODE + sizeof(PrefixDatabase::value_type) + HeapSize(e.first) + HeapSize(e.second);
+
+        return Ret;
+    }
+
     void CJSONCmdsConfig::SaveCmdDB()
     {
         CJSON json;
@@ -43,6 +43,7 @@ namespace DiscordBot
             void ChangePrefix(const std::string &Guild, const std::string &Prefix) override;
             void RemovePrefix(const std::string &Guild) override;
             std::string GetPrefix(const std::string &Guild, const std::string &Default) override;
+            size_t MemoryUsage() override;
 
             ~CJSONCmdsConfig() {}
         private:
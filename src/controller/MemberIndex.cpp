@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "MemberIndex.hpp"
+#include "../helpers/Helper.hpp"
+#include "../helpers/MemoryUsage.hpp"
+#include <algorithm>
+
+namespace DiscordBot
+{
+    void CMemberIndex::Build(snowflake Guild, const persistent_map<snowflake, GuildMember> &Members)
+    {
+        std::vector<SEntry> Entries;
+        Entries.reserve(Members.size() * 2);
+        for (auto &&e : Members)
+            GetEntries(e.second, Entries);
+
+        std::sort(Entries.begin(), Entries.end());
+        Entries.shrink_to_fit();
+
+        auto Index = GetGuild(Guild, true);
+        std::lock_guard<std::mutex> lock(Index->Lock);
+        Index->Entries.swap(Entries);
+    }
+
+    void CMemberIndex::Add(const GuildMember &Member)
+    {
+        if(!Member)
+            return;
+
+        std::vector<SEntry> Entries;
+        GetEntries(Member, Entries);
+
+        auto Index = GetGuild(Member->GuildID, true);
+        std::lock_guard<std::mutex> lock(Index->Lock);
+        for (auto &&e : Entries)
+            Insert(Index->Entries, e);
+    }
+
+    void CMemberIndex::Update(const GuildMember &Old, const GuildMember &New)
+    {
+        if(!Old || !New)
+            return;
+
+        std::vector<SEntry> OldEntries, NewEntries;
+        GetEntries(Old, OldEntries);
+        GetEntries(New, NewEntries);
+
+        //Most updates only change the roles.
+        if(OldEntries.size() == NewEntries.size() && std::equal(OldEntries.begin(), OldEntries.end(), NewEntries.begin(), [](const SEntry &lhs, const SEntry &rhs) {
+            return lhs.Name == rhs.Name && lhs.UserID == rhs.UserID;
+        }))
+            return;
+
+        auto Index = GetGuild(New->GuildID, true);
+        std::lock_guard<std::mutex> lock(Index->Lock);
+        for (auto &&e : OldEntries)
+            Erase(Index->Entries, e);
+
+        for (auto &&e : NewEntries)
+            Insert(Index->Entries, e);
+    }
+
+    void CMemberIndex::Remove(const GuildMember &Member)
+    {
+        if(!Member)
+            return;
+
+        std::vector<SEntry> Entries;
+        GetEntries(Member, Entries);
+
+        auto Index = GetGuild(Member->GuildID, false);
+        if(!Index)
+            return;
+
+        std::lock_guard<std::mutex> lock(Index->Lock);
+        for (auto &&e : Entries)
+            Erase(Index->Entries, e);
+    }
+
+    void CMemberIndex::RemoveGuild(snowflake Guild)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Guilds.erase(Guild);
+    }
+
+    void CMemberIndex::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Guilds = flat_map<snowflake, GuildIndex>();
+    }
+
+    std::vector<snowflake> CMemberIndex::Find(snowflake Guild, const std::string &Prefix, size_t Limit)
+    {
+        std::vector<snowflake> Ret;
+        auto Index = GetGuild(Guild, false);
+        if(!Index || Limit == 0)
+            return Ret;
+
+        SEntry Key;
+        Key.Name = ToLower(Prefix);
+
+        std::lock_guard<std::mutex> lock(Index->Lock);
+        auto IT = std::lower_bound(Index->Entries.begin(), Index->Entries.end(), Key);
+        for (; IT != Index->Entries.end() && Ret.size() < Limit; IT++)
+        {
+            if(IT->Name.compare(0, Key.Name.size(), Key.Name) != 0)
+                break;
+
+            //The username and the nickname of a member can both match.
+            if(std::find(Ret.begin(), Ret.end(), IT->UserID) == Ret.end())
+                Ret.push_back(IT->UserID);
+        }
+
+        return Ret;
+    }
+
+    size_t CMemberIndex::MemoryUsage()
+    {
+        std::vector<GuildIndex> Indices;
+        size_t Ret = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            Ret = m_Guilds.memory_usage();
+            Indices.reserve(m_Guilds.size());
+            for (auto &&e : m_Guilds)
+                Indices.push_back(e.second);
+        }
+
+        for (auto &&e : Indices)
+        {
+            std::lock_guard<std::mutex> lock(e->Lock);
+            Ret += sizeof(SGuildIndex) + e->Entries.capacity() * sizeof(SEntry);
+            for (auto &&Entry : e->Entries)
+                Ret += HeapSize(Entry.Name);
+        }
+
+        return Ret;
+    }
+
+    void CMemberIndex::GetEntries(const GuildMember &Member, std::vector<SEntry> &Entries)
+    {
+        if(!Member || !Member->UserRef)
+            return;
+
+        SEntry Entry;
+        Entry.UserID = Member->UserRef->ID;
+        Entry.Name = ToLower(Member->UserRef->Username);
+
+        std::string Nick = ToLower(Member->Nick);
+        if(!Nick.empty() && Nick != Entry.Name)
+        {
+            SEntry NickEntry;
+            NickEntry.UserID = Entry.UserID;
+            NickEntry.Name = std::move(Nick);
+            Entries.push_back(std::move(NickEntry));
+        }
+
+        Entries.push_back(std::move(Entry));
+    }
+
+    CMemberIndex::GuildIndex CMemberIndex::GetGuild(snowflake Guild, bool Create)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Guilds.find(Guild);
+        if(IT != m_Guilds.end())
+            return IT->second;
+
+        if(!Create)
+            return nullptr;
+
+        auto Ret = std::make_shared<SGuildIndex>();
+        m_Guilds.insert({Guild, Ret});
+        return Ret;
+    }
+
+    void CMemberIndex::Insert(std::vector<SEntry> &Entries, const SEntry &Entry)
+    {
+        auto IT = std::lower_bound(Entries.begin(), Entries.end(), Entry);
+        if(IT == Entries.end() || IT->Name != Entry.Name || IT->UserID != Entry.UserID)
+            Entries.insert(IT, Entry);
+    }
+
+    void CMemberIndex::Erase(std::vector<SEntry> &Entries, const SEntry &Entry)
+    {
+        auto IT = std::lower_bound(Entries.begin(), Entries.end(), Entry);
+        if(IT != Entries.end() && IT->Name == Entry.Name && IT->UserID == Entry.UserID)
+            Entries.erase(IT);
+    }
+} // namespace DiscordBot
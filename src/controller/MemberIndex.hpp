@@ -0,0 +1,119 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MEMBERINDEX_HPP
+#define MEMBERINDEX_HPP
+
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <models/GuildMember.hpp>
+#include <models/flat_map.hpp>
+#include <models/persistent_map.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Sorted arrays of the lower case usernames and nicknames of the members per guild. A prefix query is a binary search followed by a walk over the matches.
+     * 
+     * The index of a guild is built in one go from the member list of GUILD_CREATE. Single member events insert or erase their entries in place.
+     */
+    class CMemberIndex
+    {
+        public:
+            CMemberIndex() {}
+
+            /**
+             * @brief Replaces the index of a guild with the given members.
+             */
+            void Build(snowflake Guild, const persistent_map<snowflake, GuildMember> &Members);
+
+            void Add(const GuildMember &Member);
+
+            /**
+             * @brief Replaces the names of the old member object with the names of the new one.
+             */
+            void Update(const GuildMember &Old, const GuildMember &New);
+
+            void Remove(const GuildMember &Member);
+            void RemoveGuild(snowflake Guild);
+            void Clear();
+
+            /**
+             * @return Returns the user ids of up to Limit members, whose username or nickname starts with the prefix. The comparison ignores the case, the ids are ordered by the matched name.
+             */
+            std::vector<snowflake> Find(snowflake Guild, const std::string &Prefix, size_t Limit);
+
+            /**
+             * @return Returns the approximated heap usage in bytes.
+             */
+            size_t MemoryUsage();
+
+            ~CMemberIndex() {}
+
+        private:
+            struct SEntry
+            {
+                std::string Name;       //!< Lower case username or nickname.
+                snowflake UserID;
+
+                inline bool operator<(const SEntry &rhs) const
+                {
+                    int Cmp = Name.compare(rhs.Name);
+                    return Cmp < 0 || (Cmp == 0 && UserID < rhs.UserID);
+                }
+            };
+
+            struct SGuildIndex
+            {
+                std::mutex Lock;
+                std::vector<SEntry> Entries;
+            };
+
+            using GuildIndex = std::shared_ptr<SGuildIndex>;
+
+            /**
+             * @brief Appends the entries of a member. The username and the nickname share one entry, if they are equal.
+             */
+            static void GetEntries(const GuildMember &Member, std::vector<SEntry> &Entries);
+
+            /**
+             * @param Create: True to create a missing index.
+             */
+            GuildIndex GetGuild(snowflake Guild, bool Create);
+
+            static void Insert(std::vector<SEntry> &Entries, const SEntry &Entry);
+            static void Erase(std::vector<SEntry> &Entries, const SEntry &Entry);
+
+            std::mutex m_Lock;
+            flat_map<snowflake, GuildIndex> m_Guilds;
+    };
+} // namespace DiscordBot
+
+
+#endif //MEMBERINDEX_HPP
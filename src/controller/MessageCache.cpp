@@ -0,0 +1,283 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "MessageCache.hpp"
+#include "../helpers/MemoryUsage.hpp"
+
+namespace DiscordBot
+{
+    void CMessageCache::SetLimits(size_t Depth, size_t MaxBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        if(Depth != m_Depth)
+        {
+            m_Rings = Rings();
+            m_LRU.clear();
+            m_Bytes = 0;
+            m_Count = 0;
+        }
+
+        m_Depth = Depth;
+        m_MaxBytes = MaxBytes;
+        Shrink();
+    }
+
+    bool CMessageCache::IsEnabled()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Depth != 0;
+    }
+
+    void CMessageCache::Add(const Message &Msg)
+    {
+        if(!Msg || !Msg->ChannelRef)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if(m_Depth == 0)
+            return;
+
+        snowflake ChannelID = Msg->ChannelRef->ID;
+        auto IT = m_Rings.find(ChannelID);
+        if(IT == m_Rings.end())
+        {
+            SRing Ring;
+            Ring.GuildID = Msg->ChannelRef->GuildID;
+            Ring.Slots.resize(m_Depth);
+            Ring.Bytes.resize(m_Depth);
+            Ring.Head = 0;
+            Ring.Count = 0;
+            Ring.LRU = m_LRU.insert(m_LRU.end(), ChannelID);
+
+            IT = m_Rings.insert({ChannelID, std::move(Ring)}).first;
+        }
+        else
+            m_LRU.splice(m_LRU.end(), m_LRU, IT->second.LRU);
+
+        //Overwrites the oldest message.
+        SRing &Ring = IT->second;
+        size_t Slot = Ring.Head;
+        ClearSlot(Ring, Slot);
+
+        Ring.Slots[Slot] = Msg;
+        Ring.Bytes[Slot] = (uint32_t)ApproxSize(Msg);
+        Ring.Head = (Slot + 1) % m_Depth;
+        Ring.Count++;
+
+        m_Bytes += Ring.Bytes[Slot];
+        m_Count++;
+
+        Shrink();
+    }
+
+    bool CMessageCache::Replace(const Message &Msg)
+    {
+        if(!Msg || !Msg->ChannelRef)
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        auto IT = m_Rings.find(Msg->ChannelRef->ID);
+        if(IT == m_Rings.end())
+            return false;
+
+        SRing &Ring = IT->second;
+        size_t Slot = FindSlot(Ring, Msg->ID);
+        if(Slot == m_Depth)
+            return false;
+
+        m_Bytes -= Ring.Bytes[Slot];
+        Ring.Slots[Slot] = Msg;
+        Ring.Bytes[Slot] = (uint32_t)ApproxSize(Msg);
+        m_Bytes += Ring.Bytes[Slot];
+
+        Shrink();
+        return true;
+    }
+
+    Message CMessageCache::Get(snowflake ChannelID, snowflake MessageID)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Rings.find(ChannelID);
+        if(IT == m_Rings.end())
+            return nullptr;
+
+        size_t Slot = FindSlot(IT->second, MessageID);
+        return Slot != m_Depth ? IT->second.Slots[Slot] : nullptr;
+    }
+
+    std::vector<Message> CMessageCache::GetMessages(snowflake ChannelID)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        std::vector<Message> Ret;
+        auto IT = m_Rings.find(ChannelID);
+        if(IT == m_Rings.end())
+            return Ret;
+
+        const SRing &Ring = IT->second;
+        Ret.reserve(Ring.Count);
+
+        //Walks backwards from the last written slot.
+        for (size_t i = 1; i <= m_Depth; i++)
+        {
+            const Message &Msg = Ring.Slots[(Ring.Head + m_Depth - i) % m_Depth];
+            if(Msg)
+                Ret.push_back(Msg);
+        }
+
+        return Ret;
+    }
+
+    Message CMessageCache::Remove(snowflake ChannelID, snowflake MessageID)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Rings.find(ChannelID);
+        if(IT == m_Rings.end())
+            return nullptr;
+
+        size_t Slot = FindSlot(IT->second, MessageID);
+        if(Slot == m_Depth)
+            return nullptr;
+
+        Message Ret = IT->second.Slots[Slot];
+        ClearSlot(IT->second, Slot);
+
+        if(IT->second.Count == 0)
+            EraseRing(IT);
+
+        return Ret;
+    }
+
+    void CMessageCache::RemoveChannel(snowflake ChannelID)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Rings.find(ChannelID);
+        if(IT != m_Rings.end())
+            EraseRing(IT);
+    }
+
+    void CMessageCache::RemoveGuild(snowflake GuildID)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        std::vector<snowflake> Channels;
+        for (auto &&e : m_Rings)
+        {
+            if(e.second.GuildID == GuildID)
+                Channels.push_back(e.first);
+        }
+
+        for (auto &&e : Channels)
+            EraseRing(m_Rings.find(e));
+    }
+
+    void CMessageCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        m_Rings = Rings();
+        m_LRU.clear();
+        m_Bytes = 0;
+        m_Count = 0;
+    }
+
+    size_t CMessageCache::Size()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Count;
+    }
+
+    size_t CMessageCache::MemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        //The rings and the lru list nodes.
+        size_t Ret = m_Bytes + m_Rings.memory_usage() + m_LRU.size() * (sizeof(snowflake) + 2 * sizeof(void*));
+        for (auto &&e : m_Rings)
+            Ret += e.second.Slots.capacity() * sizeof(Message) + e.second.Bytes.capacity() * sizeof(uint32_t);
+
+        return Ret;
+    }
+
+    size_t CMessageCache::FindSlot(const SRing &Ring, snowflake MessageID)
+    {
+        for (size_t i = 0; i < m_Depth; i++)
+        {
+            if(Ring.Slots[i] && Ring.Slots[i]->ID == MessageID)
+                return i;
+        }
+
+        return m_Depth;
+    }
+
+    void CMessageCache::ClearSlot(SRing &Ring, size_t Slot)
+    {
+        if(!Ring.Slots[Slot])
+            return;
+
+        m_Bytes -= Ring.Bytes[Slot];
+        m_Count--;
+
+        Ring.Slots[Slot] = nullptr;
+        Ring.Bytes[Slot] = 0;
+        Ring.Count--;
+    }
+
+    void CMessageCache::EraseRing(Rings::iterator IT)
+    {
+        for (size_t i = 0; i < m_Depth; i++)
+            ClearSlot(IT->second, i);
+
+        m_LRU.erase(IT->second.LRU);
+        m_Rings.erase(IT);
+    }
+
+    void CMessageCache::Shrink()
+    {
+        while (m_MaxBytes != 0 && m_Bytes > m_MaxBytes && !m_LRU.empty())
+        {
+            auto IT = m_Rings.find(m_LRU.front());
+            SRing &Ring = IT->second;
+
+            //The oldest message is the first one after the head.
+            for (size_t i = 0; i < m_Depth; i++)
+            {
+                size_t Slot = (Ring.Head + i) % m_Depth;
+                if(Ring.Slots[Slot])
+                {
+                    ClearSlot(Ring, Slot);
+                    break;
+                }
+            }
+
+            if(Ring.Count == 0)
+                EraseRing(IT);
+        }
+    }
+} // namespace DiscordBot
@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MESSAGECACHE_HPP
+#define MESSAGECACHE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <mutex>
+#include <vector>
+#include <models/Message.hpp>
+#include <models/flat_map.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Recent messages of each channel in a ring buffer with a fixed depth. A new message overwrites the oldest slot of its channel, so adding a message doesn't allocate once the ring of the channel exists.
+     * 
+     * If the byte budget is exceeded, the oldest messages of the channel with the least recent activity are dropped first.
+     */
+    class CMessageCache
+    {
+        public:
+            CMessageCache() : m_Depth(0), m_MaxBytes(0), m_Bytes(0), m_Count(0) {}
+
+            /**
+             * @brief Sets the limits of the cache. Changing the depth clears the cache.
+             * 
+             * @param Depth: Messages per channel. 0 disables the cache.
+             * @param MaxBytes: Approximated heap budget of all messages. 0 for no budget.
+             */
+            void SetLimits(size_t Depth, size_t MaxBytes);
+
+            bool IsEnabled();
+
+            /**
+             * @brief Adds a message to the ring of its channel.
+             */
+            void Add(const Message &Msg);
+
+            /**
+             * @brief Replaces the slot of a cached message with a new version.
+             * 
+             * @return Returns false if the message isn't cached.
+             */
+            bool Replace(const Message &Msg);
+
+            /**
+             * @return Returns the cached message or null.
+             */
+            Message Get(snowflake ChannelID, snowflake MessageID);
+
+            /**
+             * @return Returns the cached messages of a channel, the newest first.
+             */
+            std::vector<Message> GetMessages(snowflake ChannelID);
+
+            /**
+             * @brief Removes a message from the cache.
+             * 
+             * @return Returns the removed message or null if it wasn't cached.
+             */
+            Message Remove(snowflake ChannelID, snowflake MessageID);
+
+            void RemoveChannel(snowflake ChannelID);
+            void RemoveGuild(snowflake GuildID);
+            void Clear();
+
+            size_t Size();
+
+            /**
+             * @return Returns the approximated heap usage in bytes.
+             */
+            size_t MemoryUsage();
+
+            ~CMessageCache() {}
+
+        private:
+            struct SRing
+            {
+                snowflake GuildID;
+                std::vector<Message> Slots;
+                std::vector<uint32_t> Bytes;        //!< Size of each slot, so evictions don't measure the messages again.
+                size_t Head;                        //!< Next slot to write, which is the oldest one.
+                size_t Count;                       //!< Occupied slots.
+                std::list<snowflake>::iterator LRU;
+            };
+
+            using Rings = flat_map<snowflake, SRing>;
+
+            /**
+             * @return Returns the slot of a message or Depth if the message isn't in the ring.
+             */
+            size_t FindSlot(const SRing &Ring, snowflake MessageID);
+
+            void ClearSlot(SRing &Ring, size_t Slot);
+            void EraseRing(Rings::iterator IT);
+
+            /**
+             * @brief Drops the oldest messages of the least recently used channels until the budget is met.
+             */
+            void Shrink();
+
+            std::mutex m_Lock;
+            size_t m_Depth;
+            size_t m_MaxBytes;
+            size_t m_Bytes;
+            size_t m_Count;
+
+            Rings m_Rings;
+            std::list<snowflake> m_LRU;     //!< Channels, the least recently written first.
+    };
+} // namespace DiscordBot
+
+
+#endif //MESSAGECACHE_HPP
@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MultipartBody.hpp"
+#include <sodium.h>
+#include <stdio.h>
+#include <algorithm>
+
+#ifdef DISCORDBOT_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace DiscordBot
+{
+    CMappedFile::CMappedFile(const std::string &Path, size_t MaxSize) : m_Open(false), m_TooLarge(false), m_Data(nullptr), m_Size(0)
+    {
+#ifdef DISCORDBOT_UNIX
+        int fd = open(Path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        bool Regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        m_TooLarge = Regular && (uint64_t)st.st_size > MaxSize;
+
+        if(Regular && !m_TooLarge)
+        {
+            m_Size = (size_t)st.st_size;
+            m_Open = true;
+
+            //Empty files can't be mapped.
+            if(m_Size != 0)
+            {
+                void *Mem = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(Mem != MAP_FAILED)
+                {
+                    //The file is read once from the beginning to the end.
+                    madvise(Mem, m_Size, MADV_SEQUENTIAL);
+                    m_Data = (const char*)Mem;
+                }
+                else
+                {
+                    m_Open = false;
+                    m_Size = 0;
+                }
+            }
+        }
+
+        close(fd);
+#else
+        FILE *f = fopen(Path.c_str(), "rb");
+        if(!f)
+            return;
+
+        fseek(f, 0, SEEK_END);
+        long Size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        if(Size >= 0 && (uint64_t)Size > MaxSize)
+            m_TooLarge = true;
+        else if(Size >= 0)
+        {
+            m_Buffer.resize((size_t)Size);
+            m_Size = fread(m_Buffer.data(), 1, m_Buffer.size(), f);
+            m_Data = m_Buffer.data();
+            m_Open = m_Size == (size_t)Size;
+        }
+
+        fclose(f);
+#endif
+    }
+
+    CMappedFile::~CMappedFile()
+    {
+#ifdef DISCORDBOT_UNIX
+        if(m_Data)
+            munmap((void*)m_Data, m_Size);
+#endif
+    }
+
+    CMultipartBody::CMultipartBody() : m_FileBytes(0)
+    {
+        static const char CHARS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+        m_Boundary = "libDiscordBot";
+        for (size_t i = 0; i < 24; i++)
+            m_Boundary += CHARS[randombytes_uniform(sizeof(CHARS) - 1)];
+    }
+
+    void CMultipartBody::AddField(const std::string &Name, const std::string &Value, const std::string &ContentType)
+    {
+        SPart Part;
+        Part.Header = "--" + m_Boundary + "\r\nContent-Disposition: form-data; name=\"" + Name + "\"\r\n";
+        if(!ContentType.empty())
+            Part.Header += "Content-Type: " + ContentType + "\r\n";
+
+        Part.Header += "\r\n";
+        Part.Value = Value;
+
+        m_Parts.push_back(Part);
+    }
+
+    bool CMultipartBody::AddFile(const std::string &Name, const std::string &Path)
+    {
+        //Oversized files are rejected before they are mapped.
+        auto File = std::make_shared<CMappedFile>(Path, MAX_UPLOAD_SIZE - m_FileBytes);
+        if(!File->IsOpen())
+            return false;
+
+        m_FileBytes += File->Size();
+
+        std::string Filename = Path.substr(Path.find_last_of("/\\") + 1);
+        Filename.erase(std::remove(Filename.begin(), Filename.end(), '"'), Filename.end());
+
+        SPart Part;
+        Part.Header = "--" + m_Boundary + "\r\nContent-Disposition: form-data; name=\"" + Name + "\"; filename=\"" + Filename + "\"\r\nContent-Type: application/octet-stream\r\n\r\n";
+        Part.File = File;
+
+        m_Parts.push_back(Part);
+        return true;
+    }
+
+    std::string CMultipartBody::Build() const
+    {
+        std::string Footer = "--" + m_Boundary + "--\r\n";
+
+        size_t Size = Footer.size();
+        for (auto &&e : m_Parts)
+            Size += e.Header.size() + (e.File ? e.File->Size() : e.Value.size()) + 2;
+
+        //Allocates the body once, so the file content is never copied twice.
+        std::string Body;
+        Body.reserve(Size);
+
+        for (auto &&e : m_Parts)
+        {
+            Body += e.Header;
+            if(e.File)
+                Body.append(e.File->Data() ? e.File->Data() : "", e.File->Size());
+            else
+                Body += e.Value;
+
+            Body += "\r\n";
+        }
+
+        Body += Footer;
+        return Body;
+    }
+} // namespace DiscordBot
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MULTIPARTBODY_HPP
+#define MULTIPARTBODY_HPP
+
+#include <config.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Read only view of a file. The file is memory mapped, so the content is only loaded by the kernel if it is accessed.
+     */
+    class CMappedFile
+    {
+        public:
+            /**
+             * @param MaxSize: Files which are larger aren't mapped. @see IsTooLarge
+             */
+            CMappedFile(const std::string &Path, size_t MaxSize = SIZE_MAX);
+
+            CMappedFile(const CMappedFile&) = delete;
+            CMappedFile &operator=(const CMappedFile&) = delete;
+
+            inline bool IsOpen() const
+            {
+                return m_Open;
+            }
+
+            inline bool IsTooLarge() const
+            {
+                return m_TooLarge;
+            }
+
+            inline const char *Data() const
+            {
+                return m_Data;
+            }
+
+            inline size_t Size() const
+            {
+                return m_Size;
+            }
+
+            ~CMappedFile();
+
+        private:
+            bool m_Open;
+            bool m_TooLarge;
+            const char *m_Data;
+            size_t m_Size;
+
+#ifdef DISCORDBOT_WINDOWS
+            std::vector<char> m_Buffer;     //!< Fallback for systems without mmap.
+#endif
+    };
+
+    /**
+     * @brief Builds a multipart/form-data body. Files are mapped and copied once into a body, which is allocated with its final size.
+     * The http client needs the whole body in memory, so the files of one body are bounded by MAX_UPLOAD_SIZE.
+     */
+    class CMultipartBody
+    {
+        public:
+            static const size_t MAX_UPLOAD_SIZE = 8 * 1024 * 1024;  //!< Upload limit of discord per message.
+
+            CMultipartBody();
+
+            /**
+             * @brief Adds a text field. E.g. "payload_json"
+             */
+            void AddField(const std::string &Name, const std::string &Value, const std::string &ContentType = "");
+
+            /**
+             * @brief Adds a file field. The filename is the last part of the path.
+             * 
+             * @return Returns false if the file can't be opened or the files of the body would exceed MAX_UPLOAD_SIZE. The file isn't mapped in this case.
+             */
+            bool AddFile(const std::string &Name, const std::string &Path);
+
+            /**
+             * @return Returns the content type header value with the boundary.
+             */
+            inline std::string GetContentType() const
+            {
+                return "multipart/form-data; boundary=" + m_Boundary;
+            }
+
+            std::string Build() const;
+
+            ~CMultipartBody() {}
+
+        private:
+            struct SPart
+            {
+                std::string Header;
+                std::string Value;
+                std::shared_ptr<CMappedFile> File;
+            };
+
+            std::string m_Boundary;
+            std::vector<SPart> m_Parts;
+            size_t m_FileBytes;
+    };
+} // namespace DiscordBot
+
+
+#endif //MULTIPARTBODY_HPP
@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "PermissionEngine.hpp"
+#include <algorithm>
+
+namespace DiscordBot
+{
+    namespace
+    {
+        inline uint32_t Mask(Permission Perm)
+        {
+            return (uint32_t)Perm;
+        }
+
+        /**
+         * @brief Removes the denied and adds the allowed permissions.
+         */
+        inline uint32_t Apply(uint32_t Perms, uint32_t Allow, uint32_t Deny)
+        {
+            return (Perms & ~Deny) | Allow;
+        }
+    }
+
+    Permission CPermissionEngine::ComputeBase(const Guild &guild, const GuildMember &member)
+    {
+        if(!guild || !member || !member->UserRef)
+            return (Permission)0;
+
+        GuildMember Owner = guild->Owner;
+        if(Owner && Owner->UserRef && Owner->UserRef->ID == member->UserRef->ID)
+            return ALL;
+
+        //The @everyone role has the id of the guild.
+        auto Roles = guild->Roles.load();
+        uint32_t Ret = 0;
+        auto IT = Roles->find(guild->ID.load());
+        if(IT != Roles->end())
+            Ret = Mask(IT->second->Permissions);
+
+        for (auto &&e : member->Roles)
+        {
+            IT = Roles->find(e);
+            if(IT != Roles->end())
+                Ret |= Mask(IT->second->Permissions);
+        }
+
+        if(Ret & Mask(Permission::ADMINISTRATOR))
+            return ALL;
+
+        return (Permission)Ret;
+    }
+
+    Permission CPermissionEngine::ComputeOverwrites(Permission Base, const Guild &guild, const GuildMember &member, const Channel &channel)
+    {
+        if(!channel || !guild || !member || !member->UserRef || (Mask(Base) & Mask(Permission::ADMINISTRATOR)))
+            return Base;
+
+        snowflake GuildID = guild->ID.load();
+        snowflake UserID = member->UserRef->ID;
+        uint32_t Ret = Mask(Base);
+
+        //Order: @everyone, all roles of the member combined, the member itself.
+        uint32_t RoleAllow = 0, RoleDeny = 0;
+        PermissionOverwrites MemberOverwrite;
+        for (auto &&e : channel->Overwrites)
+        {
+            if(e->ID == GuildID)
+                Ret = Apply(Ret, Mask(e->Allow), Mask(e->Deny));
+            else if(e->ID == UserID)
+                MemberOverwrite = e;
+            else if(std::find(member->Roles.begin(), member->Roles.end(), e->ID) != member->Roles.end())
+            {
+                RoleAllow |= Mask(e->Allow);
+                RoleDeny |= Mask(e->Deny);
+            }
+        }
+
+        Ret = Apply(Ret, RoleAllow, RoleDeny);
+        if(MemberOverwrite)
+            Ret = Apply(Ret, Mask(MemberOverwrite->Allow), Mask(MemberOverwrite->Deny));
+
+        return (Permission)Ret;
+    }
+
+    Permission CPermissionEngine::Get(const Guild &guild, const GuildMember &member, const Channel &channel)
+    {
+        if(!guild || !member || !member->UserRef)
+            return (Permission)0;
+
+        snowflake GuildID = guild->ID.load();
+        snowflake UserID = member->UserRef->ID;
+        snowflake ChannelID = channel ? channel->ID : snowflake();
+
+        //Channels of messages only carry the id, the overwrites are taken from the cache.
+        Channel Cached = channel ? guild->Channels.get(ChannelID) : Channel();
+        bool Cacheable = guild->Members.get(UserID) == member && (!channel || Cached);
+
+        uint64_t Generation = 0;
+        if(Cacheable)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto GIT = m_Cache.find(GuildID);
+            if(GIT != m_Cache.end())
+            {
+                auto MIT = GIT->second.find(UserID);
+                if(MIT != GIT->second.end())
+                {
+                    auto CIT = MIT->second.find(ChannelID);
+                    if(CIT != MIT->second.end())
+                        return CIT->second;
+                }
+            }
+
+            Generation = m_Generation;
+        }
+
+        Permission Ret = ComputeBase(guild, member);
+        if(channel)
+            Ret = ComputeOverwrites(Ret, guild, member, Cached ? Cached : channel);
+
+        if(Cacheable)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if(Generation == m_Generation)
+                m_Cache[GuildID][UserID][ChannelID] = Ret;
+        }
+
+        return Ret;
+    }
+
+    void CPermissionEngine::InvalidateGuild(snowflake Guild)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Generation++;
+        m_Cache.erase(Guild);
+    }
+
+    void CPermissionEngine::InvalidateChannel(snowflake Guild, snowflake Channel)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Generation++;
+
+        auto IT = m_Cache.find(Guild);
+        if(IT == m_Cache.end())
+            return;
+
+        for (auto &&e : IT->second)
+            e.second.erase(Channel);
+    }
+
+    void CPermissionEngine::InvalidateMember(snowflake Guild, snowflake User)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Generation++;
+
+        auto IT = m_Cache.find(Guild);
+        if(IT != m_Cache.end())
+            IT->second.erase(User);
+    }
+
+    void CPermissionEngine::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Generation++;
+        m_Cache = flat_map<snowflake, MemberPermissions>();
+    }
+} // namespace DiscordBot
@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PERMISSIONENGINE_HPP
+#define PERMISSIONENGINE_HPP
+
+#include <stdint.h>
+#include <mutex>
+#include <models/flat_map.hpp>
+#include <models/snowflake.hpp>
+#include <models/Guild.hpp>
+#include <models/Channel.hpp>
+#include <models/GuildMember.hpp>
+#include <models/Role.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Computes the effective permissions of members like discord does. For more info see <a href="https://discord.com/developers/docs/topics/permissions#permission-overwrites">here</a>.
+     * 
+     * Results are cached per guild, member and channel. The client invalidates them on role, channel and member events.
+     * Only the cached member and channel objects of a guild are cached, results of other objects are computed on every call.
+     */
+    class CPermissionEngine
+    {
+        public:
+            static const Permission ALL = (Permission)0x7FFFFFFF;
+
+            CPermissionEngine() : m_Generation(0) {}
+
+            /**
+             * @return Gets the permissions of a member in a guild. Includes @everyone, the owner and ADMINISTRATOR.
+             */
+            static Permission ComputeBase(const Guild &guild, const GuildMember &member);
+
+            /**
+             * @return Applies the permission overwrites of a channel to the base permissions. @see ComputeBase
+             */
+            static Permission ComputeOverwrites(Permission Base, const Guild &guild, const GuildMember &member, const Channel &channel);
+
+            /**
+             * @return Gets the cached permissions of a member. The channel is optional.
+             */
+            Permission Get(const Guild &guild, const GuildMember &member, const Channel &channel);
+
+            /**
+             * @brief Removes all results of a guild. Called if a role changes.
+             */
+            void InvalidateGuild(snowflake Guild);
+            void InvalidateChannel(snowflake Guild, snowflake Channel);
+            void InvalidateMember(snowflake Guild, snowflake User);
+            void Clear();
+
+            ~CPermissionEngine() {}
+
+        private:
+            using ChannelPermissions = flat_map<snowflake, Permission>;      //!< Channel id to permissions. The guild permissions are stored with an empty id.
+            using MemberPermissions = flat_map<snowflake, ChannelPermissions>;
+
+            std::mutex m_Lock;
+            flat_map<snowflake, MemberPermissions> m_Cache;
+
+            //Incremented by every invalidation. Results which were computed meanwhile aren't stored.
+            uint64_t m_Generation;
+    };
+} // namespace DiscordBot
+
+
+#endif //PERMISSIONENGINE_HPP
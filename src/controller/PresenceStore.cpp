@@ -0,0 +1,184 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "PresenceStore.hpp"
+#include "../helpers/MemoryUsage.hpp"
+#include <algorithm>
+
+namespace DiscordBot
+{
+    bool CPresenceStore::IsChanged(snowflake User, uint64_t Hash, uint32_t Seq)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Index.find(User);
+        if(IT == m_Index.end())
+            return true;
+
+        uint32_t Row = IT->second;
+        if(m_Hashes[Row] != Hash)
+            return true;
+
+        //The same presence with a newer sequence still outdates older events of other guilds.
+        if(Seq > m_Seqs[Row])
+            m_Seqs[Row] = Seq;
+
+        return false;
+    }
+
+    bool CPresenceStore::Set(snowflake User, uint64_t Hash, uint32_t Seq, SPresence Presence)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Index.find(User);
+        if(IT != m_Index.end())
+        {
+            uint32_t Row = IT->second;
+
+            //Events of different guilds are handled by different workers, so an older presence may arrive last.
+            if(Seq < m_Seqs[Row])
+                return false;
+
+            m_Seqs[Row] = Seq;
+            m_Hashes[Row] = Hash;
+            m_States[Row] = PackStates(Presence);
+            m_Activities[Row].swap(Presence.Activities);
+        }
+        else
+        {
+            m_Index.insert({User, (uint32_t)m_Users.size()});
+            m_Users.push_back(User);
+            m_Seqs.push_back(Seq);
+            m_Hashes.push_back(Hash);
+            m_States.push_back(PackStates(Presence));
+            m_Activities.push_back(std::move(Presence.Activities));
+        }
+
+        return true;
+    }
+
+    bool CPresenceStore::Get(snowflake User, SPresence &Presence)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Index.find(User);
+        if(IT == m_Index.end())
+            return false;
+
+        UnpackStates(m_States[IT->second], Presence);
+        Presence.Activities = m_Activities[IT->second];
+        return true;
+    }
+
+    std::vector<snowflake> CPresenceStore::GetUserIDs()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Users;
+    }
+
+    void CPresenceStore::Erase(snowflake User)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Index.find(User);
+        if(IT == m_Index.end())
+            return;
+
+        //Moves the last row into the gap.
+        uint32_t Row = IT->second;
+        uint32_t Last = (uint32_t)m_Users.size() - 1;
+        m_Index.erase(IT);
+
+        if(Row != Last)
+        {
+            m_Users[Row] = m_Users[Last];
+            m_Seqs[Row] = m_Seqs[Last];
+            m_Hashes[Row] = m_Hashes[Last];
+            m_States[Row] = m_States[Last];
+            m_Activities[Row].swap(m_Activities[Last]);
+            m_Index[m_Users[Row]] = Row;
+        }
+
+        m_Users.pop_back();
+        m_Seqs.pop_back();
+        m_Hashes.pop_back();
+        m_States.pop_back();
+        m_Activities.pop_back();
+    }
+
+    void CPresenceStore::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        m_Index.clear();
+        m_Users = std::vector<snowflake>();
+        m_Seqs = std::vector<uint32_t>();
+        m_Hashes = std::vector<uint64_t>();
+        m_States = std::vector<uint16_t>();
+        m_Activities = std::vector<std::vector<Activity>>();
+    }
+
+    void CPresenceStore::ResetSequences()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        std::fill(m_Seqs.begin(), m_Seqs.end(), 0);
+    }
+
+    size_t CPresenceStore::Size()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Users.size();
+    }
+
+    size_t CPresenceStore::MemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        size_t Ret = m_Index.memory_usage() + m_Users.capacity() * sizeof(snowflake) + m_Seqs.capacity() * sizeof(uint32_t) + m_Hashes.capacity() * sizeof(uint64_t) + 
+                     m_States.capacity() * sizeof(uint16_t) + m_Activities.capacity() * sizeof(std::vector<Activity>);
+
+        for (auto &&Row : m_Activities)
+        {
+            Ret += Row.capacity() * sizeof(Activity);
+            for (auto &&e : Row)
+                Ret += ApproxSize(e);
+        }
+
+        return Ret;
+    }
+
+    uint16_t CPresenceStore::PackStates(const SPresence &Presence)
+    {
+        return (uint16_t)((unsigned)Presence.State | ((unsigned)Presence.Desktop << 3) | ((unsigned)Presence.Mobile << 6) | ((unsigned)Presence.Web << 9));
+    }
+
+    void CPresenceStore::UnpackStates(uint16_t States, SPresence &Presence)
+    {
+        Presence.State = (OnlineState)(States & 0x7);
+        Presence.Desktop = (OnlineState)((States >> 3) & 0x7);
+        Presence.Mobile = (OnlineState)((States >> 6) & 0x7);
+        Presence.Web = (OnlineState)((States >> 9) & 0x7);
+    }
+} // namespace DiscordBot
@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PRESENCESTORE_HPP
+#define PRESENCESTORE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+#include <models/Presence.hpp>
+#include <models/flat_map.hpp>
+#include <models/snowflake.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Presences of all users as structure of arrays. Updates overwrite the row of the user in place and removed rows are filled with the last row.
+     * 
+     * Each row holds a hash of the raw presence payload, so repeated presences (discord sends one per shared guild) are dropped before they are parsed.
+     * Each row also holds the gateway sequence of its last presence. The events of different guilds are handled in parallel, so a presence is only applied if it isn't older than the stored one.
+     */
+    class CPresenceStore
+    {
+        public:
+            CPresenceStore() {}
+
+            /**
+             * @brief Raises the stored sequence, if the presence is unchanged.
+             * 
+             * @return Returns true if the user has no presence or a presence with a different hash.
+             */
+            bool IsChanged(snowflake User, uint64_t Hash, uint32_t Seq);
+
+            /**
+             * @brief Adds or overwrites the presence of a user.
+             * 
+             * @param Seq: Gateway sequence of the presence event.
+             * 
+             * @return Returns false if the stored presence is newer.
+             */
+            bool Set(snowflake User, uint64_t Hash, uint32_t Seq, SPresence Presence);
+
+            /**
+             * @return Returns false if the user has no presence.
+             */
+            bool Get(snowflake User, SPresence &Presence);
+
+            /**
+             * @return Returns the ids of all users with a presence.
+             */
+            std::vector<snowflake> GetUserIDs();
+
+            void Erase(snowflake User);
+            void Clear();
+
+            /**
+             * @brief Must be called for a new gateway session, which starts its sequence at 1 again.
+             */
+            void ResetSequences();
+
+            size_t Size();
+
+            /**
+             * @return Returns the approximated heap usage in bytes.
+             */
+            size_t MemoryUsage();
+
+            ~CPresenceStore() {}
+
+        private:
+            //Four online states with three bits each.
+            static uint16_t PackStates(const SPresence &Presence);
+            static void UnpackStates(uint16_t States, SPresence &Presence);
+
+            std::mutex m_Lock;
+            flat_map<snowflake, uint32_t> m_Index;     //!< User id to row.
+
+            std::vector<snowflake> m_Users;
+            std::vector<uint32_t> m_Seqs;
+            std::vector<uint64_t> m_Hashes;
+            std::vector<uint16_t> m_States;
+            std::vector<std::vector<Activity>> m_Activities;
+    };
+} // namespace DiscordBot
+
+
+#endif //PRESENCESTORE_HPP
@@ -0,0 +1,222 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RESTCache.hpp"
+#include "RESTClient.hpp"
+#include "RequestScheduler.hpp"
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    CRESTCache::CRESTCache() : m_Generation(0)
+    {
+        //Default ttls. The gateway events invalidate these routes earlier.
+        m_TTLs["GET /gateway/bot"] = 5 * 60 * 1000;
+        m_TTLs["GET /channels/:major"] = 5 * 60 * 1000;
+        m_TTLs["GET /guilds/:major/roles"] = 5 * 60 * 1000;
+
+        //Member updates are only sent with the "Server Members Intent".
+        m_TTLs["GET /guilds/:major/members/:id"] = 60 * 1000;
+    }
+
+    void CRESTCache::SetTTL(const std::string &Route, uint32_t TTL)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if(TTL == 0)
+            m_TTLs.erase(Route);
+        else
+            m_TTLs[Route] = TTL;
+    }
+
+    ix::HttpResponsePtr CRESTCache::Get(const std::string &URL)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        auto IT = m_Entries.find(URL);
+        if(IT == m_Entries.end())
+            return nullptr;
+
+        if(IT->second.Expires <= GetTimeMillis())
+        {
+            m_Entries.erase(IT);
+            return nullptr;
+        }
+
+        //The caller may modify the response.
+        return ix::HttpResponsePtr(new ix::HttpResponse(*IT->second.Res));
+    }
+
+    uint64_t CRESTCache::Begin()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_InFlight.insert(m_Generation);
+
+        return m_Generation;
+    }
+
+    void CRESTCache::Put(const std::string &URL, ix::HttpResponsePtr res, uint64_t Generation)
+    {
+        std::string Template, Major;
+        CRequestScheduler::SplitMajor(CRESTClient::GetRoute("GET", URL), Template, Major);
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        //A gateway event or write may have changed the resource while the request was running.
+        bool Stale = IsInvalidated(URL, Generation);
+
+        auto Running = m_InFlight.find(Generation);
+        if(Running != m_InFlight.end())
+            m_InFlight.erase(Running);
+
+        if(m_InFlight.empty())
+            m_Invalidated.clear();
+        else if(m_Invalidated.size() >= MAX_ENTRIES)
+        {
+            //Invalidations older than the oldest running request can't affect any request.
+            uint64_t Oldest = *m_InFlight.begin();
+            for (auto IT = m_Invalidated.begin(); IT != m_Invalidated.end();)
+            {
+                if(IT->second <= Oldest)
+                    IT = m_Invalidated.erase(IT);
+                else
+                    IT++;
+            }
+        }
+
+        if(Stale || !res || res->errorCode != ix::HttpErrorCode::Ok || res->statusCode != 200)
+            return;
+
+        auto TTL = m_TTLs.find(Template);
+        if(TTL == m_TTLs.end())
+            return;
+
+        int64_t Now = GetTimeMillis();
+        if(m_Entries.size() >= MAX_ENTRIES)
+        {
+            RemoveExpired(Now);
+            if(m_Entries.size() >= MAX_ENTRIES)
+                return;
+        }
+
+        m_Entries[URL] = {ix::HttpResponsePtr(new ix::HttpResponse(*res)), Now + TTL->second};
+    }
+
+    void CRESTCache::Invalidate(const std::string &Path)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        AddInvalidation(Path);
+
+        auto IT = m_Entries.lower_bound(Path);
+        while (IT != m_Entries.end() && IT->first.compare(0, Path.size(), Path) == 0)
+        {
+            //Keeps "/channels/12345" if "/channels/1234" is invalidated.
+            char Next = IT->first.size() > Path.size() ? IT->first[Path.size()] : '/';
+            if(Next == '/' || Next == '?')
+                IT = m_Entries.erase(IT);
+            else
+                IT++;
+        }
+    }
+
+    void CRESTCache::InvalidateWrite(const std::string &Path)
+    {
+        std::string Clean = Path.substr(0, Path.find('?'));
+        Invalidate(Clean);
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        size_t Pos = Clean.rfind('/');
+        while (Pos != std::string::npos && Pos != 0)
+        {
+            Clean.resize(Pos);
+            EraseExact(Clean);
+
+            Pos = Clean.rfind('/');
+        }
+    }
+
+    void CRESTCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        AddInvalidation("");
+        m_Entries.clear();
+    }
+
+    //--------------------------Private--------------------------//
+
+    void CRESTCache::EraseExact(const std::string &Path)
+    {
+        AddInvalidation(Path);
+        m_Entries.erase(Path);
+
+        //Removes the path with all queries.
+        std::string Query = Path + "?";
+        auto IT = m_Entries.lower_bound(Query);
+        while (IT != m_Entries.end() && IT->first.compare(0, Query.size(), Query) == 0)
+            IT = m_Entries.erase(IT);
+    }
+
+    void CRESTCache::AddInvalidation(const std::string &Path)
+    {
+        m_Generation++;
+        if(!m_InFlight.empty())
+            m_Invalidated[Path] = m_Generation;
+    }
+
+    bool CRESTCache::IsInvalidated(const std::string &URL, uint64_t Generation)
+    {
+        if(m_Invalidated.empty())
+            return false;
+
+        std::string Path = URL.substr(0, URL.find('?'));
+
+        //Checks the path and every parent path. Invalidating a parent also invalidates its sub paths.
+        size_t Pos = 0;
+        while (true)
+        {
+            auto IT = m_Invalidated.find(Path.substr(0, Pos));
+            if(IT != m_Invalidated.end() && IT->second > Generation)
+                return true;
+
+            if(Pos == Path.size())
+                break;
+
+            Pos = Path.find('/', Pos + 1);
+            if(Pos == std::string::npos)
+                Pos = Path.size();
+        }
+
+        return false;
+    }
+
+    void CRESTCache::RemoveExpired(int64_t Now)
+    {
+        for (auto IT = m_Entries.begin(); IT != m_Entries.end();)
+        {
+            if(IT->second.Expires <= Now)
+                IT = m_Entries.erase(IT);
+            else
+                IT++;
+        }
+    }
+} // namespace DiscordBot
@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RESTCACHE_HPP
+#define RESTCACHE_HPP
+
+#include <ixwebsocket/IXHttp.h>
+#include <string>
+#include <map>
+#include <set>
+#include <mutex>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Read through cache for GET requests. Entries expire after the ttl of their route or are invalidated by gateway events.
+     */
+    class CRESTCache
+    {
+        public:
+            CRESTCache();
+
+            /**
+             * @brief Sets the time to live of a route. A ttl of 0 disables the caching of the route.
+             * 
+             * @param Route: Route with the major parameter replaced by ":major". E.g. "GET /guilds/:major/roles"
+             * @param TTL: Time to live in milliseconds.
+             */
+            void SetTTL(const std::string &Route, uint32_t TTL);
+
+            /**
+             * @return Returns a copy of the cached response or null if the url isn't cached.
+             */
+            ix::HttpResponsePtr Get(const std::string &URL);
+
+            /**
+             * @brief Starts a read through. Every call must be followed by a call of Put with the returned generation.
+             * 
+             * @return Returns the current generation, which Put uses to detect invalidations during the request.
+             */
+            uint64_t Begin();
+
+            /**
+             * @brief Caches a successful response, if the route has a ttl and the url wasn't invalidated since Begin returned the generation.
+             */
+            void Put(const std::string &URL, ix::HttpResponsePtr res, uint64_t Generation);
+
+            /**
+             * @brief Removes the path and all sub paths. E.g. "/channels/1234" removes "/channels/1234" and "/channels/1234/pins"
+             */
+            void Invalidate(const std::string &Path);
+
+            /**
+             * @brief Removes all entries which are affected by a write to the path. These are the path, all sub paths and all parent paths.
+             */
+            void InvalidateWrite(const std::string &Path);
+
+            void Clear();
+
+            ~CRESTCache() {}
+
+        private:
+            static const size_t MAX_ENTRIES = 4096;
+
+            struct SEntry
+            {
+                ix::HttpResponsePtr Res;
+                int64_t Expires;
+            };
+
+            void EraseExact(const std::string &Path);
+            void RemoveExpired(int64_t Now);
+
+            /**
+             * @brief Remembers the invalidation of a path for the read throughs which are in flight.
+             */
+            void AddInvalidation(const std::string &Path);
+
+            /**
+             * @return Returns true if the url or one of its parents was invalidated after the generation.
+             */
+            bool IsInvalidated(const std::string &URL, uint64_t Generation);
+
+            std::mutex m_Lock;
+            std::map<std::string, uint32_t> m_TTLs;
+            std::map<std::string, SEntry> m_Entries;   //!< Sorted by url, so all sub paths follow their parent.
+
+            uint64_t m_Generation;
+            std::multiset<uint64_t> m_InFlight;             //!< Generations of the running read throughs.
+            std::map<std::string, uint64_t> m_Invalidated;  //!< Path -> Generation of the last invalidation. Only kept while read throughs are in flight.
+    };
+} // namespace DiscordBot
+
+
+#endif //RESTCACHE_HPP
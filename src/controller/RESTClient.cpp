@@ -0,0 +1,554 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RESTClient.hpp"
+#include <sodium.h>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <zlib.h>
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    namespace
+    {
+        bool IsGood(ix::HttpResponsePtr res)
+        {
+            return res && res->errorCode == ix::HttpErrorCode::Ok && res->statusCode < 500;
+        }
+    } // namespace
+
+    CRESTClient::CRESTClient(const std::string &BaseURL, const std::string &UserAgent) : m_BaseURL(BaseURL), m_UserAgent(UserAgent), m_PassThrough(false), m_Terminate(false)
+    {
+        //Disable client side checking.
+        ix::SocketTLSOptions DisabledTrust;
+        DisabledTrust.caFile = "NONE";
+
+        m_Pool = std::make_shared<CHTTPClientPool>(DisabledTrust);
+        m_Scheduler = std::make_shared<CRequestScheduler>();
+    }
+
+    CRESTClient::~CRESTClient()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_HedgeLock);
+            m_Terminate = true;
+            m_HedgeCond.notify_all();
+        }
+
+        if(m_HedgeThread.joinable())
+            m_HedgeThread.join();
+    }
+
+    const char *CRESTClient::PRIORITY_HEADER = "X-DiscordBot-Priority";
+
+    void CRESTClient::SetBaseURL(const std::string &BaseURL)
+    {
+        std::lock_guard<std::mutex> lock(m_ConfigLock);
+        m_BaseURL = BaseURL;
+        m_PassThrough = true;
+    }
+
+    std::string CRESTClient::GetBaseURL()
+    {
+        std::lock_guard<std::mutex> lock(m_ConfigLock);
+        return m_BaseURL;
+    }
+
+    void CRESTClient::SetRetryPolicy(const SRetryPolicy &Policy)
+    {
+        std::lock_guard<std::mutex> lock(m_ConfigLock);
+        m_Policy = Policy;
+    }
+
+    SRetryPolicy CRESTClient::GetRetryPolicy()
+    {
+        std::lock_guard<std::mutex> lock(m_ConfigLock);
+        return m_Policy;
+    }
+
+    ix::HttpResponsePtr CRESTClient::Request(const std::string &Method, const std::string &URL, const std::string &Body, const std::string &ContentType, RequestPriority Priority, const ix::WebSocketHttpHeaders &Headers)
+    {
+        SRetryPolicy Policy;
+        std::string BaseURL;
+        bool PassThrough;
+
+        {
+            std::lock_guard<std::mutex> lock(m_ConfigLock);
+            Policy = m_Policy;
+            BaseURL = m_BaseURL;
+            PassThrough = m_PassThrough;
+        }
+
+        std::string Route = GetRoute(Method, URL);
+        Priority = CRequestScheduler::ResolvePriority(Priority);
+
+        //Statistics are kept per route template, so they don't grow with every channel and guild.
+        std::string Template, Major;
+        CRequestScheduler::SplitMajor(Route, Template, Major);
+
+        //The proxy owns the rate limits, retries and hedging.
+        if(PassThrough)
+        {
+            auto res = Execute(Method, BaseURL + URL, Body, CreateArgs(Method, Body, ContentType, Priority, Headers, 0));
+            DecodeBody(Template, res);
+
+            return res;
+        }
+
+        int64_t Beg = GetTimeMillis();
+        int64_t Deadline = Policy.Deadline != 0 ? Beg + Policy.Deadline : 0;
+
+        ix::HttpResponsePtr res;
+        for (uint32_t Attempt = 0; ; Attempt++)
+        {
+            auto Ticket = m_Scheduler->Acquire(Route, Priority, Deadline);
+            if(!Ticket)
+            {
+                res = ix::HttpResponsePtr(new ix::HttpResponse(429, "Too Many Requests", ix::HttpErrorCode::Ok, ix::WebSocketHttpHeaders(), "", "Rate limit exceeds the deadline"));
+                break;
+            }
+
+            int64_t Start = GetTimeMillis();
+            auto args = CreateArgs(Method, Body, ContentType, Priority, Headers, Deadline != 0 ? Deadline - Start : 0);
+
+            int64_t HedgeAfter = -1;
+            if(Method == "GET" && Policy.HedgeGETs)
+                HedgeAfter = GetLatencyPercentile(Template, Policy);
+
+            if(HedgeAfter >= 0)
+            {
+                auto MakeArgs = [this, &Method, &Body, &ContentType, Priority, &Headers, Deadline]()
+                {
+                    return CreateArgs(Method, Body, ContentType, Priority, Headers, Deadline != 0 ? std::max<int64_t>(Deadline - GetTimeMillis(), 1) : 0);
+                };
+
+                res = ExecuteHedged(Method, BaseURL + URL, Body, args, MakeArgs, HedgeAfter, Ticket);
+            }
+            else
+            {
+                res = Execute(Method, BaseURL + URL, Body, args);
+                m_Scheduler->Release(Ticket, res);
+            }
+
+            DecodeBody(Template, res);
+
+            if(res->errorCode == ix::HttpErrorCode::Ok && res->statusCode < 500)
+                AddLatency(Template, (uint32_t)(GetTimeMillis() - Start));
+
+            if(Attempt >= Policy.MaxRetries || !IsRetryable(Method, res))
+                break;
+
+            //The scheduler already holds back requests until the rate limit resets.
+            uint32_t Delay = res->statusCode == 429 ? 0 : GetBackoff(Policy, Attempt, res);
+            if(Deadline != 0 && GetTimeMillis() + Delay >= Deadline)
+                break;
+
+            if(Delay != 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(Delay));
+        }
+
+        return res;
+    }
+
+    SRESTStatistics CRESTClient::GetStatistics()
+    {
+        SRESTStatistics Ret = m_Scheduler->GetStatistics();
+
+        std::lock_guard<std::mutex> lock(m_TrafficLock);
+        Ret.Routes = m_Traffic;
+
+        return Ret;
+    }
+
+    std::string CRESTClient::GetRoute(const std::string &Method, const std::string &URL)
+    {
+        std::string Route = Method + " ";
+        std::string Path = URL.substr(0, URL.find('?'));
+
+        size_t Segment = 0;
+        size_t Beg = 0;
+        std::string Prev;
+        while (Beg < Path.size())
+        {
+            size_t End = Path.find('/', Beg + 1);
+            std::string Part = Path.substr(Beg + 1, End == std::string::npos ? std::string::npos : End - Beg - 1);
+
+            bool IsID = !Part.empty() && std::all_of(Part.begin(), Part.end(), ::isdigit);
+            bool IsMajor = Segment == 1 && (Prev == "channels" || Prev == "guilds" || Prev == "webhooks");
+
+            //Webhook tokens are part of the major parameter.
+            bool IsToken = Segment == 2 && Route.compare(Method.size() + 1, 10, "/webhooks/") == 0;
+
+            //Emojis and invite codes are parameters too, otherwise every one would get its own route.
+            bool IsKey = Segment >= 1 && (Prev == "reactions" || Prev == "invites");
+
+            if(IsToken)
+                Route += "/:token";
+            else if(IsKey && !IsMajor)
+                Route += "/:key";
+            else
+                Route += "/" + (IsID && !IsMajor ? std::string(":id") : Part);
+
+            Prev = Part;
+            Segment++;
+
+            if(End == std::string::npos)
+                break;
+
+            Beg = End;
+        }
+
+        return Route;
+    }
+
+    //--------------------------Private--------------------------//
+
+    ix::HttpRequestArgsPtr CRESTClient::CreateArgs(const std::string &Method, const std::string &Body, const std::string &ContentType, RequestPriority Priority, const ix::WebSocketHttpHeaders &Headers, int64_t Remaining)
+    {
+        static const char *PRIORITIES[] = { "interactive", "normal", "background" };
+
+        ix::HttpRequestArgsPtr args = ix::HttpRequestArgsPtr(new ix::HttpRequestArgs());
+        args->extraHeaders = Headers;
+
+        //Adds the bot token.
+        if(!m_Authorization.empty())
+            args->extraHeaders["Authorization"] = m_Authorization;
+
+        args->extraHeaders["User-Agent"] = m_UserAgent;
+        args->extraHeaders[PRIORITY_HEADER] = PRIORITIES[(size_t)Priority];
+
+        //IXWebSocket gunzips bodies itself, deflate bodies are decompressed by DecodeBody with a reused buffer.
+        args->compress = false;
+        args->extraHeaders["Accept-Encoding"] = "gzip, deflate";
+
+        if(!Body.empty() || Method == "POST" || Method == "PUT" || Method == "PATCH")
+            args->extraHeaders["Content-Type"] = ContentType;
+
+        //Limits the attempt to the remaining time of the deadline.
+        if(Remaining > 0)
+        {
+            int Seconds = (int)((Remaining + 999) / 1000);
+            args->connectTimeout = std::min(args->connectTimeout, Seconds);
+            args->transferTimeout = std::min(args->transferTimeout, Seconds);
+        }
+
+        return args;
+    }
+
+    ix::HttpResponsePtr CRESTClient::Execute(const std::string &Method, const std::string &URL, const std::string &Body, ix::HttpRequestArgsPtr args)
+    {
+        return m_Pool->Acquire()->request(URL, Method, Body, args);
+    }
+
+    ix::HttpResponsePtr CRESTClient::ExecuteHedged(const std::string &Method, const std::string &URL, const std::string &Body, ix::HttpRequestArgsPtr args, const std::function<ix::HttpRequestArgsPtr()> &MakeArgs, int64_t HedgeAfter, CRequestScheduler::Ticket Primary)
+    {
+        auto H = std::make_shared<SHedge>();
+        H->Method = Method;
+        H->URL = URL;
+        H->Body = Body;
+        H->Route = Primary->Route;
+        H->Priority = Primary->Priority;
+        H->PrimaryArgs = args;
+        H->MakeArgs = MakeArgs;
+
+        std::multimap<int64_t, Hedge>::iterator Entry;
+        {
+            std::lock_guard<std::mutex> lock(m_HedgeLock);
+            if(!m_HedgeThread.joinable())
+                m_HedgeThread = std::thread(&CRESTClient::HedgeTimer, this);
+
+            Entry = m_Hedges.emplace(GetTimeMillis() + HedgeAfter, H);
+            if(Entry == m_Hedges.begin())
+                m_HedgeCond.notify_one();
+        }
+
+        auto res = Execute(Method, URL, Body, args);
+        m_Scheduler->Release(Primary, res);
+
+        {
+            std::lock_guard<std::mutex> lock(m_HedgeLock);
+            if(H->Queued)
+            {
+                H->Queued = false;
+                m_Hedges.erase(Entry);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(H->Lock);
+        H->PrimaryDone = true;
+
+        //A cancelled or failed request waits for the hedge, if one is in flight.
+        if(!IsGood(res))
+            H->Cond.wait(lock, [&H]() { return !H->Launched || H->HedgeDone; });
+
+        if(IsGood(H->Res))
+            return H->Res;
+
+        return res;
+    }
+
+    void CRESTClient::HedgeTimer()
+    {
+        std::unique_lock<std::mutex> lock(m_HedgeLock);
+        while (!m_Terminate)
+        {
+            if(m_Hedges.empty())
+            {
+                m_HedgeCond.wait(lock);
+                continue;
+            }
+
+            auto IT = m_Hedges.begin();
+            int64_t Now = GetTimeMillis();
+            if(IT->first > Now)
+            {
+                m_HedgeCond.wait_for(lock, std::chrono::milliseconds(IT->first - Now));
+                continue;
+            }
+
+            Hedge H = IT->second;
+            H->Queued = false;
+            m_Hedges.erase(IT);
+
+            lock.unlock();
+            LaunchHedge(H);
+            lock.lock();
+        }
+    }
+
+    void CRESTClient::LaunchHedge(Hedge H)
+    {
+        std::lock_guard<std::mutex> lock(H->Lock);
+        if(H->PrimaryDone)
+            return;
+
+        auto T = m_Scheduler->TryAcquire(H->Route, H->Priority);
+        if(!T)
+            return;
+
+        H->Launched = true;
+        auto args = H->MakeArgs();
+        auto Pool = m_Pool;
+        auto Scheduler = m_Scheduler;
+
+        //The thread is detached, so a slow hedge never blocks the caller.
+        std::thread([H, Pool, Scheduler, T, args]()
+        {
+            auto res = Pool->Acquire()->request(H->URL, H->Method, H->Body, args);
+            Scheduler->Release(T, res);
+
+            std::lock_guard<std::mutex> lock(H->Lock);
+            H->HedgeDone = true;
+            if(IsGood(res))
+            {
+                H->Res = res;
+                H->PrimaryArgs->cancel = true;
+            }
+
+            H->Cond.notify_all();
+        }).detach();
+    }
+
+    void CRESTClient::DecodeBody(const std::string &Template, ix::HttpResponsePtr res)
+    {
+        //Each thread keeps its buffer, so large responses don't allocate a new one every time.
+        thread_local std::string Buffer;
+
+        uint64_t WireBytes = res->body.size();
+        bool Compressed = false;
+
+        auto IT = res->headers.find("Content-Encoding");
+        if(IT != res->headers.end() && (IT->second == "gzip" || IT->second == "deflate") && !res->body.empty())
+        {
+            Compressed = true;
+
+            //IXWebSocket already gunzips the body and keeps the header, only bodies which still have a gzip or zlib header are inflated.
+            //"deflate" is never decoded by IXWebSocket and may be sent as raw deflate stream without the zlib header.
+            int WindowBits = 0;
+            if(HasZlibHeader(res->body))
+                WindowBits = 15 + 32;   //Detects the gzip or zlib header automatically.
+            else if(IT->second == "deflate")
+                WindowBits = -15;
+
+            if(WindowBits != 0)
+            {
+                if(Buffer.size() < res->body.size() * 4)
+                    Buffer.resize(res->body.size() * 4);
+
+                size_t Size = 0;
+                int Ret = Inflate(res->body, Buffer, WindowBits, Size);
+                if(Ret != Z_STREAM_END)
+                {
+                    //Callers only check the status code, so the undecodable body must not look like a successful response.
+                    res->statusCode = 0;
+                    res->errorCode = ix::HttpErrorCode::Gzip;
+                    res->errorMsg = Ret == Z_MEM_ERROR ? "Failed to initialize zlib" : "Failed to decompress the response body";
+                    res->body = res->errorMsg;
+                    return;
+                }
+
+                res->body.assign(Buffer.data(), Size);
+            }
+
+            res->headers.erase(IT);
+        }
+
+        std::lock_guard<std::mutex> lock(m_TrafficLock);
+        STrafficStatistics &Traffic = m_Traffic[Template];
+        Traffic.Responses++;
+        Traffic.WireBytes += WireBytes;
+        Traffic.DecodedBytes += res->body.size();
+
+        if(Compressed)
+            Traffic.Compressed++;
+    }
+
+    bool CRESTClient::HasZlibHeader(const std::string &Body)
+    {
+        if(Body.size() < 2)
+            return false;
+
+        uint8_t First = (uint8_t)Body[0];
+        uint8_t Second = (uint8_t)Body[1];
+
+        //Gzip magic bytes.
+        if(First == 0x1F && Second == 0x8B)
+            return true;
+
+        //Zlib header: deflate method and a check sum, which is a multiple of 31.
+        return (First & 0x0F) == 8 && ((First << 8) | Second) % 31 == 0;
+    }
+
+    int CRESTClient::Inflate(const std::string &In, std::string &Buffer, int WindowBits, size_t &Size)
+    {
+        z_stream Stream = {};
+        if(inflateInit2(&Stream, WindowBits) != Z_OK)
+            return Z_MEM_ERROR;
+
+        Stream.next_in = (Bytef*)In.data();
+        Stream.avail_in = (uInt)In.size();
+
+        int Ret = Z_OK;
+        Size = 0;
+        while (Ret == Z_OK)
+        {
+            if(Size == Buffer.size())
+                Buffer.resize(Buffer.size() * 2);
+
+            Stream.next_out = (Bytef*)&Buffer[Size];
+            Stream.avail_out = (uInt)(Buffer.size() - Size);
+
+            Ret = inflate(&Stream, Z_NO_FLUSH);
+            Size = Buffer.size() - Stream.avail_out;
+
+            //No progress without more input means the body is truncated.
+            if(Ret == Z_BUF_ERROR && Stream.avail_out != 0)
+                break;
+            else if(Ret == Z_BUF_ERROR)
+                Ret = Z_OK;
+        }
+
+        inflateEnd(&Stream);
+        return Ret;
+    }
+
+    bool CRESTClient::IsRetryable(const std::string &Method, ix::HttpResponsePtr res)
+    {
+        //Rate limited requests are never processed by discord.
+        if(res->statusCode == 429)
+            return true;
+
+        //POST isn't idempotent, so it is only repeated if discord never processed the request.
+        if(Method == "POST")
+        {
+            return res->errorCode == ix::HttpErrorCode::CannotConnect || 
+                   res->errorCode == ix::HttpErrorCode::CannotCreateSocket ||
+                   res->statusCode == 502 || res->statusCode == 503 || res->statusCode == 504;
+        }
+
+        //A body which can't be decoded won't be different the next time.
+        if(res->errorCode == ix::HttpErrorCode::Gzip || res->errorCode == ix::HttpErrorCode::UrlMalformed)
+            return false;
+
+        return res->errorCode != ix::HttpErrorCode::Ok || res->statusCode >= 500;
+    }
+
+    uint32_t CRESTClient::GetBackoff(const SRetryPolicy &Policy, uint32_t Attempt, ix::HttpResponsePtr res)
+    {
+        uint64_t Cap = std::min<uint64_t>(Policy.MaxDelay, (uint64_t)Policy.BaseDelay << std::min<uint32_t>(Attempt, 16));
+
+        //Equal jitter, so the retry doesn't hit the same instant as other clients.
+        uint32_t Half = (uint32_t)(Cap / 2);
+        uint32_t Delay = Half + randombytes_uniform(Half + 1);
+
+        auto IT = res->headers.find("Retry-After");
+        if(IT != res->headers.end())
+        {
+            try
+            {
+                Delay = std::max<uint32_t>(Delay, (uint32_t)(std::stod(IT->second) * 1000));
+            }
+            catch(const std::exception &)
+            {
+            }
+        }
+
+        return Delay;
+    }
+
+    void CRESTClient::AddLatency(const std::string &Route, uint32_t Latency)
+    {
+        std::lock_guard<std::mutex> lock(m_LatencyLock);
+        SLatencyWindow &Window = m_Latencies[Route];
+
+        if(Window.Samples.size() < LATENCY_SAMPLES)
+            Window.Samples.push_back(Latency);
+        else
+        {
+            Window.Samples[Window.Pos] = Latency;
+            Window.Pos = (Window.Pos + 1) % LATENCY_SAMPLES;
+        }
+    }
+
+    int64_t CRESTClient::GetLatencyPercentile(const std::string &Route, const SRetryPolicy &Policy)
+    {
+        std::vector<uint32_t> Samples;
+
+        {
+            std::lock_guard<std::mutex> lock(m_LatencyLock);
+            auto IT = m_Latencies.find(Route);
+            if(IT == m_Latencies.end() || IT->second.Samples.size() < std::max<uint32_t>(Policy.MinHedgeSamples, 1))
+                return -1;
+
+            Samples = IT->second.Samples;
+        }
+
+        size_t Index = std::min<size_t>(Samples.size() - 1, Samples.size() * std::min<uint32_t>(Policy.HedgePercentile, 100) / 100);
+        std::nth_element(Samples.begin(), Samples.begin() + Index, Samples.end());
+
+        return Samples[Index];
+    }
+} // namespace DiscordBot
@@ -0,0 +1,211 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RESTCLIENT_HPP
+#define RESTCLIENT_HPP
+
+#include <ixwebsocket/IXHttpClient.h>
+#include <models/RetryPolicy.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include "HTTPClientPool.hpp"
+#include "RequestScheduler.hpp"
+
+namespace DiscordBot
+{
+    /**
+     * @brief Executes REST requests against a base url. Handles rate limits, retries and hedging of requests.
+     */
+    class CRESTClient
+    {
+        public:
+            /**
+             * @param BaseURL: Url which is prepended to all requests.
+             * @param UserAgent: User agent header of all requests.
+             */
+            CRESTClient(const std::string &BaseURL, const std::string &UserAgent);
+
+            /**
+             * @brief Sets the authorization header of all requests. E.g. "Bot TOKEN"
+             */
+            inline void SetAuthorization(const std::string &Authorization)
+            {
+                m_Authorization = Authorization;
+            }
+
+            /**
+             * @brief Changes the url which is prepended to all requests. E.g. the url of a IRESTProxy.
+             * Switches the client into pass through mode. Every request is sent once without the scheduler, retries or hedging, since the proxy handles these.
+             */
+            void SetBaseURL(const std::string &BaseURL);
+            std::string GetBaseURL();
+
+            void SetRetryPolicy(const SRetryPolicy &Policy);
+            SRetryPolicy GetRetryPolicy();
+
+            /**
+             * @brief Executes a request. Waits for the rate limit and retries the request on network errors, 429 and 5xx responses.
+             * 
+             * @param Method: Http method. E.g. "GET"
+             * @param URL: Url relative to the base url.
+             * @param Body: Request body.
+             * @param ContentType: Content type of the body. Only used if the body is not empty or the method is POST, PUT or PATCH.
+             * @param Priority: Priority class of the request. Overridden by an active CRequestPriorityScope.
+             * @param Headers: Additional headers. E.g. "X-Audit-Log-Reason"
+             */
+            ix::HttpResponsePtr Request(const std::string &Method, const std::string &URL, const std::string &Body = "", const std::string &ContentType = "application/json", RequestPriority Priority = RequestPriority::NORMAL, const ix::WebSocketHttpHeaders &Headers = ix::WebSocketHttpHeaders());
+
+            /**
+             * @brief Header which tells a IRESTProxy the priority class of a request.
+             */
+            static const char *PRIORITY_HEADER;
+
+            SRESTStatistics GetStatistics();
+
+            /**
+             * @return Returns the route of a request. Major parameters (channel, guild and webhook id) are kept, all other ids are replaced by ":id", emojis and invite codes by ":key". E.g. "GET /guilds/1234/members/:id"
+             */
+            static std::string GetRoute(const std::string &Method, const std::string &URL);
+
+            ~CRESTClient();
+
+        private:
+            static const size_t LATENCY_SAMPLES = 128;    //!< Latency samples per route.
+
+            struct SHedge
+            {
+                SHedge() : Queued(true), PrimaryDone(false), Launched(false), HedgeDone(false) {}
+
+                std::mutex Lock;
+                std::condition_variable Cond;
+
+                std::string Method;
+                std::string URL;
+                std::string Body;
+                std::string Route;
+                RequestPriority Priority;
+                ix::HttpRequestArgsPtr PrimaryArgs;
+                std::function<ix::HttpRequestArgsPtr()> MakeArgs;
+
+                ix::HttpResponsePtr Res;    //!< Response of the hedge.
+                bool Queued;                //!< Protected by m_HedgeLock.
+                bool PrimaryDone;
+                bool Launched;
+                bool HedgeDone;
+            };
+
+            using Hedge = std::shared_ptr<SHedge>;
+
+            struct SLatencyWindow
+            {
+                SLatencyWindow() : Pos(0) {}
+
+                std::vector<uint32_t> Samples;
+                size_t Pos;
+            };
+
+            ix::HttpRequestArgsPtr CreateArgs(const std::string &Method, const std::string &Body, const std::string &ContentType, RequestPriority Priority, const ix::WebSocketHttpHeaders &Headers, int64_t Remaining);
+            ix::HttpResponsePtr Execute(const std::string &Method, const std::string &URL, const std::string &Body, ix::HttpRequestArgsPtr args);
+
+            /**
+             * @brief Executes the request on the calling thread and sends a second one, if the first one doesn't answer within HedgeAfter milliseconds. Returns the first successful response.
+             * The second request is only sent, if the rate limit bucket has budget left. A successful hedge cancels the first request.
+             * 
+             * @param MakeArgs: Creates the arguments of the hedge.
+             */
+            ix::HttpResponsePtr ExecuteHedged(const std::string &Method, const std::string &URL, const std::string &Body, ix::HttpRequestArgsPtr args, const std::function<ix::HttpRequestArgsPtr()> &MakeArgs, int64_t HedgeAfter, CRequestScheduler::Ticket Primary);
+
+            /**
+             * @brief Timer thread which launches the due hedges. Only a launched hedge gets its own thread.
+             */
+            void HedgeTimer();
+
+            /**
+             * @brief Sends the hedge on a separate thread.
+             */
+            void LaunchHedge(Hedge H);
+
+            /**
+             * @brief Decompresses a gzip or deflate encoded body and counts the transferred bytes of the route template.
+             * If the body can't be decoded, the response gets the status code 0 and the error code Gzip.
+             */
+            void DecodeBody(const std::string &Template, ix::HttpResponsePtr res);
+
+            /**
+             * @return Returns true if the body starts with a gzip or zlib header.
+             */
+            static bool HasZlibHeader(const std::string &Body);
+
+            /**
+             * @brief Inflates In into Buffer, which grows if needed.
+             * 
+             * @param WindowBits: Passed to inflateInit2. E.g. 15 + 32 for gzip and zlib or -15 for raw deflate.
+             * @param Size: Receives the decompressed size.
+             * 
+             * @return Returns Z_STREAM_END on success, otherwise the zlib error.
+             */
+            static int Inflate(const std::string &In, std::string &Buffer, int WindowBits, size_t &Size);
+
+            bool IsRetryable(const std::string &Method, ix::HttpResponsePtr res);
+            uint32_t GetBackoff(const SRetryPolicy &Policy, uint32_t Attempt, ix::HttpResponsePtr res);
+
+            void AddLatency(const std::string &Route, uint32_t Latency);
+
+            /**
+             * @return Gets the latency percentile of a route or -1 if there are not enough samples.
+             */
+            int64_t GetLatencyPercentile(const std::string &Route, const SRetryPolicy &Policy);
+
+            std::string m_BaseURL;
+            std::string m_UserAgent;
+            std::string m_Authorization;
+            std::shared_ptr<CHTTPClientPool> m_Pool;
+            std::shared_ptr<CRequestScheduler> m_Scheduler;
+
+            std::mutex m_ConfigLock;
+            SRetryPolicy m_Policy;
+            bool m_PassThrough;
+
+            std::mutex m_LatencyLock;
+            std::map<std::string, SLatencyWindow> m_Latencies;     //!< Route template -> Latencies
+
+            std::mutex m_TrafficLock;
+            std::map<std::string, STrafficStatistics> m_Traffic;   //!< Route template -> Traffic
+
+            std::mutex m_HedgeLock;
+            std::condition_variable m_HedgeCond;
+            std::multimap<int64_t, Hedge> m_Hedges;     //!< Due time -> Pending hedge.
+            std::thread m_HedgeThread;
+            bool m_Terminate;
+    };
+} // namespace DiscordBot
+
+
+#endif //RESTCLIENT_HPP
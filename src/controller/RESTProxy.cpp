@@ -0,0 +1,193 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RESTProxy.hpp"
+#include <ixwebsocket/IXNetSystem.h>
+#include <JSON.hpp>
+#include <Log.hpp>
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    RESTProxy IRESTProxy::Create(const std::string &Token, int Port, const std::string &Host)
+    {
+        //Needed for windows.
+        ix::initNetSystem();
+
+        return RESTProxy(new CRESTProxy(Token, Port, Host));
+    }
+
+    CRESTProxy::CRESTProxy(const std::string &Token, int Port, const std::string &Host) : m_Running(false), m_StartTime(0), m_Requests(0), m_Failed(0), m_InFlight(0), m_BytesIn(0), m_BytesOut(0)
+    {
+        m_REST = std::make_shared<CRESTClient>(BASE_URL, std::string("libDiscordBot (https://github.com/tostc/libDiscordBot, ") + VERSION + ")");
+        m_REST->SetAuthorization("Bot " + Token);
+
+        m_Server = std::unique_ptr<ix::HttpServer>(new ix::HttpServer(Port, Host));
+        m_Server->setOnConnectionCallback([this](ix::HttpRequestPtr req, std::shared_ptr<ix::ConnectionState>)
+        {
+            return OnRequest(req);
+        });
+    }
+
+    bool CRESTProxy::Start()
+    {
+        if(m_Running)
+            return true;
+
+        auto res = m_Server->listen();
+        if(!res.first)
+        {
+            llog << lerror << "Failed to start the REST proxy: " << res.second << lendl;
+            return false;
+        }
+
+        m_StartTime = GetTimeMillis();
+        m_Server->start();
+        m_Running = true;
+
+        return true;
+    }
+
+    void CRESTProxy::Stop()
+    {
+        if(!m_Running)
+            return;
+
+        m_Server->stop();
+        m_Running = false;
+    }
+
+    SProxyStatistics CRESTProxy::GetProxyStatistics()
+    {
+        SProxyStatistics Ret;
+        Ret.Requests = m_Requests;
+        Ret.Failed = m_Failed;
+        Ret.InFlight = m_InFlight;
+        Ret.BytesIn = m_BytesIn;
+        Ret.BytesOut = m_BytesOut;
+        Ret.Uptime = m_Running ? (uint64_t)(GetTimeMillis() - m_StartTime) : 0;
+
+        return Ret;
+    }
+
+    CRESTProxy::~CRESTProxy()
+    {
+        Stop();
+    }
+
+    //--------------------------Private--------------------------//
+
+    ix::HttpResponsePtr CRESTProxy::OnRequest(ix::HttpRequestPtr req)
+    {
+        ix::WebSocketHttpHeaders Headers;
+
+        if(req->method == "GET" && req->uri == "/stats")
+        {
+            Headers["Content-Type"] = "application/json";
+            return ix::HttpResponsePtr(new ix::HttpResponse(200, "OK", ix::HttpErrorCode::Ok, Headers, SerializeStatistics()));
+        }
+
+        RequestPriority Priority = RequestPriority::NORMAL;
+        auto IT = req->headers.find(CRESTClient::PRIORITY_HEADER);
+        if(IT != req->headers.end())
+        {
+            if(IT->second == "interactive")
+                Priority = RequestPriority::INTERACTIVE;
+            else if(IT->second == "background")
+                Priority = RequestPriority::BACKGROUND;
+        }
+
+        std::string ContentType = "application/json";
+        IT = req->headers.find("Content-Type");
+        if(IT != req->headers.end())
+            ContentType = IT->second;
+
+        //Audit log reasons are the only client headers discord needs. The authorization is always the one of the proxy.
+        IT = req->headers.find("X-Audit-Log-Reason");
+        if(IT != req->headers.end())
+            Headers[IT->first] = IT->second;
+
+        m_InFlight++;
+        m_BytesIn += req->body.size();
+
+        auto res = m_REST->Request(req->method, req->uri, req->body, ContentType, Priority, Headers);
+
+        m_InFlight--;
+        m_Requests++;
+
+        if(res->errorCode != ix::HttpErrorCode::Ok)
+        {
+            m_Failed++;
+            llog << lerror << "REST proxy failed to forward " << req->method << " " << req->uri << " MSG: " << res->errorMsg << lendl;
+
+            return ix::HttpResponsePtr(new ix::HttpResponse(502, "Bad Gateway", ix::HttpErrorCode::Ok, ix::WebSocketHttpHeaders(), res->errorMsg));
+        }
+
+        //The body is already decompressed and the server sets its own transfer headers.
+        ix::WebSocketHttpHeaders ResHeaders = res->headers;
+        ResHeaders.erase("Content-Length");
+        ResHeaders.erase("Content-Encoding");
+        ResHeaders.erase("Transfer-Encoding");
+        ResHeaders.erase("Connection");
+
+        m_BytesOut += res->body.size();
+        return ix::HttpResponsePtr(new ix::HttpResponse(res->statusCode, res->description, ix::HttpErrorCode::Ok, ResHeaders, res->body));
+    }
+
+    std::string CRESTProxy::SerializeStatistics()
+    {
+        static const char *PRIORITIES[] = { "interactive", "normal", "background" };
+
+        SProxyStatistics Proxy = GetProxyStatistics();
+        SRESTStatistics REST = GetStatistics();
+
+        CJSON json;
+        json.AddPair("requests", Proxy.Requests);
+        json.AddPair("failed", Proxy.Failed);
+        json.AddPair("in_flight", Proxy.InFlight);
+        json.AddPair("bytes_in", Proxy.BytesIn);
+        json.AddPair("bytes_out", Proxy.BytesOut);
+        json.AddPair("uptime", Proxy.Uptime);
+        json.AddPair("requests_per_second", Proxy.Uptime != 0 ? Proxy.Requests * 1000.0 / Proxy.Uptime : 0.0);
+
+        CJSON Priorities;
+        for (size_t i = 0; i < (size_t)RequestPriority::COUNT; i++)
+        {
+            const SPriorityStatistics &Stats = REST.Priorities[i];
+
+            CJSON Class;
+            Class.AddPair("requests", Stats.Requests);
+            Class.AddPair("queued", Stats.Queued);
+            Class.AddPair("avg_wait", Stats.Requests != 0 ? Stats.TotalWait / Stats.Requests : 0);
+            Class.AddPair("max_wait", Stats.MaxWait);
+            Class.AddPair("avg_latency", Stats.Requests != 0 ? Stats.TotalLatency / Stats.Requests : 0);
+            Class.AddPair("max_latency", Stats.MaxLatency);
+
+            Priorities.AddJSON(PRIORITIES[i], Class.Serialize());
+        }
+
+        json.AddJSON("priorities", Priorities.Serialize());
+        return json.Serialize();
+    }
+} // namespace DiscordBot
@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RESTPROXY_HPP
+#define RESTPROXY_HPP
+
+#include <controller/IRESTProxy.hpp>
+#include <ixwebsocket/IXHttpServer.h>
+#include <atomic>
+#include <memory>
+#include "RESTClient.hpp"
+
+namespace DiscordBot
+{
+    class CRESTProxy : public IRESTProxy
+    {
+        public:
+            CRESTProxy(const std::string &Token, int Port, const std::string &Host);
+
+            bool Start() override;
+            void Stop() override;
+
+            SRESTStatistics GetStatistics() override
+            {
+                return m_REST->GetStatistics();
+            }
+
+            SProxyStatistics GetProxyStatistics() override;
+
+            ~CRESTProxy();
+
+        private:
+            ix::HttpResponsePtr OnRequest(ix::HttpRequestPtr req);
+
+            /**
+             * @return Returns the statistics as json.
+             */
+            std::string SerializeStatistics();
+
+            const char *BASE_URL = "https://discord.com/api";
+
+            std::shared_ptr<CRESTClient> m_REST;
+            std::unique_ptr<ix::HttpServer> m_Server;
+            bool m_Running;
+
+            int64_t m_StartTime;
+            std::atomic<uint64_t> m_Requests;
+            std::atomic<uint64_t> m_Failed;
+            std::atomic<uint64_t> m_InFlight;
+            std::atomic<uint64_t> m_BytesIn;
+            std::atomic<uint64_t> m_BytesOut;
+    };
+} // namespace DiscordBot
+
+
+#endif //RESTPROXY_HPP
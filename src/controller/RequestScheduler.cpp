@@ -0,0 +1,389 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RequestScheduler.hpp"
+#include <algorithm>
+#include "../helpers/Helper.hpp"
+
+namespace DiscordBot
+{
+    namespace
+    {
+        thread_local int CurrentPriority = -1;
+
+        bool GetHeader(ix::HttpResponsePtr res, const std::string &Name, double &Value)
+        {
+            auto IT = res->headers.find(Name);
+            if(IT == res->headers.end())
+                return false;
+
+            try
+            {
+                Value = std::stod(IT->second);
+                return true;
+            }
+            catch(const std::exception &)
+            {
+                return false;
+            }
+        }
+    }
+
+    CRequestPriorityScope::CRequestPriorityScope(RequestPriority Priority) : m_Prev(CurrentPriority)
+    {
+        CurrentPriority = (int)Priority;
+    }
+
+    CRequestPriorityScope::~CRequestPriorityScope()
+    {
+        CurrentPriority = m_Prev;
+    }
+
+    void CRequestScheduler::SplitMajor(const std::string &Route, std::string &Template, std::string &Major)
+    {
+        Template = Route;
+        Major.clear();
+
+        static const char *MAJORS[] = { "/channels/", "/guilds/", "/webhooks/" };
+
+        size_t Path = Route.find(' ');
+        if(Path == std::string::npos)
+            return;
+
+        for (auto &&m : MAJORS)
+        {
+            std::string Prefix = m;
+            if(Route.compare(Path + 1, Prefix.size(), Prefix) != 0)
+                continue;
+
+            size_t Beg = Path + 1 + Prefix.size();
+            size_t End = Route.find('/', Beg);
+            Major = Route.substr(Beg, End == std::string::npos ? std::string::npos : End - Beg);
+            Template = Route.substr(0, Beg) + ":major" + (End == std::string::npos ? "" : Route.substr(End));
+            break;
+        }
+    }
+
+    RequestPriority CRequestScheduler::ResolvePriority(RequestPriority Default)
+    {
+        return CurrentPriority >= 0 ? (RequestPriority)CurrentPriority : Default;
+    }
+
+    CRequestScheduler::Ticket CRequestScheduler::Acquire(const std::string &Route, RequestPriority Priority, int64_t Deadline)
+    {
+        std::unique_lock<std::mutex> lock(m_Lock);
+
+        Ticket T = Ticket(new STicket());
+        T->Route = Route;
+        T->Priority = Priority;
+        T->Queued = GetTimeMillis();
+        T->Bucket = GetBucketKey(Route, T->Queued);
+
+        SBucket &Bucket = m_Buckets[T->Bucket];
+        Bucket.Queues[(size_t)Priority].push_back(T);
+        m_Stats.Priorities[(size_t)Priority].Queued++;
+
+        while (true)
+        {
+            int64_t Now = GetTimeMillis();
+            int64_t GlobalFree = 0;
+            bool Global = Now >= m_GlobalReset && HasGlobalCapacity(Now, GlobalFree);
+            bool Ready = Global && HasCapacity(Bucket, Now);
+
+            if(Ready && PickNext(Bucket, Now) == T)
+            {
+                Grant(Bucket, T, Now);
+
+                //Wakes the next request of the bucket, if there is still budget left.
+                m_Cond.notify_all();
+                return T;
+            }
+
+            if(Deadline != 0 && Now >= Deadline)
+                break;
+
+            //Wakes up on the next reset or to reevaluate the aging.
+            int64_t WakeUp = Now + AGING_TIME;
+            if(Now < m_GlobalReset)
+                WakeUp = std::min(WakeUp, m_GlobalReset);
+            else if(!Global)
+                WakeUp = std::min(WakeUp, GlobalFree);
+            else if(!Ready && Bucket.ResetAt > Now)
+                WakeUp = std::min(WakeUp, Bucket.ResetAt);
+
+            if(Deadline != 0)
+                WakeUp = std::min(WakeUp, Deadline);
+
+            m_Cond.wait_for(lock, std::chrono::milliseconds(std::max<int64_t>(WakeUp - Now, 1)));
+        }
+
+        auto &Queue = Bucket.Queues[(size_t)Priority];
+        Queue.erase(std::remove(Queue.begin(), Queue.end(), T), Queue.end());
+        m_Stats.Priorities[(size_t)Priority].Queued--;
+        m_Cond.notify_all();
+
+        return nullptr;
+    }
+
+    CRequestScheduler::Ticket CRequestScheduler::TryAcquire(const std::string &Route, RequestPriority Priority)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        int64_t Now = GetTimeMillis();
+
+        Ticket T = Ticket(new STicket());
+        T->Bucket = GetBucketKey(Route, Now);
+        T->Route = Route;
+        T->Priority = Priority;
+        T->Queued = Now;
+
+        int64_t GlobalFree = 0;
+        SBucket &Bucket = m_Buckets[T->Bucket];
+        if(Now < m_GlobalReset || !HasGlobalCapacity(Now, GlobalFree) || !HasCapacity(Bucket, Now) || PickNext(Bucket, Now))
+            return nullptr;
+
+        m_Stats.Priorities[(size_t)Priority].Queued++;
+        Grant(Bucket, T, Now);
+        return T;
+    }
+
+    void CRequestScheduler::Release(Ticket T, ix::HttpResponsePtr res)
+    {
+        if(!T)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        int64_t Now = GetTimeMillis();
+
+        SBucket &Bucket = m_Buckets[T->Bucket];
+        Bucket.InFlight--;
+
+        if(res)
+        {
+            UpdateBucket(Bucket, res, Now);
+
+            //Following requests of this route use the bucket discord has assigned.
+            auto IT = res->headers.find("X-RateLimit-Bucket");
+            if(IT != res->headers.end())
+            {
+                std::string Template, Major;
+                SplitMajor(T->Route, Template, Major);
+
+                std::string Key = IT->second + ":" + Major;
+                SHash &Hash = m_Hashes[Template];
+                Hash.Hash = IT->second;
+                Hash.LastUsed = Now;
+
+                if(Key != T->Bucket)
+                {
+                    SBucket &Shared = m_Buckets[Key];
+                    Shared.LastUsed = Now;
+                    UpdateBucket(Shared, res, Now);
+                }
+            }
+
+            //Global rate limit hit.
+            if(res->statusCode == 429 && res->headers.find("X-RateLimit-Global") != res->headers.end())
+            {
+                double RetryAfter = 1;
+                GetHeader(res, "Retry-After", RetryAfter);
+                m_GlobalReset = std::max<int64_t>(m_GlobalReset, Now + (int64_t)(RetryAfter * 1000));
+            }
+        }
+
+        auto &Stats = m_Stats.Priorities[(size_t)T->Priority];
+        uint64_t Latency = (uint64_t)(Now - T->Queued);
+        Stats.Requests++;
+        Stats.TotalLatency += Latency;
+        Stats.MaxLatency = std::max(Stats.MaxLatency, Latency);
+
+        if(Now - m_LastSweep >= SWEEP_INTERVAL)
+            Sweep(Now);
+
+        m_Cond.notify_all();
+    }
+
+    SRESTStatistics CRequestScheduler::GetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Stats;
+    }
+
+    //--------------------------Private--------------------------//
+
+    std::string CRequestScheduler::GetBucketKey(const std::string &Route, int64_t Now)
+    {
+        std::string Template, Major;
+        SplitMajor(Route, Template, Major);
+
+        auto IT = m_Hashes.find(Template);
+        if(IT == m_Hashes.end())
+            return Template + ":" + Major;
+
+        IT->second.LastUsed = Now;
+        return IT->second.Hash + ":" + Major;
+    }
+
+    bool CRequestScheduler::HasGlobalCapacity(int64_t Now, int64_t &WakeUp)
+    {
+        while (!m_GlobalSent.empty() && m_GlobalSent.front() + GLOBAL_WINDOW <= Now)
+            m_GlobalSent.pop_front();
+
+        if(m_GlobalSent.size() < GLOBAL_LIMIT)
+            return true;
+
+        WakeUp = m_GlobalSent.front() + GLOBAL_WINDOW;
+        return false;
+    }
+
+    void CRequestScheduler::Sweep(int64_t Now)
+    {
+        m_LastSweep = Now;
+
+        for (auto IT = m_Buckets.begin(); IT != m_Buckets.end();)
+        {
+            SBucket &Bucket = IT->second;
+
+            //Waiting requests hold a reference to their bucket.
+            bool Queued = std::any_of(std::begin(Bucket.Queues), std::end(Bucket.Queues), [](const std::deque<Ticket> &Queue) { return !Queue.empty(); });
+            if(!Queued && Bucket.InFlight == 0 && Bucket.ResetAt <= Now && Now - Bucket.LastUsed >= IDLE_TIME)
+                IT = m_Buckets.erase(IT);
+            else
+                IT++;
+        }
+
+        for (auto IT = m_Hashes.begin(); IT != m_Hashes.end();)
+        {
+            if(Now - IT->second.LastUsed >= IDLE_TIME)
+                IT = m_Hashes.erase(IT);
+            else
+                IT++;
+        }
+    }
+
+    bool CRequestScheduler::HasCapacity(SBucket &Bucket, int64_t Now)
+    {
+        if(Bucket.Unlimited)
+            return true;
+
+        //The window is over, so the bucket is full again.
+        if(Bucket.ResetAt != 0 && Now >= Bucket.ResetAt)
+        {
+            Bucket.Remaining = Bucket.Limit;
+            Bucket.ResetAt = 0;
+        }
+
+        //Until discord tells the limit, only one request per bucket is sent.
+        if(Bucket.ResetAt == 0 && Bucket.Remaining <= 0)
+            return Bucket.InFlight == 0;
+
+        return Bucket.Remaining > 0;
+    }
+
+    CRequestScheduler::Ticket CRequestScheduler::PickNext(SBucket &Bucket, int64_t Now)
+    {
+        Ticket Ret;
+        int64_t Best = 0;
+
+        for (auto &&Queue : Bucket.Queues)
+        {
+            if(Queue.empty())
+                continue;
+
+            //Only the front of each queue is relevant, since it is the oldest ticket of the class.
+            Ticket T = Queue.front();
+            int64_t Effective = std::max<int64_t>(0, (int64_t)T->Priority - (Now - T->Queued) / AGING_TIME);
+
+            if(!Ret || Effective < Best || (Effective == Best && T->Queued < Ret->Queued))
+            {
+                Ret = T;
+                Best = Effective;
+            }
+        }
+
+        return Ret;
+    }
+
+    void CRequestScheduler::Grant(SBucket &Bucket, Ticket T, int64_t Now)
+    {
+        auto &Queue = Bucket.Queues[(size_t)T->Priority];
+        if(!Queue.empty() && Queue.front() == T)
+            Queue.pop_front();
+
+        if(!Bucket.Unlimited)
+            Bucket.Remaining--;
+
+        Bucket.InFlight++;
+        Bucket.LastUsed = Now;
+        m_GlobalSent.push_back(Now);
+
+        auto &Stats = m_Stats.Priorities[(size_t)T->Priority];
+        uint64_t Wait = (uint64_t)(Now - T->Queued);
+        Stats.Queued--;
+        Stats.TotalWait += Wait;
+        Stats.MaxWait = std::max(Stats.MaxWait, Wait);
+    }
+
+    void CRequestScheduler::UpdateBucket(SBucket &Bucket, ix::HttpResponsePtr res, int64_t Now)
+    {
+        double Limit, Remaining, ResetAfter;
+        bool HasLimit = GetHeader(res, "X-RateLimit-Limit", Limit);
+        bool HasRemaining = GetHeader(res, "X-RateLimit-Remaining", Remaining);
+        bool HasReset = GetHeader(res, "X-RateLimit-Reset-After", ResetAfter);
+
+        if(res->statusCode == 429)
+        {
+            double RetryAfter = 1;
+            if(!GetHeader(res, "Retry-After", RetryAfter) && HasReset)
+                RetryAfter = ResetAfter;
+
+            Bucket.Unlimited = false;
+            Bucket.Remaining = 0;
+            Bucket.ResetAt = std::max<int64_t>(Bucket.ResetAt, Now + (int64_t)(RetryAfter * 1000));
+            return;
+        }
+
+        if(!HasLimit || !HasRemaining || !HasReset)
+        {
+            //Only a successful answer proves that the route isn't limited.
+            if(res->errorCode == ix::HttpErrorCode::Ok && res->statusCode < 500)
+                Bucket.Unlimited = true;
+            else if(Bucket.ResetAt == 0)
+                Bucket.Remaining = std::max(Bucket.Remaining, 1);
+
+            return;
+        }
+
+        int64_t ResetAt = Now + (int64_t)(ResetAfter * 1000);
+        Bucket.Unlimited = false;
+        Bucket.Limit = std::max(1, (int)Limit);
+
+        //Responses can arrive out of order, so the lower budget wins within the same window.
+        if(Bucket.ResetAt == 0 || ResetAt > Bucket.ResetAt + 50)
+            Bucket.Remaining = (int)Remaining;
+        else
+            Bucket.Remaining = std::min(Bucket.Remaining, (int)Remaining);
+
+        Bucket.ResetAt = std::max(Bucket.ResetAt, ResetAt);
+    }
+} // namespace DiscordBot
@@ -0,0 +1,159 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef REQUESTSCHEDULER_HPP
+#define REQUESTSCHEDULER_HPP
+
+#include <ixwebsocket/IXHttp.h>
+#include <models/RequestPriority.hpp>
+#include <models/RESTStatistics.hpp>
+#include <string>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Keeps track of the discord rate limit buckets and hands out send slots. Within a bucket higher priority classes are served first.
+     */
+    class CRequestScheduler
+    {
+        public:
+            struct STicket
+            {
+                std::string Bucket;
+                std::string Route;
+                RequestPriority Priority;
+                int64_t Queued;
+            };
+
+            using Ticket = std::shared_ptr<STicket>;
+
+            CRequestScheduler() = default;
+
+            /**
+             * @brief Waits until the request is allowed to be sent.
+             * 
+             * @param Route: Route of the request. @see CRESTClient::GetRoute
+             * @param Priority: Priority class of the request.
+             * @param Deadline: Absolute time in milliseconds after which the wait is aborted. 0 waits forever.
+             * 
+             * @return Returns a ticket which must be passed to Release after the response arrives or null if the deadline is reached.
+             */
+            Ticket Acquire(const std::string &Route, RequestPriority Priority, int64_t Deadline);
+
+            /**
+             * @return Returns a ticket if the request can be sent immediately, without overtaking queued requests. Otherwise null.
+             */
+            Ticket TryAcquire(const std::string &Route, RequestPriority Priority);
+
+            /**
+             * @brief Frees the slot of the ticket and updates the bucket with the rate limit headers of the response.
+             */
+            void Release(Ticket T, ix::HttpResponsePtr res);
+
+            SRESTStatistics GetStatistics();
+
+            /**
+             * @return Returns the priority of the current CRequestPriorityScope or Default, if no scope is active.
+             */
+            static RequestPriority ResolvePriority(RequestPriority Default);
+
+            /**
+             * @brief Splits a route into the major parameter and the route without it. E.g. "GET /channels/1234/messages" -> "1234", "GET /channels/:major/messages"
+             */
+            static void SplitMajor(const std::string &Route, std::string &Template, std::string &Major);
+
+            ~CRequestScheduler() {}
+
+        private:
+            static const int64_t AGING_TIME = 2000;     //!< A queued request is promoted by one priority class after this many milliseconds.
+            static const size_t GLOBAL_LIMIT = 50;      //!< Requests per GLOBAL_WINDOW discord allows for a bot.
+            static const int64_t GLOBAL_WINDOW = 1000;
+            static const int64_t IDLE_TIME = 300000;    //!< Buckets and bucket hashes which weren't used for this many milliseconds are removed.
+            static const int64_t SWEEP_INTERVAL = 60000;
+
+            struct SBucket
+            {
+                SBucket() : Limit(1), Remaining(1), ResetAt(0), InFlight(0), Unlimited(false), LastUsed(0) {}
+
+                int Limit;
+                int Remaining;
+                int64_t ResetAt;
+                int InFlight;
+                bool Unlimited;     //!< Discord sent no rate limit headers for this bucket.
+                int64_t LastUsed;
+                std::deque<Ticket> Queues[(size_t)RequestPriority::COUNT];
+            };
+
+            struct SHash
+            {
+                SHash() : LastUsed(0) {}
+
+                std::string Hash;
+                int64_t LastUsed;
+            };
+
+            /**
+             * @return Returns the discord bucket hash and the major parameter or the route template and the major parameter, if the hash is unknown. E.g. "abcd:1234" or "GET /channels/:major/messages:1234"
+             */
+            std::string GetBucketKey(const std::string &Route, int64_t Now);
+            bool HasCapacity(SBucket &Bucket, int64_t Now);
+
+            /**
+             * @return Returns true if the global limit allows another request. Otherwise WakeUp is set to the time the next slot becomes free.
+             */
+            bool HasGlobalCapacity(int64_t Now, int64_t &WakeUp);
+
+            /**
+             * @brief Removes idle buckets and hashes, so ids of deleted channels and guilds don't stay forever.
+             */
+            void Sweep(int64_t Now);
+
+            /**
+             * @return Returns the next ticket to serve. Older tickets are aged into higher classes, so background requests can't starve.
+             */
+            Ticket PickNext(SBucket &Bucket, int64_t Now);
+
+            void Grant(SBucket &Bucket, Ticket T, int64_t Now);
+            void UpdateBucket(SBucket &Bucket, ix::HttpResponsePtr res, int64_t Now);
+
+            std::mutex m_Lock;
+            std::condition_variable m_Cond;
+
+            std::map<std::string, SHash> m_Hashes;     //!< Route without major parameter -> Discord bucket hash.
+            std::map<std::string, SBucket> m_Buckets;
+            int64_t m_GlobalReset = 0;
+            int64_t m_LastSweep = 0;
+            std::deque<int64_t> m_GlobalSent;           //!< Send times of the requests within the last GLOBAL_WINDOW.
+
+            SRESTStatistics m_Stats;
+    };
+} // namespace DiscordBot
+
+
+#endif //REQUESTSCHEDULER_HPP
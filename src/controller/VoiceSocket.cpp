@@ -517,7 +517,7 @@ namespace DiscordBot
                         }
 
                         CJSON id;
-                        id.AddPair("server_id", m_GuildID);
+                        id.AddPair("server_id", m_GuildID.str());
                         id.AddPair("session_id", m_SessionID);
                         id.AddPair("token", m_Token);
 
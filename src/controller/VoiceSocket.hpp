@@ -32,10 +32,11 @@
 #include <ixwebsocket/IXUdpSocket.h>
 #include <atomic>
 #include "MessageManager.hpp"
+#include <models/snowflake.hpp>
 
 namespace DiscordBot
 {    
-    using OnStopSpeaking = std::function<void(const std::string&)>;
+    using OnStopSpeaking = std::function<void(snowflake)>;
 
     /**
      * @brief Manages all voice events. Also encode and encrypts audio. 
@@ -124,7 +125,7 @@ namespace DiscordBot
 
             std::string m_Token;
             std::string m_ClientID;
-            std::string m_GuildID;
+            snowflake m_GuildID;
             ix::WebSocket m_Socket;
             ix::UdpSocket m_UDPSocket;
             std::thread m_Heartbeat;
@@ -26,8 +26,11 @@
 #define HELPER_HPP
 
 #include <stdint.h>
+#include <string.h>
+#include <ctype.h>
 #include <chrono>
 #include <algorithm>
+#include <string>
 
 namespace DiscordBot
 {
@@ -63,6 +66,181 @@ namespace DiscordBot
         return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     }
 
+    /**
+     * @brief Converts a ISO8601 timestamp (e.g. 2017-07-11T17:27:07.299000+00:00) to milliseconds since the unix epoch.
+     * 
+     * @return Returns 0 for empty or invalid timestamps.
+     */
+    inline int64_t ISO8601ToMillis(const std::string &Str)
+    {
+        auto ReadNum = [&Str](size_t Pos, size_t Len, int &Val)
+        {
+            if(Pos + Len > Str.size())
+                return false;
+
+            Val = 0;
+            for (size_t i = Pos; i < Pos + Len; i++)
+            {
+                if(Str[i] < '0' || Str[i] > '9')
+                    return false;
+
+                Val = Val * 10 + (Str[i] - '0');
+            }
+
+            return true;
+        };
+
+        int Year, Month, Day, Hour, Minute, Second;
+        if(!ReadNum(0, 4, Year) || !ReadNum(5, 2, Month) || !ReadNum(8, 2, Day) || !ReadNum(11, 2, Hour) || !ReadNum(14, 2, Minute) || !ReadNum(17, 2, Second))
+            return 0;
+
+        if(Month < 1 || Month > 12 || Day < 1 || Day > 31)
+            return 0;
+
+        //Days since the unix epoch, see http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+        int64_t Y = Year - (Month <= 2);
+        int64_t Era = (Y >= 0 ? Y : Y - 399) / 400;
+        int64_t YoE = Y - Era * 400;
+        int64_t DoY = (153 * (Month + (Month > 2 ? -3 : 9)) + 2) / 5 + Day - 1;
+        int64_t DoE = YoE * 365 + YoE / 4 - YoE / 100 + DoY;
+        int64_t Days = Era * 146097 + DoE - 719468;
+
+        int64_t Ret = ((Days * 24 + Hour) * 60 + Minute) * 60 + Second;
+        Ret *= 1000;
+
+        //Fraction of the second.
+        size_t Pos = 19;
+        if(Pos < Str.size() && Str[Pos] == '.')
+        {
+            int Scale = 100;
+            for (Pos++; Pos < Str.size() && Str[Pos] >= '0' && Str[Pos] <= '9'; Pos++)
+            {
+                Ret += (Str[Pos] - '0') * Scale;
+                Scale /= 10;
+            }
+        }
+
+        //Timezone offset.
+        if(Pos < Str.size() && (Str[Pos] == '+' || Str[Pos] == '-'))
+        {
+            int OffHour, OffMinute;
+            if(ReadNum(Pos + 1, 2, OffHour) && ReadNum(Pos + 4, 2, OffMinute))
+            {
+                int64_t Offset = (OffHour * 60 + OffMinute) * 60000LL;
+                Ret += Str[Pos] == '+' ? -Offset : Offset;
+            }
+        }
+
+        return Ret;
+    }
+
+    /**
+     * @brief 64-bit FNV-1a hash. Pass the result of a previous call as Hash to hash multiple strings.
+     */
+    inline uint64_t FNV1a(const std::string &Str, uint64_t Hash = 14695981039346656037ULL)
+    {
+        for (auto &&c : Str)
+        {
+            Hash ^= (uint8_t)c;
+            Hash *= 1099511628211ULL;
+        }
+
+        return Hash;
+    }
+
+    /**
+     * @brief Finds a string member of the outermost object of a json without parsing it. Nested objects, arrays and strings are skipped.
+     * 
+     * @return Returns the raw value or an empty string, if the member doesn't exist or isn't a string.
+     */
+    inline std::string FindTopLevelString(const std::string &Json, const char *Key)
+    {
+        size_t KeyLen = strlen(Key);
+        size_t Size = Json.size();
+        int Depth = 0;
+        bool ExpectKey = false;
+
+        //Returns the position of the closing quote.
+        auto SkipString = [&Json, Size](size_t Pos)
+        {
+            for (; Pos < Size && Json[Pos] != '"'; Pos++)
+            {
+                if(Json[Pos] == '\\')
+                    Pos++;
+            }
+
+            return Pos;
+        };
+
+        auto SkipSpace = [&Json, Size](size_t Pos)
+        {
+            while (Pos < Size && isspace((unsigned char)Json[Pos]))
+                Pos++;
+
+            return Pos;
+        };
+
+        for (size_t i = 0; i < Size; i++)
+        {
+            switch (Json[i])
+            {
+                case '"':
+                {
+                    size_t Beg = i + 1;
+                    i = SkipString(Beg);
+                    if(i >= Size)
+                        return "";
+
+                    if(Depth != 1 || !ExpectKey)
+                        break;
+
+                    ExpectKey = false;
+                    if(i - Beg != KeyLen || Json.compare(Beg, KeyLen, Key) != 0)
+                        break;
+
+                    size_t Pos = SkipSpace(i + 1);
+                    if(Pos >= Size || Json[Pos] != ':')
+                        return "";
+
+                    Pos = SkipSpace(Pos + 1);
+                    if(Pos >= Size || Json[Pos] != '"')
+                        return "";
+
+                    size_t End = SkipString(Pos + 1);
+                    if(End >= Size)
+                        return "";
+
+                    return Json.substr(Pos + 1, End - Pos - 1);
+                }
+
+                case '{':
+                {
+                    Depth++;
+                    ExpectKey = Depth == 1;
+                }break;
+
+                case '[':
+                {
+                    Depth++;
+                }break;
+
+                case '}':
+                case ']':
+                {
+                    if(--Depth <= 0)
+                        return "";
+                }break;
+
+                case ',':
+                {
+                    ExpectKey = Depth == 1;
+                }break;
+            }
+        }
+
+        return "";
+    }
+
     inline bool IsLittleEndian()
     {
         short t = 1;
@@ -27,7 +27,11 @@
 
 #include <models/Embed.hpp>
 #include <models/User.hpp>
+#include <models/Webhook.hpp>
 #include <models/atomic.hpp>
+#include <models/weak_registry.hpp>
+#include <models/snowflake.hpp>
+#include "Helper.hpp"
 #include <map>
 #include <JSON.hpp>
 #include <string>
@@ -42,7 +46,7 @@ namespace DiscordBot
     typename std::result_of<FN&(T)>::type operator|(const T &obj, FN f);
 
     template<class T>
-    T operator|(atomic<std::map<std::string, T>> &map, const std::string &js);
+    std::shared_ptr<T> operator|(weak_registry<snowflake, T> &map, const std::string &js);
 
     template<class JSType, class T>
     T& operator>>(const JSType &js, T &obj);
@@ -51,10 +55,10 @@ namespace DiscordBot
     std::string& operator>>(const T &obj, std::string &js);
 
     template<class T>
-    atomic<std::map<std::string, T>>& operator>>(const T &obj, atomic<std::map<std::string, T>> &map);
+    weak_registry<snowflake, T>& operator>>(const std::shared_ptr<T> &obj, weak_registry<snowflake, T> &map);
 
     template<class T>
-    std::pair<std::string, atomic<std::map<std::string, T>>&> operator&(const std::string &js, atomic<std::map<std::string, T>> &map);
+    std::pair<std::string, weak_registry<snowflake, T>&> operator&(const std::string &js, weak_registry<snowflake, T> &map);
 
     //--------------------------JSON Parsing--------------------------//
 
@@ -64,9 +68,9 @@ namespace DiscordBot
         CJSON json;
         json.ParseObject(JS);
 
-        User Ret = User(new CUser());
+        auto Ret = std::make_shared<CUser>();
 
-        Ret->ID = json.GetValue<std::string>("id");
+        Ret->ID = snowflake(json.GetValue<std::string>("id"));
         Ret->Username = json.GetValue<std::string>("username");
         Ret->Discriminator = json.GetValue<std::string>("discriminator");
         Ret->Avatar = json.GetValue<std::string>("avatar");
@@ -80,11 +84,6 @@ namespace DiscordBot
         Ret->PremiumType = (PremiumTypes)json.GetValue<int>("premium_type");
         Ret->PublicFlags = (UserFlags)json.GetValue<int>("public_flags");
 
-        Ret->State = OnlineState::ONLINE;
-        Ret->Desktop = OnlineState::ONLINE;
-        Ret->Mobile = OnlineState::OFFLINE;
-        Ret->Web = OnlineState::ONLINE;
-
         // m_Users[Ret->ID] = Ret;
 
         return Ret;
@@ -96,9 +95,9 @@ namespace DiscordBot
         CJSON json;
         json.ParseObject(JS);
 
-        Role ret = Role(new CRole());
+        auto ret = std::make_shared<CRole>();
 
-        ret->ID = json.GetValue<std::string>("id");
+        ret->ID = snowflake(json.GetValue<std::string>("id"));
         ret->Name = json.GetValue<std::string>("name");
         ret->Color = json.GetValue<uint32_t>("color");
         ret->Hoist = json.GetValue<bool>("hoist");
@@ -111,37 +110,37 @@ namespace DiscordBot
     }
 
     template<class T>
-    typename std::enable_if<std::is_same<T, Channel>::value, Channel>::type Deserialize(std::pair<std::string, atomic<std::map<std::string, User>>&> js)
+    typename std::enable_if<std::is_same<T, Channel>::value, Channel>::type Deserialize(std::pair<std::string, weak_registry<snowflake, const CUser>&> js)
     {
-        Channel Ret = Channel(new CChannel());
+        auto Ret = std::make_shared<CChannel>();
 
         CJSON json;
         json.ParseObject(js.first);
 
-        Ret->ID = json.GetValue<std::string>("id");
+        Ret->ID = snowflake(json.GetValue<std::string>("id"));
         Ret->Type = (ChannelTypes)json.GetValue<int>("type");
-        Ret->GuildID = json.GetValue<std::string>("guild_id");
+        Ret->GuildID = snowflake(json.GetValue<std::string>("guild_id"));
         Ret->Position = json.GetValue<int>("position");
 
         std::vector<std::string> Array = json.GetValue<std::vector<std::string>>("permission_overwrites");
         for (auto &&e : Array)
         {
-            PermissionOverwrites ov = PermissionOverwrites(new CPermissionOverwrites());
+            auto ov = std::make_shared<CPermissionOverwrites>();
             CJSON jov;
             jov.ParseObject(e);
 
-            ov->ID = jov.GetValue<std::string>("id");
+            ov->ID = snowflake(jov.GetValue<std::string>("id"));
             ov->Type = jov.GetValue<std::string>("type");
             ov->Allow = (Permission)jov.GetValue<int>("allow");
             ov->Deny = (Permission)jov.GetValue<int>("deny");
 
-            Ret->Overwrites->push_back(ov);
+            Ret->Overwrites.push_back(ov);
         }
 
         Ret->Name = json.GetValue<std::string>("name");
         Ret->Topic = json.GetValue<std::string>("topic");
         Ret->NSFW = json.GetValue<bool>("nsfw");
-        Ret->LastMessageID = json.GetValue<std::string>("last_message_id");
+        Ret->LastMessageID = snowflake(json.GetValue<std::string>("last_message_id"));
         Ret->Bitrate = json.GetValue<int>("bitrate");
         Ret->UserLimit = json.GetValue<int>("user_limit");
         Ret->RateLimit = json.GetValue<int>("rate_limit_per_user");
@@ -150,14 +149,32 @@ namespace DiscordBot
         for (auto &&e : Array)
         {
             User user = js.second | e;
-            Ret->Recipients->push_back(user);
+            Ret->Recipients.push_back(user);
         }
 
         Ret->Icon = json.GetValue<std::string>("icon");
-        Ret->OwnerID = json.GetValue<std::string>("owner_id");
-        Ret->AppID = json.GetValue<std::string>("application_id");
-        Ret->ParentID = json.GetValue<std::string>("parent_id");
-        Ret->LastPinTimestamp = json.GetValue<std::string>("last_pin_timestamp");
+        Ret->OwnerID = snowflake(json.GetValue<std::string>("owner_id"));
+        Ret->AppID = snowflake(json.GetValue<std::string>("application_id"));
+        Ret->ParentID = snowflake(json.GetValue<std::string>("parent_id"));
+        Ret->LastPinTimestamp = ISO8601ToMillis(json.GetValue<std::string>("last_pin_timestamp"));
+
+        return Ret;
+    }
+
+    template<class T>
+    typename std::enable_if<std::is_same<T, Webhook>::value, Webhook>::type Deserialize(const std::string &JS)
+    {
+        CJSON json;
+        json.ParseObject(JS);
+
+        auto Ret = std::make_shared<CWebhook>();
+
+        Ret->ID = snowflake(json.GetValue<std::string>("id"));
+        Ret->Token = json.GetValue<std::string>("token");
+        Ret->ChannelID = snowflake(json.GetValue<std::string>("channel_id"));
+        Ret->GuildID = snowflake(json.GetValue<std::string>("guild_id"));
+        Ret->Name = json.GetValue<std::string>("name");
+        Ret->Avatar = json.GetValue<std::string>("avatar");
 
         return Ret;
     }
@@ -166,14 +183,14 @@ namespace DiscordBot
     {
         CJSON js;
 
-        js.AddPair("title", e->Title.load());
-        js.AddPair("description", e->Description.load());
+        js.AddPair("title", e->Title);
+        js.AddPair("description", e->Description);
 
-        if(!e->URL->empty())
-            js.AddPair("url", e->URL.load());
+        if(!e->URL.empty())
+            js.AddPair("url", e->URL);
 
-        if(!e->Type->empty())
-            js.AddPair("type", e->Type.load());
+        if(!e->Type.empty())
+            js.AddPair("type", e->Type);
 
         return js.Serialize();
     }
@@ -190,25 +207,23 @@ namespace DiscordBot
     }
 
     /**
-     * @brief Gets or creates a object and adds the new object to the map. (e.g.: m_Users | json)
+     * @brief Gets or creates a object and adds the new object to the registry. (e.g.: m_Users | json)
      * 
      * @return Returns the json object as c++ object.
      */
     template<class T>
-    inline T operator|(atomic<std::map<std::string, T>> &map, const std::string &js)
+    inline std::shared_ptr<T> operator|(weak_registry<snowflake, T> &map, const std::string &js)
     {
         CJSON json;
         json.ParseObject(js);
 
-        T Ret;
-
-        auto IT = map->find(json.GetValue<std::string>("id"));
-        if(IT != map->end())
-            Ret = IT->second;
-        else 
+        std::shared_ptr<T> Ret = map.get(snowflake(json.GetValue<std::string>("id")));
+        if(!Ret)
         {
-            Ret = Deserialize<T>(js);
-            map->insert({Ret->ID, Ret});
+            Ret = Deserialize<std::shared_ptr<T>>(js);
+
+            //Returns the object of another thread, if it was faster.
+            Ret = map.insert(Ret->ID, Ret);
         } 
 
         return Ret;
@@ -235,12 +250,12 @@ namespace DiscordBot
     }
 
     /**
-     * @brief Inserts a object to a map.
+     * @brief Inserts a object to a registry.
      */
     template<class T>
-    inline atomic<std::map<std::string, T>>& operator>>(const T &obj, atomic<std::map<std::string, T>> &map)
+    inline weak_registry<snowflake, T>& operator>>(const std::shared_ptr<T> &obj, weak_registry<snowflake, T> &map)
     {
-        map->insert({obj->ID, obj});
+        map.insert(obj->ID, obj);
         return map;
     }
 
@@ -248,7 +263,7 @@ namespace DiscordBot
      * @brief Combines a json string and a map to a pair.
      */
     template<class T>
-    inline std::pair<std::string, atomic<std::map<std::string, T>>&> operator&(const std::string &js, atomic<std::map<std::string, T>> &map)
+    inline std::pair<std::string, weak_registry<snowflake, T>&> operator&(const std::string &js, weak_registry<snowflake, T> &map)
     {
         return {js, map};
     }
@@ -0,0 +1,372 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef JSONREADER_HPP
+#define JSONREADER_HPP
+
+#include <stdint.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+
+namespace DiscordBot
+{
+    /**
+     * @brief Forward only reader of a json. Reads values directly into the caller's variables, so large lists are parsed once without building intermediate strings.
+     * 
+     * A failed read sets Failed() and all further reads return false.
+     */
+    class CJSONReader
+    {
+        public:
+            /**
+             * @param Json: Must outlive the reader, it isn't copied.
+             */
+            explicit CJSONReader(const std::string &Json) : m_Json(Json), m_Pos(0), m_Failed(false) {}
+            CJSONReader(std::string &&) = delete;
+
+            /**
+             * @return Returns false if the next value isn't an array.
+             */
+            inline bool BeginArray()
+            {
+                return Begin('[');
+            }
+
+            /**
+             * @return Returns false if the next value isn't an object.
+             */
+            inline bool BeginObject()
+            {
+                return Begin('{');
+            }
+
+            /**
+             * @brief Moves to the next element of the current array.
+             * 
+             * @return Returns false at the end of the array.
+             */
+            inline bool NextElement()
+            {
+                return Next(']');
+            }
+
+            /**
+             * @brief Moves to the next member of the current object. The value must be read or skipped before the next call.
+             * 
+             * @return Returns false at the end of the object.
+             */
+            inline bool NextKey(std::string &Key)
+            {
+                if(!Next('}'))
+                    return false;
+
+                if(!ReadString(Key))
+                    return false;
+
+                SkipSpace();
+                return Expect(':');
+            }
+
+            /**
+             * @brief Reads a string and resolves its escape sequences. Null is read as empty string.
+             */
+            inline bool ReadString(std::string &Out)
+            {
+                Out.clear();
+                if(ReadNull())
+                    return true;
+
+                if(!Expect('"'))
+                    return false;
+
+                while (m_Pos < m_Json.size())
+                {
+                    char c = m_Json[m_Pos++];
+                    if(c == '"')
+                        return true;
+
+                    if(c != '\\')
+                    {
+                        Out += c;
+                        continue;
+                    }
+
+                    if(m_Pos >= m_Json.size())
+                        break;
+
+                    switch (m_Json[m_Pos++])
+                    {
+                        case '"': Out += '"'; break;
+                        case '\\': Out += '\\'; break;
+                        case '/': Out += '/'; break;
+                        case 'b': Out += '\b'; break;
+                        case 'f': Out += '\f'; break;
+                        case 'n': Out += '\n'; break;
+                        case 'r': Out += '\r'; break;
+                        case 't': Out += '\t'; break;
+                        case 'u':
+                        {
+                            uint32_t CodePoint;
+                            if(!ReadCodePoint(CodePoint))
+                                return Fail();
+
+                            AppendUTF8(Out, CodePoint);
+                        }break;
+
+                        default:
+                            return Fail();
+                    }
+                }
+
+                return Fail();
+            }
+
+            /**
+             * @brief Reads a bool. Null is read as false.
+             */
+            inline bool ReadBool(bool &Out)
+            {
+                Out = false;
+                if(ReadNull())
+                    return true;
+
+                if(ReadLiteral("true"))
+                {
+                    Out = true;
+                    return true;
+                }
+
+                return ReadLiteral("false") || Fail();
+            }
+
+            /**
+             * @brief Skips the next value including all nested values.
+             */
+            inline bool Skip()
+            {
+                SkipSpace();
+                if(m_Failed || m_Pos >= m_Json.size())
+                    return Fail();
+
+                char c = m_Json[m_Pos];
+                if(c == '"')
+                {
+                    std::string Tmp;
+                    return ReadString(Tmp);
+                }
+
+                if(c == '[' || c == '{')
+                {
+                    int Depth = 0;
+                    while (m_Pos < m_Json.size())
+                    {
+                        c = m_Json[m_Pos];
+                        if(c == '"')
+                        {
+                            std::string Tmp;
+                            if(!ReadString(Tmp))
+                                return false;
+
+                            continue;
+                        }
+
+                        m_Pos++;
+                        if(c == '[' || c == '{')
+                            Depth++;
+                        else if((c == ']' || c == '}') && --Depth == 0)
+                            return true;
+                    }
+
+                    return Fail();
+                }
+
+                //Numbers and literals.
+                size_t Beg = m_Pos;
+                while (m_Pos < m_Json.size() && m_Json[m_Pos] != ',' && m_Json[m_Pos] != ']' && m_Json[m_Pos] != '}' && !isspace((unsigned char)m_Json[m_Pos]))
+                    m_Pos++;
+
+                return m_Pos != Beg || Fail();
+            }
+
+            inline bool Failed() const
+            {
+                return m_Failed;
+            }
+
+            ~CJSONReader() {}
+
+        private:
+            inline bool Begin(char c)
+            {
+                SkipSpace();
+                if(!Expect(c))
+                    return false;
+
+                m_First.push_back(true);
+                return true;
+            }
+
+            inline bool Next(char End)
+            {
+                SkipSpace();
+                if(m_Failed || m_First.empty() || m_Pos >= m_Json.size())
+                    return Fail();
+
+                if(m_Json[m_Pos] == End)
+                {
+                    m_Pos++;
+                    m_First.pop_back();
+                    return false;
+                }
+
+                if(!m_First.back())
+                {
+                    if(!Expect(','))
+                        return false;
+
+                    SkipSpace();
+                }
+
+                m_First.back() = false;
+                return true;
+            }
+
+            inline bool ReadCodePoint(uint32_t &CodePoint)
+            {
+                if(!ReadHex(CodePoint))
+                    return false;
+
+                //Characters outside of the basic plane are sent as surrogate pair.
+                if(CodePoint >= 0xD800 && CodePoint <= 0xDBFF)
+                {
+                    uint32_t Low;
+                    if(m_Json.compare(m_Pos, 2, "\\u") != 0)
+                        return false;
+
+                    m_Pos += 2;
+                    if(!ReadHex(Low) || Low < 0xDC00 || Low > 0xDFFF)
+                        return false;
+
+                    CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+                }
+
+                return true;
+            }
+
+            inline bool ReadHex(uint32_t &Val)
+            {
+                if(m_Pos + 4 > m_Json.size())
+                    return false;
+
+                Val = 0;
+                for (size_t i = 0; i < 4; i++)
+                {
+                    char c = m_Json[m_Pos++];
+                    Val <<= 4;
+                    if(c >= '0' && c <= '9')
+                        Val |= c - '0';
+                    else if(c >= 'a' && c <= 'f')
+                        Val |= c - 'a' + 10;
+                    else if(c >= 'A' && c <= 'F')
+                        Val |= c - 'A' + 10;
+                    else
+                        return false;
+                }
+
+                return true;
+            }
+
+            static inline void AppendUTF8(std::string &Out, uint32_t CodePoint)
+            {
+                if(CodePoint < 0x80)
+                    Out += (char)CodePoint;
+                else if(CodePoint < 0x800)
+                {
+                    Out += (char)(0xC0 | (CodePoint >> 6));
+                    Out += (char)(0x80 | (CodePoint & 0x3F));
+                }
+                else if(CodePoint < 0x10000)
+                {
+                    Out += (char)(0xE0 | (CodePoint >> 12));
+                    Out += (char)(0x80 | ((CodePoint >> 6) & 0x3F));
+                    Out += (char)(0x80 | (CodePoint & 0x3F));
+                }
+                else
+                {
+                    Out += (char)(0xF0 | (CodePoint >> 18));
+                    Out += (char)(0x80 | ((CodePoint >> 12) & 0x3F));
+                    Out += (char)(0x80 | ((CodePoint >> 6) & 0x3F));
+                    Out += (char)(0x80 | (CodePoint & 0x3F));
+                }
+            }
+
+            inline bool ReadNull()
+            {
+                return ReadLiteral("null");
+            }
+
+            inline bool ReadLiteral(const char *Literal)
+            {
+                SkipSpace();
+                size_t Len = std::char_traits<char>::length(Literal);
+                if(m_Failed || m_Json.compare(m_Pos, Len, Literal) != 0)
+                    return false;
+
+                m_Pos += Len;
+                return true;
+            }
+
+            inline bool Expect(char c)
+            {
+                if(m_Failed || m_Pos >= m_Json.size() || m_Json[m_Pos] != c)
+                    return Fail();
+
+                m_Pos++;
+                return true;
+            }
+
+            inline void SkipSpace()
+            {
+                while (m_Pos < m_Json.size() && isspace((unsigned char)m_Json[m_Pos]))
+                    m_Pos++;
+            }
+
+            inline bool Fail()
+            {
+                m_Failed = true;
+                return false;
+            }
+
+            const std::string &m_Json;
+            size_t m_Pos;
+            bool m_Failed;
+            std::vector<bool> m_First;      //!< Per open array or object, true until the first element is read.
+    };
+} // namespace DiscordBot
+
+
+#endif //JSONREADER_HPP
@@ -0,0 +1,150 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021 Christian Tost
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef MEMORYUSAGE_HPP
+#define MEMORYUSAGE_HPP
+
+#include <stddef.h>
+#include <string>
+#include <models/User.hpp>
+#include <models/GuildMember.hpp>
+#include <models/VoiceState.hpp>
+#include <models/Role.hpp>
+#include <models/Channel.hpp>
+#include <models/Message.hpp>
+#include <models/Activity.hpp>
+#include <models/Presence.hpp>
+
+namespace DiscordBot
+{
+    /**
+     * @return Returns the heap buffer size of a string. Short strings are stored inside the object.
+     */
+    inline size_t HeapSize(const std::string &Str)
+    {
+        static const size_t SSO = std::string().capacity();
+        return Str.capacity() > SSO ? Str.capacity() + 1 : 0;
+    }
+
+    /**
+     * @return Returns the approximated heap usage of an activity and its sub objects.
+     */
+    inline size_t ApproxSize(const Activity &Act)
+    {
+        if(!Act)
+            return 0;
+
+        size_t Ret = sizeof(CActivity) + HeapSize(Act->Name) + HeapSize(Act->URL) + HeapSize(Act->AppID) + HeapSize(Act->Details) + HeapSize(Act->State);
+        if(Act->PartyObject)
+            Ret += sizeof(CParty) + HeapSize(Act->PartyObject->ID) + Act->PartyObject->Size.capacity() * sizeof(int);
+
+        if(Act->Secret)
+            Ret += sizeof(CSecrets) + HeapSize(Act->Secret->Join) + HeapSize(Act->Secret->Spectate) + HeapSize(Act->Secret->Match);
+
+        return Ret;
+    }
+
+    /**
+     * @return Returns the approximated heap usage of the activities of a presence.
+     */
+    inline size_t ApproxSize(const SPresence &Presence)
+    {
+        size_t Ret = Presence.Activities.capacity() * sizeof(Activity);
+        for (auto &&e : Presence.Activities)
+            Ret += ApproxSize(e);
+
+        return Ret;
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a user.
+     */
+    inline size_t ApproxSize(const User &Usr)
+    {
+        if(!Usr)
+            return 0;
+
+        return sizeof(CUser) + HeapSize(Usr->Username) + HeapSize(Usr->Discriminator) + HeapSize(Usr->Email);
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a voice state. The referenced objects are owned by other caches.
+     */
+    inline size_t ApproxSize(const VoiceState &State)
+    {
+        if(!State)
+            return 0;
+
+        return sizeof(CVoiceState) + HeapSize(State->SessionID);
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a member without the user and the voice state, which have their own caches.
+     */
+    inline size_t ApproxSize(const GuildMember &Member)
+    {
+        if(!Member)
+            return 0;
+
+        return sizeof(CGuildMember) + HeapSize(Member->Nick) + Member->Roles.capacity() * sizeof(snowflake);
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a role.
+     */
+    inline size_t ApproxSize(const Role &Value)
+    {
+        if(!Value)
+            return 0;
+
+        return sizeof(CRole) + HeapSize(Value->Name);
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a channel.
+     */
+    inline size_t ApproxSize(const Channel &Chan)
+    {
+        if(!Chan)
+            return 0;
+
+        return sizeof(CChannel) + HeapSize(Chan->Name) + HeapSize(Chan->Topic) + Chan->Overwrites.capacity() * (sizeof(PermissionOverwrites) + sizeof(CPermissionOverwrites)) + Chan->Recipients.capacity() * sizeof(User);
+    }
+
+    /**
+     * @return Returns the approximated heap usage of a message. The referenced objects are owned by other caches.
+     */
+    inline size_t ApproxSize(const Message &Msg)
+    {
+        if(!Msg)
+            return 0;
+
+        return sizeof(CMessage) + HeapSize(Msg->Content) + HeapSize(Msg->Timestamp) + HeapSize(Msg->EditedTimestamp) + 
+               Msg->Mentions.capacity() * sizeof(GuildMember) + Msg->RoleMentions.capacity() * sizeof(Role) + Msg->ChannelMentions.capacity() * sizeof(Channel);
+    }
+} // namespace DiscordBot
+
+
+#endif //MEMORYUSAGE_HPP